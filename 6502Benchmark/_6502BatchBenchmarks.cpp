@@ -0,0 +1,53 @@
+#include "benchmark/benchmark.h"
+#include "6502Batch.h"
+
+//1000 short jobs per iteration, each a straight run of 192 loads, EORs and stores over its own input
+static std::vector<m6502::BatchJob> MakeJobs() {
+    std::vector<m6502::BatchJob> jobs;
+    for (int i{0}; i < 1000; ++i) {
+        m6502::BatchJob job{};
+        std::vector<m6502::byte> program;
+        for (int j{0}; j < 64; ++j) {
+            program.insert(program.end(), {m6502::CPU::INS_LDA_ZP, 0x10, m6502::CPU::INS_EOR_ZPX, 0x11, m6502::CPU::INS_STA_ABS, 0x00, 0x02});
+        }
+        program.push_back(m6502::byte{m6502::CPU::INS_JAM});
+        job.image.push_back({0x8000, program});
+        job.image.push_back({0x0010, {static_cast<m6502::byte>(i), static_cast<m6502::byte>(i * 3)}});
+        job.start = 0x8000;
+        job.instructions = 1000;
+        job.resultAddress = 0x0200;
+        job.resultLength = 1;
+        jobs.push_back(job);
+    }
+    return jobs;
+}
+
+static void BatchRunner(benchmark::State& st) {
+    const auto jobs = MakeJobs();
+    m6502::BatchRunner runner{static_cast<unsigned>(st.range(0))};
+    uint64_t instructions{0};
+    for (auto _ : st) {
+        benchmark::DoNotOptimize(runner.run(jobs));
+        instructions += runner.getStats().instructions;
+    }
+    st.counters["instructions/s"] = benchmark::Counter(static_cast<double>(instructions), benchmark::Counter::kIsRate);
+    st.counters["jobs/s"] = benchmark::Counter(static_cast<double>(jobs.size() * st.iterations()), benchmark::Counter::kIsRate);
+}
+
+//the same with workers pinned per NUMA node, reporting where their pages ended up
+static void NumaBatchRunner(benchmark::State& st) {
+    const auto jobs = MakeJobs();
+    m6502::BatchRunner runner{static_cast<unsigned>(st.range(0)), true};
+    uint64_t instructions{0};
+    for (auto _ : st) {
+        benchmark::DoNotOptimize(runner.run(jobs));
+        instructions += runner.getStats().instructions;
+    }
+    st.counters["instructions/s"] = benchmark::Counter(static_cast<double>(instructions), benchmark::Counter::kIsRate);
+    st.counters["jobs/s"] = benchmark::Counter(static_cast<double>(jobs.size() * st.iterations()), benchmark::Counter::kIsRate);
+    st.counters["local_ratio"] = runner.getStats().localRatio();
+    st.counters["nodes"] = static_cast<double>(m6502::NumaTopology::detect().size());
+}
+
+BENCHMARK(BatchRunner)->RangeMultiplier(2)->Range(1, 16)->Unit(benchmark::TimeUnit::kMillisecond)->UseRealTime();
+BENCHMARK(NumaBatchRunner)->RangeMultiplier(2)->Range(1, 16)->Unit(benchmark::TimeUnit::kMillisecond)->UseRealTime();
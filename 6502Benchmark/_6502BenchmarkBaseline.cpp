@@ -0,0 +1,179 @@
+#include "_6502BenchmarkBaseline.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+baseline::Estimate baseline::estimate(std::vector<double> samples) {
+    if (samples.empty()) return {0, 0, 0};
+    std::sort(samples.begin(), samples.end());
+    const size_t n = samples.size();
+    const double median = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+    /*the median lies between the j-th smallest and the j-th largest sample with probability
+     * 1 - 2 * P(Binomial(n, 1/2) < j). Take the largest j that still gives at least 95%.*/
+    size_t j{0};
+    double tail{0}, term{std::pow(0.5, static_cast<double>(n))};
+    for (size_t k{0}; k < n / 2; ++k) {
+        if (2 * (tail + term) > 0.05) break;
+        tail += term;
+        term = term * static_cast<double>(n - k) / static_cast<double>(k + 1);
+        j = k + 1;
+    }
+    //too few samples for a 95% interval, fall back to the full range
+    if (j == 0) return {median, samples.front(), samples.back()};
+    return {median, samples[j - 1], samples[n - j]};
+}
+
+std::vector<baseline::Comparison> baseline::compare(const Results& before, const Results& after, double threshold) {
+    std::vector<Comparison> comparisons;
+    for (const auto& entry : after) {
+        auto old = before.find(entry.first);
+        if (old == before.end()) continue;
+        const Samples& b = old->second;
+        const Samples& a = entry.second;
+        {
+            Comparison c{entry.first, estimate(b.realTimeNs), estimate(a.realTimeNs), 0, false, false};
+            c.change = c.before.median > 0 ? c.after.median / c.before.median - 1 : 0;
+            c.regression = c.change > threshold && c.after.low > c.before.high;
+            comparisons.push_back(c);
+        }
+        if (!b.cyclesPerSecond.empty() && !a.cyclesPerSecond.empty()) {
+            Comparison c{entry.first, estimate(b.cyclesPerSecond), estimate(a.cyclesPerSecond), 0, true, false};
+            //fewer cycles/s is slower, keep positive meaning worse
+            c.change = c.after.median > 0 ? c.before.median / c.after.median - 1 : 0;
+            c.regression = c.change > threshold && c.after.high < c.before.low;
+            comparisons.push_back(c);
+        }
+    }
+    return comparisons;
+}
+
+static void writeString(std::ostream& out, const std::string& s) {
+    out << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') out << '\\';
+        out << c;
+    }
+    out << '"';
+}
+
+static void writeArray(std::ostream& out, const std::vector<double>& values) {
+    out << '[';
+    for (size_t i{0}; i < values.size(); ++i)
+        out << (i ? ", " : "") << values[i];
+    out << ']';
+}
+
+bool baseline::write(const Results& results, const std::string& path) {
+    std::ofstream out{path};
+    if (!out) return false;
+    out << std::setprecision(17);
+    out << "{\n  \"benchmarks\": [";
+    bool first{true};
+    for (const auto& entry : results) {
+        out << (first ? "\n" : ",\n") << "    {\"name\": ";
+        writeString(out, entry.first);
+        out << ", \"real_time_ns\": ";
+        writeArray(out, entry.second.realTimeNs);
+        out << ", \"cycles_per_second\": ";
+        writeArray(out, entry.second.cyclesPerSecond);
+        out << "}";
+        first = false;
+    }
+    out << "\n  ]\n}\n";
+    return static_cast<bool>(out);
+}
+
+namespace {
+    //just enough JSON to read back what baseline::write produces
+    struct Parser {
+        std::string text;
+        size_t pos{0};
+
+        void skipSpace() { while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) ++pos; }
+        bool consume(char c) {
+            skipSpace();
+            if (pos < text.size() && text[pos] == c) { ++pos; return true; }
+            return false;
+        }
+        bool string(std::string& s) {
+            if (!consume('"')) return false;
+            s.clear();
+            while (pos < text.size() && text[pos] != '"') {
+                if (text[pos] == '\\') ++pos;
+                if (pos < text.size()) s += text[pos++];
+            }
+            return consume('"');
+        }
+        bool number(double& d) {
+            skipSpace();
+            const char* start = text.c_str() + pos;
+            char* end{};
+            d = std::strtod(start, &end);
+            if (end == start) return false;
+            pos += end - start;
+            return true;
+        }
+        bool array(std::vector<double>& values) {
+            if (!consume('[')) return false;
+            values.clear();
+            if (consume(']')) return true;
+            do {
+                double d;
+                if (!number(d)) return false;
+                values.push_back(d);
+            } while (consume(','));
+            return consume(']');
+        }
+        bool benchmark(baseline::Results& results) {
+            if (!consume('{')) return false;
+            std::string key, name;
+            baseline::Samples samples;
+            do {
+                if (!string(key) || !consume(':')) return false;
+                bool ok = key == "name" ? string(name)
+                        : key == "real_time_ns" ? array(samples.realTimeNs)
+                        : key == "cycles_per_second" ? array(samples.cyclesPerSecond)
+                        : false;
+                if (!ok) return false;
+            } while (consume(','));
+            results[name] = samples;
+            return consume('}');
+        }
+        bool results(baseline::Results& results) {
+            std::string key;
+            if (!consume('{') || !string(key) || key != "benchmarks" || !consume(':') || !consume('[')) return false;
+            if (!consume(']')) {
+                do {
+                    if (!benchmark(results)) return false;
+                } while (consume(','));
+                if (!consume(']')) return false;
+            }
+            return consume('}');
+        }
+    };
+}
+
+bool baseline::read(Results& results, const std::string& path) {
+    std::ifstream in{path};
+    if (!in) return false;
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    Parser parser{buffer.str()};
+    results.clear();
+    return parser.results(results);
+}
+
+void baseline::Reporter::ReportRuns(const std::vector<Run>& reports) {
+    for (const Run& run : reports) {
+        if (run.run_type != Run::RT_Iteration || run.iterations == 0) continue;
+        Samples& samples = collected[run.benchmark_name()];
+        samples.realTimeNs.push_back(run.GetAdjustedRealTime() * 1e9 / benchmark::GetTimeUnitMultiplier(run.time_unit));
+        auto counter = run.counters.find("cycles/s");
+        if (counter != run.counters.end()) samples.cyclesPerSecond.push_back(counter->second.value);
+    }
+    ConsoleReporter::ReportRuns(reports);
+}
@@ -0,0 +1,50 @@
+#ifndef INC_6502_EMULATION_6502BENCHMARKBASELINE_H
+#define INC_6502_EMULATION_6502BENCHMARKBASELINE_H
+
+#include "benchmark/benchmark.h"
+#include <map>
+#include <string>
+#include <vector>
+
+/* Stores benchmark results as JSON in a baseline directory and compares new runs against
+ * them. Every benchmark keeps all of its repetitions so comparisons can look at the spread
+ * of the samples and not just a single mean. */
+namespace baseline {
+    //all the repetitions of one benchmark
+    struct Samples {
+        std::vector<double> realTimeNs;         //latency: wall time per iteration
+        std::vector<double> cyclesPerSecond;    //throughput: emulated cycles/s, empty if not reported
+    };
+    typedef std::map<std::string, Samples> Results;
+
+    struct Estimate {
+        double median, low, high;   //median and its 95% confidence interval
+    };
+    //distribution free confidence interval of the median from the order statistics
+    Estimate estimate(std::vector<double> samples);
+
+    struct Comparison {
+        std::string name;
+        Estimate before, after;
+        double change;      //relative change of the median, positive is slower
+        bool throughput;    //compares cycles/s instead of time
+        bool regression;
+    };
+    /* A benchmark regresses when its median moved by more than threshold in the bad direction
+     * and the confidence intervals of the two runs do not overlap, so noise alone does not fail. */
+    std::vector<Comparison> compare(const Results& before, const Results& after, double threshold);
+
+    bool write(const Results& results, const std::string& path);
+    bool read(Results& results, const std::string& path);
+
+    //console reporter that also keeps the samples of every repetition
+    class Reporter : public benchmark::ConsoleReporter {
+    public:
+        void ReportRuns(const std::vector<Run>& reports) override;
+        const Results& results() const { return collected; }
+    private:
+        Results collected;
+    };
+}
+
+#endif //INC_6502_EMULATION_6502BENCHMARKBASELINE_H
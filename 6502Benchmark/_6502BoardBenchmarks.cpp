@@ -0,0 +1,69 @@
+#include "benchmark/benchmark.h"
+#include "6502Board.h"
+#include <memory>
+#include <vector>
+
+//2 CPUs, each walking its own tables and storing into a page they share once a loop
+static constexpr size_t INSTANCES = 2;
+static constexpr uint64_t CYCLES = 200000;
+
+static std::vector<std::unique_ptr<m6502::CPU>> MakeCPUs(m6502::VirtualClock& clock) {
+    const m6502::byte program[] {
+            m6502::CPU::INS_LDA_ABSX, 0x00, 0x03,
+            m6502::CPU::INS_STA_ABSX, 0x00, 0x04,
+            m6502::CPU::INS_LDY_ABSX, 0x00, 0x05,
+            m6502::CPU::INS_STA_ABSY, 0x00, 0x06,
+            m6502::CPU::INS_LDX_ABSY, 0x00, 0x07,
+            m6502::CPU::INS_STA_ABSX, 0x00, 0x02,
+            m6502::CPU::INS_JMP_ABS, 0x00, 0x80};
+    std::vector<std::unique_ptr<m6502::CPU>> cpus;
+    for (size_t i{0}; i < INSTANCES; ++i) {
+        cpus.emplace_back(new m6502::CPU{clock});
+        m6502::CPU& cpu = *cpus.back();
+        for (size_t j{0}; j < sizeof program; ++j)
+            cpu.mem[0x8000 + j] = program[j];
+        for (m6502::dword j{0}; j < 0x100; ++j) {
+            cpu.mem[0x0300 + j] = static_cast<m6502::byte>(j * 7 + i);
+            cpu.mem[0x0500 + j] = static_cast<m6502::byte>(j * 13 + 1);
+            cpu.mem[0x0700 + j] = static_cast<m6502::byte>(j * 5 + 3 + i);
+        }
+        cpu.PC = 0x8000;
+    }
+    return cpus;
+}
+
+//both CPUs on this thread, one quantum each in turn, for comparison
+static void BoardSingleThread(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    auto cpus = MakeCPUs(clock);
+    m6502::SharedRam ram{0x0200, 0x100};
+    for (auto& cpu : cpus) cpu->mem.map(ram);
+    const auto quantum = static_cast<m6502::sdword>(st.range(0));
+    for (auto _ : st)
+        for (uint64_t done{0}; done < CYCLES; done += quantum)
+            for (auto& cpu : cpus)
+                cpu->execute(UINT64_MAX, quantum);
+    st.counters["cycles/s"] = benchmark::Counter(static_cast<double>(INSTANCES * CYCLES * st.iterations()), benchmark::Counter::kIsRate);
+}
+
+//the work is on the board's threads, so the rates are per wall clock second
+static void Board(benchmark::State& st, bool strict) {
+    m6502::VirtualClock clock;
+    auto cpus = MakeCPUs(clock);
+    m6502::Board board{static_cast<m6502::sdword>(st.range(0)), strict};
+    board.share(0x0200, 0x100);
+    for (auto& cpu : cpus) board.add(*cpu);
+    for (auto _ : st)
+        board.run(CYCLES);
+    const m6502::Board::Stats& stats = board.getStats();
+    st.counters["cycles/s"] = benchmark::Counter(static_cast<double>(INSTANCES * CYCLES * st.iterations()), benchmark::Counter::kIsRate);
+    st.counters["quanta"] = static_cast<double>(stats.quanta);
+    if (strict) st.counters["stalled"] = stats.sharedAccesses ? static_cast<double>(stats.stalledAccesses) / stats.sharedAccesses : 0;
+}
+
+static void BoardRelaxed(benchmark::State& st) { Board(st, false); }
+static void BoardStrict(benchmark::State& st) { Board(st, true); }
+
+BENCHMARK(BoardSingleThread)->Arg(1000)->Unit(benchmark::TimeUnit::kMillisecond);
+BENCHMARK(BoardRelaxed)->Arg(100)->Arg(1000)->Arg(10000)->UseRealTime()->Unit(benchmark::TimeUnit::kMillisecond);
+BENCHMARK(BoardStrict)->Arg(1000)->Arg(10000)->UseRealTime()->Unit(benchmark::TimeUnit::kMillisecond);
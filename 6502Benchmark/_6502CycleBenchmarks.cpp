@@ -0,0 +1,82 @@
+#include "benchmark/benchmark.h"
+#include "6502Cycle.h"
+
+//loop: LDA $1234; STA ($20),Y; JMP loop
+static void LoadProgram(m6502::CPU& cpu) {
+    const m6502::byte program[] {
+            m6502::CPU::INS_LDA_ABS, 0x34, 0x12,
+            m6502::CPU::INS_STA_INDY, 0x20,
+            m6502::CPU::INS_JMP_ABS, 0x00, 0x80};
+    for (size_t i{0}; i < sizeof program; ++i)
+        cpu.mem[0x8000 + i] = program[i];
+    cpu.mem[0x21] = 0x40;
+    cpu.PC = 0x8000;
+}
+
+//a chip that has to run every cycle, a raster counter say
+struct Raster {
+    uint64_t lines{0};
+    uint32_t column{0};
+    void tick() {
+        if (++column == 63) {
+            column = 0;
+            lines++;
+        }
+    }
+};
+
+//the chip stepped between the bus cycles of the coroutine core
+static void CycleStepped(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    LoadProgram(cpu);
+    m6502::CycleCPU stepped{cpu};
+    Raster raster;
+    for (auto _ : st)
+        stepped.run(1000000, [&raster](uint64_t) { raster.tick(); });
+    benchmark::DoNotOptimize(raster.lines);
+    st.SetItemsProcessed(st.iterations() * 1000000);
+}
+
+//the same chip called back through a clock, which execute() ticks once a cycle
+struct RasterClock : m6502::Clock {
+    Raster raster;
+    RasterClock() : Clock{true} {}
+    void start() override {}
+    void tick() override { raster.tick(); }
+};
+
+static void ClockCallbacks(benchmark::State& st) {
+    RasterClock clock;
+    m6502::CPU cpu{clock};
+    LoadProgram(cpu);
+    for (auto _ : st)
+        cpu.execute(UINT64_MAX, 1000000);
+    benchmark::DoNotOptimize(clock.raster.lines);
+    st.SetItemsProcessed(st.iterations() * 1000000);
+}
+
+//the coroutine core alone, against execute() with nothing to tick
+static void CycleSteppedAlone(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    LoadProgram(cpu);
+    m6502::CycleCPU stepped{cpu};
+    for (auto _ : st)
+        stepped.run(1000000);
+    st.SetItemsProcessed(st.iterations() * 1000000);
+}
+
+static void InstructionStepped(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    LoadProgram(cpu);
+    for (auto _ : st)
+        cpu.execute(UINT64_MAX, 1000000);
+    st.SetItemsProcessed(st.iterations() * 1000000);
+}
+
+BENCHMARK(CycleStepped)->Unit(benchmark::kMicrosecond);
+BENCHMARK(ClockCallbacks)->Unit(benchmark::kMicrosecond);
+BENCHMARK(CycleSteppedAlone)->Unit(benchmark::kMicrosecond);
+BENCHMARK(InstructionStepped)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,58 @@
+#include "benchmark/benchmark.h"
+#include "6502Devices.h"
+
+//counts down once a cycle and reads as the count
+struct Countdown : m6502::Device {
+    m6502::byte counter{0xFF};
+    void advance(uint64_t from, uint64_t to) override { counter = static_cast<m6502::byte>(counter - (to - from)); }
+    virtual void tick() { --counter; }
+    m6502::byte read(m6502::word) override { return counter; }
+    void write(m6502::word, m6502::byte data) override { counter = data; }
+};
+
+//loop: LDA $D000, or $1234 to leave the device alone; STA $10; JMP loop
+static void LoadProgram(m6502::CPU& cpu, bool touchDevice) {
+    const m6502::byte program[] {
+            m6502::CPU::INS_LDA_ABS, 0x00, static_cast<m6502::byte>(touchDevice ? 0xD0 : 0x12),
+            m6502::CPU::INS_STA_ZP, 0x10,
+            m6502::CPU::INS_JMP_ABS, 0x00, 0x80};
+    for (size_t i{0}; i < sizeof program; ++i)
+        cpu.mem[0x8000 + i] = program[i];
+    cpu.PC = 0x8000;
+}
+
+//the device brought up to date on the reads that hit it, a read every 10 cycles for range(0) 1
+static void DeviceCatchUp(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    LoadProgram(cpu, st.range(0));
+    m6502::EventQueue queue;
+    m6502::Devices devices{queue};
+    Countdown countdown;
+    devices.add(countdown, 0xD000, 1);
+    devices.attach(cpu.mem);
+    for (auto _ : st)
+        queue.run(cpu, 1000000);
+    st.SetItemsProcessed(st.iterations() * 1000000);
+}
+
+//the same device ticked every cycle, running the CPU an instruction at a time
+static void DeviceTickedEveryCycle(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    LoadProgram(cpu, false);
+    Countdown countdown;
+    Countdown* device = &countdown;
+    benchmark::DoNotOptimize(device);
+    for (auto _ : st) {
+        for (uint64_t cycles{0}; cycles < 1000000;) {
+            const m6502::dword used = cpu.execute(1);
+            for (m6502::dword i{0}; i < used; ++i) device->tick();
+            cycles += used;
+        }
+    }
+    st.SetItemsProcessed(st.iterations() * 1000000);
+}
+
+BENCHMARK(DeviceCatchUp)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+BENCHMARK(DeviceTickedEveryCycle)->Unit(benchmark::kMicrosecond);
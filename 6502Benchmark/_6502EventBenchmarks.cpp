@@ -0,0 +1,63 @@
+#include "benchmark/benchmark.h"
+#include "6502Events.h"
+
+//loop: LDA $1234; STA ($20),Y; JMP loop
+static void LoadProgram(m6502::CPU& cpu) {
+    const m6502::byte program[] {
+            m6502::CPU::INS_LDA_ABS, 0x34, 0x12,
+            m6502::CPU::INS_STA_INDY, 0x20,
+            m6502::CPU::INS_JMP_ABS, 0x00, 0x80};
+    for (size_t i{0}; i < sizeof program; ++i)
+        cpu.mem[0x8000 + i] = program[i];
+    cpu.mem[0x21] = 0x40;
+    cpu.PC = 0x8000;
+}
+
+//a timer counting down from range(0), as a device with a tick() for every cycle would be
+struct CountdownTimer : m6502::EventQueue::Handler {
+    uint64_t period, expiries{0}, counter;
+    explicit CountdownTimer(uint64_t period) : period(period), counter(period) {}
+    virtual void tick() {
+        if (--counter == 0) {
+            counter = period;
+            expiries++;
+        }
+    }
+    void onEvent(m6502::EventQueue& queue, uint64_t cycle) override {
+        expiries++;
+        queue.schedule(*this, cycle + period);
+    }
+};
+
+static void TimerEvents(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    LoadProgram(cpu);
+    m6502::EventQueue queue;
+    CountdownTimer timer{static_cast<uint64_t>(st.range(0))};
+    queue.schedule(timer, timer.period);
+    for (auto _ : st)
+        queue.run(cpu, 1000000);
+    st.SetItemsProcessed(st.iterations() * 1000000);
+}
+
+//the same timer ticked every cycle, running the CPU an instruction at a time
+static void TimerTickedEveryCycle(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    LoadProgram(cpu);
+    CountdownTimer timer{static_cast<uint64_t>(st.range(0))};
+    CountdownTimer* device = &timer;
+    benchmark::DoNotOptimize(device);
+    for (auto _ : st) {
+        for (uint64_t cycles{0}; cycles < 1000000;) {
+            const m6502::dword used = cpu.execute(1);
+            for (m6502::dword i{0}; i < used; ++i) device->tick();
+            cycles += used;
+        }
+    }
+    st.SetItemsProcessed(st.iterations() * 1000000);
+}
+
+BENCHMARK(TimerEvents)->Arg(100)->Arg(10000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(TimerTickedEveryCycle)->Arg(100)->Arg(10000)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,37 @@
+#include "benchmark/benchmark.h"
+#include "6502.h"
+
+//a parent using range(0) pages forked into 16 children, per child
+static void ForkCPU(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    for (m6502::dword page{0}; page < st.range(0); ++page)
+        cpu.mem[page * 0x100] = static_cast<m6502::byte>(page + 1);
+    for (auto _ : st) {
+        std::vector<m6502::CPU> children = cpu.fork(16);
+        benchmark::DoNotOptimize(children.data());
+    }
+    st.SetItemsProcessed(st.iterations() * 16);
+}
+
+//the same with every child getting its own copy of the parent's 64 KB
+static void CopyCPU(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    for (m6502::dword page{0}; page < st.range(0); ++page)
+        cpu.mem[page * 0x100] = static_cast<m6502::byte>(page + 1);
+    static m6502::byte image[m6502::Memory::MAX_MEM];
+    for (auto _ : st) {
+        std::vector<m6502::CPU> children(16, m6502::CPU{clock});
+        cpu.mem.copyTo(image);
+        for (m6502::CPU& child : children) {
+            child.PC = cpu.PC;
+            child.mem.copyFrom(image);
+        }
+        benchmark::DoNotOptimize(children.data());
+    }
+    st.SetItemsProcessed(st.iterations() * 16);
+}
+
+BENCHMARK(ForkCPU)->Arg(1)->Arg(64)->Arg(256);
+BENCHMARK(CopyCPU)->Arg(1)->Arg(64)->Arg(256);
@@ -0,0 +1,44 @@
+#include "benchmark/benchmark.h"
+#include "6502.h"
+#include <cstring>
+
+//a machine using 64 pages of which range(0) were written since its pages were last hashed
+static void HashState(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    for (m6502::dword page{0}; page < 64; ++page)
+        cpu.mem[page * 0x100 + 0x80] = static_cast<m6502::byte>(page + 1);
+    cpu.mem.clearDirty();
+    const auto pages = static_cast<m6502::dword>(st.range(0));
+    m6502::byte value{0};
+    for (auto _ : st) {
+        for (m6502::dword page{0}; page < pages; ++page)
+            cpu.mem.write(static_cast<m6502::word>(page * 0x100 + 0x42), ++value);
+        benchmark::DoNotOptimize(cpu.hash());
+        cpu.mem.clearDirty();
+    }
+}
+
+//the same machine hashed as a flat 64 KB image every time, as comparisons did before
+static void HashFlatImage(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    for (m6502::dword page{0}; page < 64; ++page)
+        cpu.mem[page * 0x100 + 0x80] = static_cast<m6502::byte>(page + 1);
+    static m6502::byte image[m6502::Memory::MAX_MEM];
+    m6502::byte value{0};
+    for (auto _ : st) {
+        cpu.mem.write(0x0042, ++value);
+        cpu.mem.copyTo(image);
+        uint64_t hash{14695981039346656037ull};
+        for (m6502::dword i{0}; i < m6502::Memory::MAX_MEM; i += 8) {
+            uint64_t chunk;
+            std::memcpy(&chunk, image + i, sizeof chunk);
+            hash = (hash ^ chunk) * 1099511628211ull;
+        }
+        benchmark::DoNotOptimize(hash);
+    }
+}
+
+BENCHMARK(HashState)->Arg(0)->Arg(1)->Arg(16);
+BENCHMARK(HashFlatImage);
@@ -0,0 +1,84 @@
+#include "benchmark/benchmark.h"
+#include "6502Image.h"
+#include "6502Mapper.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+//an 8 MB rom of 16 KB banks, from the start until the first bank shows
+static constexpr size_t IMAGE_SIZE = 8 * 1024 * 1024;
+static constexpr m6502::dword BANK_SIZE = 0x4000;
+
+static const std::string& ImagePath() {
+    static const std::string path = [] {
+        const std::string path = "/tmp/_6502ImageBenchmarks.rom";
+        std::vector<char> bytes(IMAGE_SIZE);
+        for (size_t i{0}; i < bytes.size(); ++i) bytes[i] = static_cast<char>(i * 31 + i / BANK_SIZE);
+        std::ofstream{path, std::ios::binary}.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        return path;
+    }();
+    return path;
+}
+
+//read into a buffer and copied into banks up front
+static void ImageReadAndCopy(benchmark::State& st) {
+    const std::string& path = ImagePath();
+    for (auto _ : st) {
+        std::ifstream file{path, std::ios::binary};
+        const std::vector<m6502::byte> bytes{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+        m6502::Mapper mapper{BANK_SIZE};
+        m6502::VirtualClock clock;
+        m6502::CPU cpu{clock};
+        mapper.addRom(bytes.data(), bytes.size());
+        mapper.addWindow(cpu.mem, 0x8000, 0);
+        benchmark::DoNotOptimize(cpu.mem.read(0x8000));
+    }
+    st.counters["bytes/s"] = benchmark::Counter(static_cast<double>(IMAGE_SIZE * st.iterations()), benchmark::Counter::kIsRate);
+}
+
+//mapped, and only the bank selected copied
+static void ImageMapped(benchmark::State& st) {
+    const std::string& path = ImagePath();
+    for (auto _ : st) {
+        const m6502::MappedFile file{path};
+        m6502::Mapper mapper{BANK_SIZE};
+        m6502::VirtualClock clock;
+        m6502::CPU cpu{clock};
+        mapper.mapRom(file.data(), file.size());
+        mapper.addWindow(cpu.mem, 0x8000, 0);
+        benchmark::DoNotOptimize(cpu.mem.read(0x8000));
+    }
+    st.counters["bytes/s"] = benchmark::Counter(static_cast<double>(IMAGE_SIZE * st.iterations()), benchmark::Counter::kIsRate);
+}
+
+//a 32 KB program as intel hex, parsed and loaded
+static void ImageIntelHex(benchmark::State& st) {
+    std::string text;
+    char record[64];
+    for (unsigned address{0x8000}; address < 0x10000; address += 16) {
+        unsigned sum = 16 + (address >> 8) + (address & 0xFF);
+        int at = std::snprintf(record, sizeof record, ":10%04X00", address);
+        for (unsigned i{0}; i < 16; ++i) {
+            const unsigned value = (address + i) * 7 & 0xFF;
+            sum += value;
+            at += std::snprintf(record + at, sizeof record - at, "%02X", value);
+        }
+        std::snprintf(record + at, sizeof record - at, "%02X\n", -sum & 0xFF);
+        text += record;
+    }
+    text += ":00000001FF\n";
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    for (auto _ : st) {
+        m6502::Image image;
+        image.parse(m6502::Image::INTEL_HEX, reinterpret_cast<const m6502::byte*>(text.data()), text.size());
+        benchmark::DoNotOptimize(image.loadInto(cpu.mem));
+    }
+    st.counters["bytes/s"] = benchmark::Counter(static_cast<double>(text.size() * st.iterations()), benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(ImageReadAndCopy)->Unit(benchmark::TimeUnit::kMillisecond);
+BENCHMARK(ImageMapped)->Unit(benchmark::TimeUnit::kMillisecond);
+BENCHMARK(ImageIntelHex)->Unit(benchmark::TimeUnit::kMicrosecond);
@@ -0,0 +1,58 @@
+#include "benchmark/benchmark.h"
+#include "6502.h"
+
+//loop: LDA $1234; STA ($20),Y; JMP loop, with a handler that only returns
+static void LoadProgram(m6502::CPU& cpu) {
+    const m6502::byte program[] {
+            m6502::CPU::INS_LDA_ABS, 0x34, 0x12,
+            m6502::CPU::INS_STA_INDY, 0x20,
+            m6502::CPU::INS_JMP_ABS, 0x00, 0x80};
+    for (size_t i{0}; i < sizeof program; ++i)
+        cpu.mem[0x8000 + i] = program[i];
+    cpu.mem[0x21] = 0x40;
+    cpu.mem[0x9000] = m6502::CPU::INS_RTI;
+    cpu.mem[m6502::CPU::NMI_VECTOR] = 0x00;
+    cpu.mem[m6502::CPU::NMI_VECTOR + 1] = 0x90;
+    cpu.mem[m6502::CPU::IRQ_VECTOR] = 0x00;
+    cpu.mem[m6502::CPU::IRQ_VECTOR + 1] = 0x90;
+    cpu.PC = 0x8000;
+}
+
+//the loop with no interrupt line asserted, what every program without interrupts pays
+static void NoInterrupts(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    LoadProgram(cpu);
+    for (auto _ : st)
+        cpu.execute(UINT64_MAX, 1000000);
+    st.SetItemsProcessed(st.iterations() * 1000000);
+}
+
+//IRQ held while I is set, so the pending check fails on every instruction
+static void MaskedIRQ(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    LoadProgram(cpu);
+    cpu.PS.set(m6502::CPU::StatusFlags::I);
+    cpu.irq(true);
+    for (auto _ : st)
+        cpu.execute(UINT64_MAX, 1000000);
+    st.SetItemsProcessed(st.iterations() * 1000000);
+}
+
+//from raising NMI to being back in the loop: the 7 cycle entry and the 6 cycle RTI
+static void InterruptLatency(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    LoadProgram(cpu);
+    int64_t cyclesUsed{0};
+    for (auto _ : st) {
+        cpu.nmi();
+        cyclesUsed += cpu.execute(1);
+    }
+    st.counters["cycles"] = benchmark::Counter(static_cast<double>(cyclesUsed), benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK(NoInterrupts)->Unit(benchmark::kMicrosecond);
+BENCHMARK(MaskedIRQ)->Unit(benchmark::kMicrosecond);
+BENCHMARK(InterruptLatency)->Unit(benchmark::kNanosecond);
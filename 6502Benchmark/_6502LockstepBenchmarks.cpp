@@ -0,0 +1,55 @@
+#include "benchmark/benchmark.h"
+#include "6502Lockstep.h"
+#include <memory>
+
+//1024 instances of one loop over different inputs, one CPU after the other or all in lockstep
+static constexpr size_t INSTANCES = 1024;
+static constexpr uint64_t INSTRUCTIONS = 1000;
+
+static void LoadProgram(m6502::CPU& cpu, size_t input) {
+    const m6502::byte program[] {
+            m6502::CPU::INS_LDA_ZP, 0x10,
+            m6502::CPU::INS_EOR_ABSX, 0x00, 0x03,
+            m6502::CPU::INS_STA_ABSY, 0x00, 0x02,
+            m6502::CPU::INS_LDX_ZP, 0x11,
+            m6502::CPU::INS_LDY_ZP, 0x12,
+            m6502::CPU::INS_JMP_ABS, 0x00, 0x80};
+    for (size_t i{0}; i < sizeof program; ++i)
+        cpu.mem[0x8000 + i] = program[i];
+    cpu.mem[0x10] = static_cast<m6502::byte>(input);
+    cpu.mem[0x11] = static_cast<m6502::byte>(input * 7);
+    cpu.mem[0x12] = static_cast<m6502::byte>(input >> 3);
+    cpu.PC = 0x8000;
+}
+
+static void ScalarInstances(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    std::vector<std::unique_ptr<m6502::CPU>> cpus;
+    for (size_t i{0}; i < INSTANCES; ++i) {
+        cpus.emplace_back(new m6502::CPU{clock});
+        LoadProgram(*cpus.back(), i);
+    }
+    for (auto _ : st)
+        for (auto& cpu : cpus)
+            benchmark::DoNotOptimize(cpu->execute(INSTRUCTIONS));
+    st.counters["instructions/s"] = benchmark::Counter(static_cast<double>(INSTANCES * INSTRUCTIONS * st.iterations()), benchmark::Counter::kIsRate);
+}
+
+static void LockstepInstances(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    m6502::LockstepCPU lockstep{INSTANCES};
+    lockstep.useAVX2(st.range(0));
+    if (st.range(0) && !m6502::LockstepCPU::hasAVX2()) st.SkipWithError("host has no AVX2");
+    for (size_t i{0}; i < INSTANCES; ++i) {
+        LoadProgram(cpu, i);
+        lockstep.load(i, cpu);
+    }
+    for (auto _ : st)
+        lockstep.execute(INSTRUCTIONS);
+    st.counters["instructions/s"] = benchmark::Counter(static_cast<double>(INSTANCES * INSTRUCTIONS * st.iterations()), benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(ScalarInstances)->Unit(benchmark::TimeUnit::kMillisecond)->UseRealTime();
+//0 runs the lockstep engine on scalar lanes only, 1 with AVX2
+BENCHMARK(LockstepInstances)->Arg(0)->Arg(1)->Unit(benchmark::TimeUnit::kMillisecond)->UseRealTime();
@@ -0,0 +1,67 @@
+#include "benchmark/benchmark.h"
+#include "6502Mapper.h"
+#include <vector>
+
+//a 1 MB image in banks of range(0) bytes, switching a window at $8000 through all of them
+static void MapperSelect(benchmark::State& st) {
+    const std::vector<m6502::byte> image(1024 * 1024, 0xEA);
+    m6502::Mapper mapper{static_cast<m6502::dword>(st.range(0))};
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    mapper.addRom(image.data(), image.size());
+    const size_t window = mapper.addWindow(cpu.mem, 0x8000, 0);
+    m6502::dword bank{0};
+    for (auto _ : st) {
+        mapper.select(window, ++bank);
+        benchmark::DoNotOptimize(cpu.mem.read(0x8000));
+    }
+    st.counters["switches/s"] = benchmark::Counter(static_cast<double>(st.iterations()), benchmark::Counter::kIsRate);
+}
+
+//what copying a bank in would cost instead
+static void MapperCopyBank(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    const std::vector<m6502::byte> image(1024 * 1024, 0xEA);
+    const size_t size = static_cast<size_t>(st.range(0));
+    size_t bank{0};
+    for (auto _ : st) {
+        bank = (bank + 1) % (image.size() / size);
+        for (size_t i{0}; i < size; ++i)
+            cpu.mem.write(static_cast<m6502::word>(0x8000 + i), image[bank * size + i]);
+        benchmark::DoNotOptimize(cpu.mem.read(0x8000));
+    }
+    st.counters["switches/s"] = benchmark::Counter(static_cast<double>(st.iterations()), benchmark::Counter::kIsRate);
+}
+
+//a program that reads a byte from each bank in turn, switching through its register: STX $D000; LDA $8000; then the bank after next
+static void MapperSwitchFromProgram(benchmark::State& st) {
+    using CPU = m6502::CPU;
+    const std::vector<m6502::byte> image(1024 * 1024, 0xEA);
+    m6502::Mapper mapper{0x2000};
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    mapper.addRom(image.data(), image.size());
+    mapper.addWindow(cpu.mem, 0x8000, 0);
+    m6502::EventQueue queue;
+    m6502::Devices devices{queue};
+    devices.add(mapper, 0xD000, 1);
+    devices.attach(cpu.mem);
+    //LDY $0400,X; LDX $0400,Y for the next bank
+    const m6502::byte program[] {CPU::INS_STX_ABS, 0x00, 0xD0, CPU::INS_LDA_ABS, 0x00, 0x80,
+                                 CPU::INS_LDY_ABSX, 0x00, 0x04, CPU::INS_LDX_ABSY, 0x00, 0x04,
+                                 CPU::INS_JMP_ABS, 0x00, 0xC0};
+    for (size_t i{0}; i < sizeof program; ++i)
+        cpu.mem[0xC000 + i] = program[i];
+    for (m6502::dword x{0}; x < 0x100; ++x)
+        cpu.mem[0x0400 + x] = static_cast<m6502::byte>(x + 1);
+    cpu.PC = 0xC000;
+    for (auto _ : st)
+        queue.run(cpu, 100000);
+    st.counters["cycles/s"] = benchmark::Counter(static_cast<double>(100000 * st.iterations()), benchmark::Counter::kIsRate);
+    st.counters["switches/s"] = benchmark::Counter(static_cast<double>(mapper.getStats().switches), benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(MapperSelect)->Arg(0x100)->Arg(0x2000)->Arg(0x4000);
+BENCHMARK(MapperCopyBank)->Arg(0x100)->Arg(0x2000)->Arg(0x4000);
+BENCHMARK(MapperSwitchFromProgram);
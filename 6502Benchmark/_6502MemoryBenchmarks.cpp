@@ -0,0 +1,57 @@
+#include "benchmark/benchmark.h"
+#include "6502.h"
+#include "6502Dedup.h"
+#include <vector>
+
+//a job that writes one byte into each of range(0) pages, then the reset before the next job
+static void MemoryReset(benchmark::State& st) {
+    m6502::Memory mem;
+    const m6502::dword pages = static_cast<m6502::dword>(st.range(0));
+    for (auto _ : st) {
+        for (m6502::dword page{0}; page < pages; ++page)
+            mem.write(static_cast<m6502::word>(page * 0x100 + 0x42), 0x37);
+        mem.initialize();
+    }
+    benchmark::DoNotOptimize(mem.read(0x0042));
+    st.counters["pages"] = static_cast<double>(pages);
+}
+
+//what a fresh CPU costs before it runs anything
+static void ConstructCPU(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    for (auto _ : st) {
+        m6502::CPU cpu{clock};
+        benchmark::DoNotOptimize(cpu.PC);
+    }
+}
+
+//1000 idle instances with 8 used pages each: the same table, a scratch page written back to zero, 6 of their own
+static void DeduplicateIdleInstances(benchmark::State& st) {
+    uint64_t pages{0}, reclaimed{0};
+    for (auto _ : st) {
+        st.PauseTiming();
+        std::vector<m6502::Memory> memories(1000);
+        m6502::Deduplicator deduplicator;
+        for (size_t i{0}; i < memories.size(); ++i) {
+            for (m6502::dword j{0}; j < m6502::Page::SIZE; ++j)
+                memories[i].write(static_cast<m6502::word>(0x0300 + j), static_cast<m6502::byte>(j));
+            memories[i].write(0x0400, 0);
+            for (m6502::word page{0x10}; page < 0x16; ++page) {
+                memories[i].write(static_cast<m6502::word>(page << 8), static_cast<m6502::byte>(page));
+                memories[i].write(static_cast<m6502::word>(page << 8 | 1), static_cast<m6502::byte>(i));
+                memories[i].write(static_cast<m6502::word>(page << 8 | 2), static_cast<m6502::byte>(i >> 8));
+            }
+            deduplicator.add(memories[i]);
+        }
+        st.ResumeTiming();
+        const m6502::Deduplicator::Stats& stats = deduplicator.run();
+        pages += stats.pagesScanned;
+        reclaimed = stats.bytesReclaimed;
+    }
+    st.counters["pages/s"] = benchmark::Counter(static_cast<double>(pages), benchmark::Counter::kIsRate);
+    st.counters["reclaimed_KB"] = static_cast<double>(reclaimed) / 1024;
+}
+
+BENCHMARK(MemoryReset)->Arg(1)->Arg(4)->Arg(32)->Arg(256);
+BENCHMARK(ConstructCPU);
+BENCHMARK(DeduplicateIdleInstances)->Unit(benchmark::TimeUnit::kMillisecond);
@@ -0,0 +1,62 @@
+#include "benchmark/benchmark.h"
+#include "6502Network.h"
+#include <memory>
+#include <vector>
+
+/* 16 nodes in a ring, each walking its own tables and, on an IRQ from its left link, sending
+ * what it got on to the right one plus one */
+static constexpr size_t NODES = 16;
+static constexpr uint64_t CYCLES = 200000;
+
+static std::vector<std::unique_ptr<m6502::CPU>> MakeNodes(m6502::VirtualClock& clock, m6502::Network& network, uint64_t latency) {
+    using CPU = m6502::CPU;
+    const m6502::byte program[] {
+            CPU::INS_LDA_IM, 0x01, CPU::INS_STA_ABS, 0x01, 0xD0,
+            CPU::INS_LDA_IM, 0x00, CPU::INS_STA_ABS, 0x10, 0xD0,
+            CPU::INS_LDA_ABSX, 0x00, 0x03,
+            CPU::INS_STA_ABSX, 0x00, 0x04,
+            CPU::INS_LDY_ABSX, 0x00, 0x05,
+            CPU::INS_STA_ABSY, 0x00, 0x06,
+            CPU::INS_LDX_ABSY, 0x00, 0x07,
+            CPU::INS_JMP_ABS, 0x0A, 0x80};
+    //LDY $D000; LDA $0500,Y; STA $D010; RTI, the X the main loop is at is left alone
+    const m6502::byte handler[] {
+            CPU::INS_LDY_ABS, 0x00, 0xD0, CPU::INS_LDA_ABSY, 0x00, 0x05,
+            CPU::INS_STA_ABS, 0x10, 0xD0, CPU::INS_RTI};
+    std::vector<std::unique_ptr<CPU>> cpus;
+    for (size_t i{0}; i < NODES; ++i) {
+        cpus.emplace_back(new CPU{clock});
+        CPU& cpu = *cpus.back();
+        for (size_t j{0}; j < sizeof program; ++j)
+            cpu.mem[0x8000 + j] = program[j];
+        for (size_t j{0}; j < sizeof handler; ++j)
+            cpu.mem[0x9000 + j] = handler[j];
+        cpu.mem[CPU::IRQ_VECTOR] = 0x00;
+        cpu.mem[CPU::IRQ_VECTOR + 1] = 0x90;
+        for (m6502::dword j{0}; j < 0x100; ++j) {
+            cpu.mem[0x0300 + j] = static_cast<m6502::byte>(j * 7 + i);
+            cpu.mem[0x0500 + j] = static_cast<m6502::byte>(j + 1);
+            cpu.mem[0x0700 + j] = static_cast<m6502::byte>(j * 5 + 3 + i);
+        }
+        cpu.PC = 0x8000;
+        network.add(cpu);
+    }
+    for (size_t i{0}; i < NODES; ++i)
+        network.connect(i, 0xD010, (i + 1) % NODES, 0xD000, latency);
+    return cpus;
+}
+
+//link latency, then worker threads; the work is on the workers, so the rates are per wall clock second
+static void NetworkRing(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    m6502::Network network;
+    auto cpus = MakeNodes(clock, network, static_cast<uint64_t>(st.range(0)));
+    for (auto _ : st)
+        network.run(CYCLES, static_cast<unsigned>(st.range(1)));
+    const m6502::Network::Stats& stats = network.getStats();
+    st.counters["cycles/s"] = benchmark::Counter(static_cast<double>(stats.cycles * st.iterations()), benchmark::Counter::kIsRate);
+    st.counters["windows"] = static_cast<double>(stats.windows);
+    st.counters["messages"] = static_cast<double>(stats.messages);
+}
+
+BENCHMARK(NetworkRing)->ArgsProduct({{50, 500, 5000}, {1, 4}})->UseRealTime()->Unit(benchmark::TimeUnit::kMillisecond);
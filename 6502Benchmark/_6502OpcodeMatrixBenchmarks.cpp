@@ -0,0 +1,191 @@
+#include "benchmark/benchmark.h"
+#include "6502.h"
+#include <cstdio>
+#include <memory>
+#include <string>
+
+/* One benchmark row per opcode/addressing mode, generated from the opcode list below
+ * instead of hand written fixtures. Indexed modes that can cross a page get a second
+ * row with the crossing forced. The CPU runs unthrottled so rows measure host cost. */
+namespace {
+    using m6502::CPU;
+    using m6502::byte;
+    using m6502::word;
+
+    enum class Mode {Implied, Immediate, ZeroPage, ZeroPageX, ZeroPageY, Absolute, AbsoluteX, AbsoluteY, XIndirect, IndirectY, Indirect};
+
+    struct Opcode {
+        const char* name;
+        byte opcode;
+        Mode mode;
+    };
+
+    const Opcode opcodes[] {
+        //Load/Store Operations
+        {"LDA_IM", CPU::INS_LDA_IM, Mode::Immediate}, {"LDA_ZP", CPU::INS_LDA_ZP, Mode::ZeroPage}, {"LDA_ZPX", CPU::INS_LDA_ZPX, Mode::ZeroPageX},
+        {"LDA_ABS", CPU::INS_LDA_ABS, Mode::Absolute}, {"LDA_ABSX", CPU::INS_LDA_ABSX, Mode::AbsoluteX}, {"LDA_ABSY", CPU::INS_LDA_ABSY, Mode::AbsoluteY},
+        {"LDA_XIND", CPU::INS_LDA_XIND, Mode::XIndirect}, {"LDA_INDY", CPU::INS_LDA_INDY, Mode::IndirectY},
+        {"LDX_IM", CPU::INS_LDX_IM, Mode::Immediate}, {"LDX_ZP", CPU::INS_LDX_ZP, Mode::ZeroPage}, {"LDX_ZPY", CPU::INS_LDX_ZPY, Mode::ZeroPageY},
+        {"LDX_ABS", CPU::INS_LDX_ABS, Mode::Absolute}, {"LDX_ABSY", CPU::INS_LDX_ABSY, Mode::AbsoluteY},
+        {"LDY_IM", CPU::INS_LDY_IM, Mode::Immediate}, {"LDY_ZP", CPU::INS_LDY_ZP, Mode::ZeroPage}, {"LDY_ZPX", CPU::INS_LDY_ZPX, Mode::ZeroPageX},
+        {"LDY_ABS", CPU::INS_LDY_ABS, Mode::Absolute}, {"LDY_ABSX", CPU::INS_LDY_ABSX, Mode::AbsoluteX},
+        {"STA_ZP", CPU::INS_STA_ZP, Mode::ZeroPage}, {"STA_ZPX", CPU::INS_STA_ZPX, Mode::ZeroPageX}, {"STA_ABS", CPU::INS_STA_ABS, Mode::Absolute},
+        {"STA_ABSX", CPU::INS_STA_ABSX, Mode::AbsoluteX}, {"STA_ABSY", CPU::INS_STA_ABSY, Mode::AbsoluteY},
+        {"STA_XIND", CPU::INS_STA_XIND, Mode::XIndirect}, {"STA_INDY", CPU::INS_STA_INDY, Mode::IndirectY},
+        {"STX_ZP", CPU::INS_STX_ZP, Mode::ZeroPage}, {"STX_ZPY", CPU::INS_STX_ZPY, Mode::ZeroPageY}, {"STX_ABS", CPU::INS_STX_ABS, Mode::Absolute},
+        {"STY_ZP", CPU::INS_STY_ZP, Mode::ZeroPage}, {"STY_ZPX", CPU::INS_STY_ZPX, Mode::ZeroPageX}, {"STY_ABS", CPU::INS_STY_ABS, Mode::Absolute},
+        //Logical Operations
+        {"AND_IM", CPU::INS_AND_IM, Mode::Immediate}, {"AND_ZP", CPU::INS_AND_ZP, Mode::ZeroPage}, {"AND_ZPX", CPU::INS_AND_ZPX, Mode::ZeroPageX},
+        {"AND_ABS", CPU::INS_AND_ABS, Mode::Absolute}, {"AND_ABSX", CPU::INS_AND_ABSX, Mode::AbsoluteX}, {"AND_ABSY", CPU::INS_AND_ABSY, Mode::AbsoluteY},
+        {"AND_XIND", CPU::INS_AND_XIND, Mode::XIndirect}, {"AND_INDY", CPU::INS_AND_INDY, Mode::IndirectY},
+        {"ORA_IM", CPU::INS_ORA_IM, Mode::Immediate}, {"ORA_ZP", CPU::INS_ORA_ZP, Mode::ZeroPage}, {"ORA_ZPX", CPU::INS_ORA_ZPX, Mode::ZeroPageX},
+        {"ORA_ABS", CPU::INS_ORA_ABS, Mode::Absolute}, {"ORA_ABSX", CPU::INS_ORA_ABSX, Mode::AbsoluteX}, {"ORA_ABSY", CPU::INS_ORA_ABSY, Mode::AbsoluteY},
+        {"ORA_XIND", CPU::INS_ORA_XIND, Mode::XIndirect}, {"ORA_INDY", CPU::INS_ORA_INDY, Mode::IndirectY},
+        {"EOR_IM", CPU::INS_EOR_IM, Mode::Immediate}, {"EOR_ZP", CPU::INS_EOR_ZP, Mode::ZeroPage}, {"EOR_ZPX", CPU::INS_EOR_ZPX, Mode::ZeroPageX},
+        {"EOR_ABS", CPU::INS_EOR_ABS, Mode::Absolute}, {"EOR_ABSX", CPU::INS_EOR_ABSX, Mode::AbsoluteX}, {"EOR_ABSY", CPU::INS_EOR_ABSY, Mode::AbsoluteY},
+        {"EOR_XIND", CPU::INS_EOR_XIND, Mode::XIndirect}, {"EOR_INDY", CPU::INS_EOR_INDY, Mode::IndirectY},
+        {"BIT_ZP", CPU::INS_BIT_ZP, Mode::ZeroPage}, {"BIT_ABS", CPU::INS_BIT_ABS, Mode::Absolute},
+        //JUmps and Calls
+        {"RTS", CPU::INS_RTS, Mode::Implied},
+        {"JMP_ABS", CPU::INS_JMP_ABS, Mode::Absolute}, {"JMP_IND", CPU::INS_JMP_IND, Mode::Indirect},
+        {"JSR", CPU::INS_JSR, Mode::Absolute},
+        //Stack Operations
+        {"PHA_IMP", CPU::INS_PHA_IMP, Mode::Implied}, {"PHP_IMP", CPU::INS_PHP_IMP, Mode::Implied},
+        {"PLA_IMP", CPU::INS_PLA_IMP, Mode::Implied}, {"PLP_IMP", CPU::INS_PLP_IMP, Mode::Implied},
+        {"TSX_IMP", CPU::INS_TSX_IMP, Mode::Implied}, {"TXS_IMP", CPU::INS_TXS_IMP, Mode::Implied},
+        //Register Transfers: 6502.h names TXA, TAX and TAY, but execute() does not run them yet
+        //System Functions
+        {"BRK", CPU::INS_BRK, Mode::Implied}, {"RTI", CPU::INS_RTI, Mode::Implied},
+    };
+
+    const char* modeName(Mode mode) {
+        switch (mode) {
+            case Mode::Implied: return "Implied";
+            case Mode::Immediate: return "Immediate";
+            case Mode::ZeroPage: return "ZeroPage";
+            case Mode::ZeroPageX: return "ZeroPageX";
+            case Mode::ZeroPageY: return "ZeroPageY";
+            case Mode::Absolute: return "Absolute";
+            case Mode::AbsoluteX: return "AbsoluteX";
+            case Mode::AbsoluteY: return "AbsoluteY";
+            case Mode::XIndirect: return "XIndirect";
+            case Mode::IndirectY: return "IndirectY";
+            case Mode::Indirect: return "Indirect";
+        }
+        return "";
+    }
+
+    bool canCrossPage(Mode mode) {
+        return mode == Mode::AbsoluteX || mode == Mode::AbsoluteY || mode == Mode::IndirectY;
+    }
+
+    constexpr word START = 0xFFFC;
+
+    //lay out the instruction at START and whatever its addressing mode reads from
+    void setUpInstruction(CPU& cpu, const Opcode& op, bool crossPage) {
+        const word base = crossPage ? 0x20F0 : 0x2000;
+        cpu.mem[START] = op.opcode;
+        switch (op.mode) {
+            case Mode::Implied: break;
+            case Mode::Immediate:
+                cpu.mem[START + 1] = 0x42;
+                break;
+            case Mode::ZeroPage:
+            case Mode::ZeroPageX:
+            case Mode::ZeroPageY:
+                cpu.mem[START + 1] = 0x42;
+                break;
+            case Mode::Absolute:
+            case Mode::AbsoluteX:
+            case Mode::AbsoluteY:
+                cpu.mem[START + 1] = base & 0xFF;
+                cpu.mem[START + 2] = base >> 8;
+                break;
+            case Mode::XIndirect:
+                //X holds 0x10 for modes that cannot cross a page
+                cpu.mem[START + 1] = 0x20;
+                cpu.mem[0x0030] = base & 0xFF;
+                cpu.mem[0x0031] = base >> 8;
+                break;
+            case Mode::IndirectY:
+                cpu.mem[START + 1] = 0x20;
+                cpu.mem[0x0020] = base & 0xFF;
+                cpu.mem[0x0021] = base >> 8;
+                break;
+            case Mode::Indirect:
+                cpu.mem[START + 1] = 0x00;
+                cpu.mem[START + 2] = 0x30;
+                cpu.mem[0x3000] = 0x00;
+                cpu.mem[0x3001] = 0x40;
+                break;
+        }
+    }
+
+    void BenchmarkOpcode(benchmark::State& st, Opcode op, bool crossPage) {
+        std::unique_ptr<CPU> cpu{new CPU{0}};
+        setUpInstruction(*cpu, op, crossPage);
+        //an index of 0x20 carries the low byte of 0x20F0 into the next page, 0x10 from 0x2000 does not
+        const byte index = crossPage ? 0x20 : 0x10;
+        int64_t cyclesUsed{0};
+        for (auto _ : st) {
+            cpu->PC = START;
+            cpu->SP = 0xFD;
+            cpu->X = cpu->Y = index;
+            cyclesUsed += cpu->execute();
+            benchmark::DoNotOptimize(cpu->A);
+        }
+        st.counters["cycles"] = benchmark::Counter(static_cast<double>(cyclesUsed), benchmark::Counter::kAvgIterations);
+        st.counters["cycles/s"] = benchmark::Counter(static_cast<double>(cyclesUsed), benchmark::Counter::kIsRate);
+    }
+
+    //execute() sets halted when it stops on an opcode it does not know
+    bool isHandled(const Opcode& op) {
+        std::unique_ptr<CPU> cpu{new CPU{0}};
+        setUpInstruction(*cpu, op, false);
+        cpu->PC = START;
+        cpu->SP = 0xFD;
+        cpu->execute();
+        return !cpu->halted;
+    }
+
+    //a row that fails the run rather than going missing from it
+    void BenchmarkBrokenRow(benchmark::State& st, std::string error) {
+        st.SkipWithError(error.c_str());
+        for (auto _ : st) {}
+    }
+
+    void registerBrokenRow(const std::string& name, const std::string& error) {
+        std::fprintf(stderr, "%s: %s\n", name.c_str(), error.c_str());
+        benchmark::RegisterBenchmark(name.c_str(), BenchmarkBrokenRow, error);
+    }
+
+    /* rows the CPU does not handle and opcodes it handles without a row are registered as
+     * errors, so the list cannot drift from execute() unnoticed */
+    int registerOpcodeMatrix() {
+        bool listed[256]{};
+        for (const Opcode& op : opcodes) {
+            listed[op.opcode] = true;
+            std::string name = std::string{"Opcode/"} + op.name + "/" + modeName(op.mode);
+            if (!isHandled(op)) {
+                registerBrokenRow(name, "listed, but execute() does not handle it");
+                continue;
+            }
+            for (bool crossPage : {false, true}) {
+                if (crossPage && !canCrossPage(op.mode)) continue;
+                std::string row = name;
+                if (canCrossPage(op.mode)) row += crossPage ? "/PageCrossed" : "/NoPageCross";
+                benchmark::RegisterBenchmark(row.c_str(), BenchmarkOpcode, op, crossPage)->Unit(benchmark::TimeUnit::kNanosecond)->UseRealTime();
+            }
+        }
+        for (int opcode{0}; opcode < 256; ++opcode) {
+            const Opcode op{"", static_cast<byte>(opcode), Mode::Implied};
+            if (listed[opcode] || !isHandled(op)) continue;
+            char name[16];
+            std::snprintf(name, sizeof name, "Opcode/0x%02X", opcode);
+            registerBrokenRow(name, "handled by execute(), but missing from the opcode list");
+        }
+        return 0;
+    }
+
+    const int registered = registerOpcodeMatrix();
+}
@@ -0,0 +1,59 @@
+#include "benchmark/benchmark.h"
+#include "6502.h"
+#include <memory>
+#include <string>
+
+/* Measures how closely a paced CPU keeps to its requested frequency. The guest spins on
+ * JMP $FFFC (3 cycles), each iteration running about 10ms of emulated time. */
+class _6502PacingBenchmarks : public benchmark::Fixture {
+public:
+    std::unique_ptr<m6502::TSCClock> clock;
+    std::unique_ptr<m6502::CPU> cpu;
+    void SetUp(const ::benchmark::State& state) {
+        clock.reset(new m6502::TSCClock{state.range(0) / 100.0});
+        cpu.reset(new m6502::CPU{*clock});
+        cpu->PC = 0xFFFC;
+        cpu->mem[0xFFFC] = m6502::CPU::INS_JMP_ABS;
+        cpu->mem[0xFFFD] = 0xFC;
+        cpu->mem[0xFFFE] = 0xFF;
+    }
+    void TearDown(const ::benchmark::State& state) { cpu.reset(); clock.reset(); }
+};
+
+static double ticksToNs(uint64_t ticks) {
+    return ticks * 1000.0 / m6502::TSCClock::getTCSFrequency();
+}
+
+//"<=Nns:percent" for every non empty bucket of the overshoot histogram
+static std::string overshootHistogram(const m6502::TSCClock::PacingStats& stats) {
+    std::string histogram;
+    for (int i{0}; i < m6502::TSCClock::PacingStats::BUCKETS; ++i) {
+        if (!stats.overshoot[i]) continue;
+        char bucket[48];
+        snprintf(bucket, sizeof bucket, "%s<=%.0fns:%.1f%%", histogram.empty() ? "" : " ",
+                 ticksToNs(i ? (uint64_t{1} << i) - 1 : 0), 100.0 * stats.overshoot[i] / stats.cycles);
+        histogram += bucket;
+    }
+    return histogram;
+}
+
+BENCHMARK_DEFINE_F(_6502PacingBenchmarks, PacingAccuracy)(benchmark::State& st) {
+    const double Mhz = st.range(0) / 100.0;
+    const uint64_t instructions = Mhz * 1e4 / 3 > 1 ? static_cast<uint64_t>(Mhz * 1e4 / 3) : 1;
+    clock->resetPacingStats();
+    for (auto _ : st)
+        benchmark::DoNotOptimize(cpu->execute(instructions));
+
+    const auto& stats = clock->getPacingStats();
+    st.counters["requested_MHz"] = stats.requestedMhz;
+    st.counters["achieved_MHz"] = stats.achievedMhz();
+    st.counters["drift_ppm"] = stats.driftPPM();
+    st.counters["drift_us"] = stats.driftMicroseconds();
+    st.counters["overshoot_p50_ns"] = ticksToNs(stats.overshootPercentile(0.5));
+    st.counters["overshoot_p99_ns"] = ticksToNs(stats.overshootPercentile(0.99));
+    st.counters["overshoot_max_ns"] = ticksToNs(stats.maxOvershoot);
+    st.SetLabel(overshootHistogram(stats));
+}
+
+//frequencies are given in hundredths of a MHz
+BENCHMARK_REGISTER_F(_6502PacingBenchmarks, PacingAccuracy)->Arg(1)->Arg(100)->Arg(200)->Arg(400)->Unit(benchmark::TimeUnit::kMillisecond)->UseRealTime();
@@ -0,0 +1,46 @@
+#include "benchmark/benchmark.h"
+#include "6502Pool.h"
+#include <memory>
+#include <vector>
+
+//a job per CPU: get 256 fresh CPUs, write a stack and a zero page byte in each, give them back
+static constexpr size_t JOBS = 256;
+
+static void Use(m6502::CPU& cpu) {
+    cpu.mem.write(0x0010, 1);
+    cpu.mem.write(0x01FF, 2);
+}
+
+static void NewDeleteCPUs(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    std::vector<std::unique_ptr<m6502::CPU>> cpus(JOBS);
+    for (auto _ : st) {
+        for (auto& cpu : cpus) {
+            cpu.reset(new m6502::CPU{clock});
+            Use(*cpu);
+        }
+        for (auto& cpu : cpus) cpu.reset();
+    }
+    st.SetItemsProcessed(static_cast<int64_t>(JOBS * st.iterations()));
+}
+
+static void PooledCPUs(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    m6502::CPUPool pool{clock};
+    std::vector<m6502::CPU*> cpus(JOBS);
+    for (auto _ : st) {
+        for (auto& cpu : cpus) {
+            cpu = pool.acquire();
+            Use(*cpu);
+        }
+        for (auto& cpu : cpus) pool.release(cpu);
+    }
+    const m6502::CPUPool::Stats& stats = pool.getStats();
+    st.SetItemsProcessed(static_cast<int64_t>(JOBS * st.iterations()));
+    st.counters["acquire_ns"] = stats.averageAcquireNanoseconds();
+    st.counters["max_acquire_ns"] = static_cast<double>(stats.maxAcquireNanoseconds);
+    st.counters["huge_arenas"] = static_cast<double>(stats.hugeArenas + stats.advisedArenas);
+}
+
+BENCHMARK(NewDeleteCPUs);
+BENCHMARK(PooledCPUs);
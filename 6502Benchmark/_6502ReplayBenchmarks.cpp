@@ -0,0 +1,38 @@
+#include "benchmark/benchmark.h"
+#include "6502Replay.h"
+#include <sstream>
+
+//loop: LDA $0200; EOR $10; STA $10; JMP loop, with an input at $0200 every range(0) cycles
+static void ReplaySession(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    const m6502::byte program[] {
+            m6502::CPU::INS_LDA_ABS, 0x00, 0x02,
+            m6502::CPU::INS_EOR_ZP, 0x10,
+            m6502::CPU::INS_STA_ZP, 0x10,
+            m6502::CPU::INS_JMP_ABS, 0x00, 0x80};
+    for (size_t i{0}; i < sizeof program; ++i)
+        cpu.mem[0x8000 + i] = program[i];
+    cpu.PC = 0x8000;
+
+    std::stringstream log;
+    m6502::InputRecorder recorder{cpu, log};
+    const auto interval = static_cast<uint64_t>(st.range(0));
+    for (uint64_t i{0}; i < 10000000 / interval; ++i) {
+        recorder.run(interval);
+        recorder.write(0x0200, static_cast<m6502::byte>(i));
+    }
+    recorder.finish();
+    const std::string bytes = log.str();
+
+    m6502::CPU replayed{clock};
+    for (auto _ : st) {
+        std::stringstream session{bytes};
+        m6502::InputReplayer replayer{replayed, session};
+        benchmark::DoNotOptimize(replayer.run());
+    }
+    st.SetItemsProcessed(st.iterations() * recorder.now());
+    st.counters["logKB"] = bytes.size() / 1024.0;
+}
+
+BENCHMARK(ReplaySession)->Arg(100)->Arg(10000)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,60 @@
+#include "benchmark/benchmark.h"
+#include "6502Rewind.h"
+
+//loop: EOR #$01; PHA; TSX; STA $4000,X; JMP loop
+static void LoadProgram(m6502::CPU& cpu) {
+    const m6502::byte program[] {
+            m6502::CPU::INS_EOR_IM, 0x01,
+            m6502::CPU::INS_PHA_IMP, 0x00,
+            m6502::CPU::INS_TSX_IMP, 0x00,
+            m6502::CPU::INS_STA_ABSX, 0x00, 0x40,
+            m6502::CPU::INS_JMP_ABS, 0x00, 0x80};
+    for (size_t i{0}; i < sizeof program; ++i)
+        cpu.mem[0x8000 + i] = program[i];
+    cpu.PC = 0x8000;
+}
+
+//10 million cycles recorded with a snapshot every range(0) cycles, then back to points spread over them
+static void RewindToEarlierCycle(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    LoadProgram(cpu);
+    m6502::Rewinder rewinder{cpu, 64 << 20, static_cast<uint64_t>(st.range(0))};
+    rewinder.run(10000000);
+    const uint64_t end = rewinder.now();
+    uint64_t target{0};
+    for (auto _ : st) {
+        target = (target + 7654321) % end;
+        rewinder.rewindTo(target);
+        //back to the end, untimed, so every rewind goes to the same kind of ring
+        st.PauseTiming();
+        rewinder.run(end - rewinder.now());
+        st.ResumeTiming();
+    }
+    st.counters["snapshots"] = static_cast<double>(rewinder.getStats().snapshots);
+    st.counters["KB"] = rewinder.getStats().bytes / 1024.0;
+}
+
+//what recording costs while running, against running the CPU by itself
+static void RunRecording(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    LoadProgram(cpu);
+    m6502::Rewinder rewinder{cpu, 64 << 20, static_cast<uint64_t>(st.range(0))};
+    for (auto _ : st)
+        rewinder.run(1000000);
+    st.SetItemsProcessed(st.iterations() * 1000000);
+}
+
+static void RunPlain(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    LoadProgram(cpu);
+    for (auto _ : st)
+        cpu.execute(UINT64_MAX, 1000000);
+    st.SetItemsProcessed(st.iterations() * 1000000);
+}
+
+BENCHMARK(RewindToEarlierCycle)->Arg(10000)->Arg(100000)->Iterations(200)->Unit(benchmark::kMicrosecond);
+BENCHMARK(RunRecording)->Arg(10000)->Arg(100000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(RunPlain)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,61 @@
+#include "benchmark/benchmark.h"
+#include "6502Scheduler.h"
+#include <memory>
+#include <vector>
+
+//512 CPUs on one thread, each walking its own tables over 5 pages: X = table[X] and so on
+static constexpr size_t INSTANCES = 512;
+static constexpr uint64_t CYCLES = 20000;
+
+static std::vector<std::unique_ptr<m6502::CPU>> MakeCPUs(m6502::VirtualClock& clock) {
+    const m6502::byte program[] {
+            m6502::CPU::INS_LDA_ABSX, 0x00, 0x03,
+            m6502::CPU::INS_STA_ABSX, 0x00, 0x04,
+            m6502::CPU::INS_LDY_ABSX, 0x00, 0x05,
+            m6502::CPU::INS_STA_ABSY, 0x00, 0x06,
+            m6502::CPU::INS_LDX_ABSY, 0x00, 0x07,
+            m6502::CPU::INS_JMP_ABS, 0x00, 0x80};
+    std::vector<std::unique_ptr<m6502::CPU>> cpus;
+    for (size_t i{0}; i < INSTANCES; ++i) {
+        cpus.emplace_back(new m6502::CPU{clock});
+        m6502::CPU& cpu = *cpus.back();
+        for (size_t j{0}; j < sizeof program; ++j)
+            cpu.mem[0x8000 + j] = program[j];
+        for (m6502::dword j{0}; j < 0x100; ++j) {
+            cpu.mem[0x0300 + j] = static_cast<m6502::byte>(j * 7 + i);
+            cpu.mem[0x0500 + j] = static_cast<m6502::byte>(j * 13 + 1);
+            cpu.mem[0x0700 + j] = static_cast<m6502::byte>(j * 5 + 3 + i);
+        }
+        cpu.PC = 0x8000;
+    }
+    return cpus;
+}
+
+//each CPU in turn for a fixed 1000 cycles
+static void FixedQuantumRoundRobin(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    auto cpus = MakeCPUs(clock);
+    for (auto _ : st) {
+        for (uint64_t done{0}; done < CYCLES; done += 1000)
+            for (auto& cpu : cpus)
+                cpu->execute(UINT64_MAX, 1000);
+    }
+    st.counters["cycles/s"] = benchmark::Counter(static_cast<double>(INSTANCES * CYCLES * st.iterations()), benchmark::Counter::kIsRate);
+}
+
+static void FootprintScheduler(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    auto cpus = MakeCPUs(clock);
+    m6502::Scheduler scheduler;
+    for (auto& cpu : cpus) scheduler.add(*cpu);
+    for (auto _ : st)
+        scheduler.run(CYCLES);
+    const m6502::Scheduler::Stats& stats = scheduler.getStats();
+    st.counters["cycles/s"] = benchmark::Counter(static_cast<double>(INSTANCES * CYCLES * st.iterations()), benchmark::Counter::kIsRate);
+    st.counters["quantum"] = stats.averageQuantum();
+    st.counters["fairness"] = stats.fairness;
+    st.counters["footprint_KB"] = static_cast<double>(stats.footprintBytes) / 1024;
+}
+
+BENCHMARK(FixedQuantumRoundRobin)->Unit(benchmark::TimeUnit::kMillisecond);
+BENCHMARK(FootprintScheduler)->Unit(benchmark::TimeUnit::kMillisecond);
@@ -0,0 +1,45 @@
+#include "benchmark/benchmark.h"
+#include "6502.h"
+
+//a machine using 64 pages, a job writing one byte into each of range(0) of them, then back to the snapshot.
+//the job is timed too, pausing the timer would cost more than the restore.
+static void SetUpMachine(m6502::CPU& cpu) {
+    for (m6502::dword page{0}; page < 64; ++page)
+        cpu.mem[page * 0x100 + 0x80] = static_cast<m6502::byte>(page + 1);
+}
+
+static void Job(m6502::CPU& cpu, m6502::dword pages) {
+    for (m6502::dword page{0}; page < pages; ++page)
+        cpu.mem.write(static_cast<m6502::word>(page * 0x100 + 0x42), 0x37);
+    cpu.A = 0x42;
+}
+
+static void RestoreSnapshot(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    SetUpMachine(cpu);
+    m6502::CPU::Snapshot snapshot = cpu.snapshot();
+    const auto pages = static_cast<m6502::dword>(st.range(0));
+    for (auto _ : st) {
+        Job(cpu, pages);
+        cpu.restore(snapshot);
+    }
+    benchmark::DoNotOptimize(cpu.mem.read(0x0042));
+}
+
+//the same going back by assigning a saved copy of the whole CPU
+static void AssignCopy(benchmark::State& st) {
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    SetUpMachine(cpu);
+    const m6502::CPU saved{cpu};
+    const auto pages = static_cast<m6502::dword>(st.range(0));
+    for (auto _ : st) {
+        Job(cpu, pages);
+        cpu = saved;
+    }
+    benchmark::DoNotOptimize(cpu.mem.read(0x0042));
+}
+
+BENCHMARK(RestoreSnapshot)->Arg(1)->Arg(4)->Arg(32);
+BENCHMARK(AssignCopy)->Arg(1)->Arg(4)->Arg(32);
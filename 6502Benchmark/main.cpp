@@ -1,3 +1,108 @@
 #include "benchmark/benchmark.h"
+#include "_6502BenchmarkBaseline.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
 
-BENCHMARK_MAIN();
+/* Runs like BENCHMARK_MAIN() unless a baseline mode is given:
+ *   --baseline=save       store the results in <baseline_dir>/<baseline_name>.json
+ *   --baseline=compare    compare against that file and exit with 1 on a significant regression
+ *   --baseline_dir=DIR            default "benchmark_baselines"
+ *   --baseline_name=NAME          default "default"
+ *   --baseline_threshold=FRACTION smallest relative change counted as a regression, default 0.05
+ * Baseline modes run 9 repetitions unless --benchmark_repetitions is given. */
+static bool parseFlag(const char* arg, const char* flag, std::string& value) {
+    const size_t length = std::strlen(flag);
+    if (std::strncmp(arg, flag, length) != 0 || arg[length] != '=') return false;
+    value = arg + length + 1;
+    return true;
+}
+
+//a relative change, a finite fraction of 0 or more
+static bool parseThreshold(const std::string& text, double& value) {
+    if (text.empty()) return false;
+    char* end;
+    errno = 0;
+    value = std::strtod(text.c_str(), &end);
+    return *end == '\0' && errno == 0 && std::isfinite(value) && value >= 0;
+}
+
+//dir and every directory above it that is missing, like mkdir -p
+static bool makeDirectories(const std::string& dir) {
+    for (size_t slash = dir.find('/', 1);; slash = dir.find('/', slash + 1)) {
+        const std::string part = dir.substr(0, slash);
+        if (mkdir(part.c_str(), 0755) != 0) {
+            const int error = errno;
+            struct stat status{};
+            if (error != EEXIST || stat(part.c_str(), &status) != 0 || !S_ISDIR(status.st_mode)) {
+                std::fprintf(stderr, "could not create directory %s: %s\n", part.c_str(), std::strerror(error == EEXIST ? ENOTDIR : error));
+                return false;
+            }
+        }
+        if (slash == std::string::npos) return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string mode, dir{"benchmark_baselines"}, name{"default"}, threshold{"0.05"};
+    bool repetitionsGiven{false};
+    std::vector<char*> args;
+    for (int i{0}; i < argc; ++i) {
+        if (parseFlag(argv[i], "--baseline", mode) || parseFlag(argv[i], "--baseline_dir", dir) ||
+            parseFlag(argv[i], "--baseline_name", name) || parseFlag(argv[i], "--baseline_threshold", threshold))
+            continue;
+        repetitionsGiven |= std::strncmp(argv[i], "--benchmark_repetitions", 23) == 0;
+        args.push_back(argv[i]);
+    }
+    if (!mode.empty() && mode != "save" && mode != "compare") {
+        std::fprintf(stderr, "unknown --baseline mode '%s', expected save or compare\n", mode.c_str());
+        return 1;
+    }
+    double changeThreshold;
+    if (!parseThreshold(threshold, changeThreshold)) {
+        std::fprintf(stderr, "invalid --baseline_threshold '%s', expected a fraction of 0 or more\n", threshold.c_str());
+        return 1;
+    }
+    char repetitions[] = "--benchmark_repetitions=9";
+    if (!mode.empty() && !repetitionsGiven) args.push_back(repetitions);
+    int benchmarkArgc = static_cast<int>(args.size());
+    args.push_back(nullptr);
+
+    benchmark::Initialize(&benchmarkArgc, args.data());
+    if (benchmark::ReportUnrecognizedArguments(benchmarkArgc, args.data())) return 1;
+    baseline::Reporter reporter;
+    benchmark::RunSpecifiedBenchmarks(&reporter);
+    benchmark::Shutdown();
+    if (mode.empty()) return 0;
+
+    const std::string path = dir + "/" + name + ".json";
+    if (mode == "save") {
+        if (!makeDirectories(dir)) return 1;
+        if (!baseline::write(reporter.results(), path)) {
+            std::fprintf(stderr, "could not write baseline %s\n", path.c_str());
+            return 1;
+        }
+        std::printf("baseline saved to %s\n", path.c_str());
+        return 0;
+    }
+
+    baseline::Results before;
+    if (!baseline::read(before, path)) {
+        std::fprintf(stderr, "could not read baseline %s\n", path.c_str());
+        return 1;
+    }
+    int regressions{0};
+    std::printf("\n%-60s %-10s %14s %14s %9s\n", "Benchmark", "Metric", "Baseline", "Current", "Change");
+    for (const baseline::Comparison& c : baseline::compare(before, reporter.results(), changeThreshold)) {
+        std::printf("%-60s %-10s %14.4g %14.4g %+8.2f%%%s\n", c.name.c_str(), c.throughput ? "cycles/s" : "time(ns)",
+                    c.before.median, c.after.median, 100 * c.change, c.regression ? "  REGRESSION" : "");
+        regressions += c.regression;
+    }
+    std::printf("%d significant regression(s) against %s\n", regressions, path.c_str());
+    return regressions ? 1 : 0;
+}
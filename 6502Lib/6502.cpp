@@ -1,14 +1,24 @@
 #include "6502.h"
+#include <algorithm>
 
 //return the number of cycles that were used
-m6502::dword m6502::CPU::execute(uint64_t instructionsToExecute) {
+m6502::dword m6502::CPU::execute(uint64_t instructionsToExecute, sdword cycleBudget) {
     cycles.reset();
+    halted = false;
+    const uint64_t instructionsRequested = instructionsToExecute;
 
     auto loadRegister = [this](byte value, byte& Register) {
         Register = value;
         loadRegisterSetStatus(Register);
     };
-    while(instructionsToExecute--) {
+    while(instructionsToExecute && cycles.getCycles() < cycleBudget) {
+        if (interrupts && takeInterrupt()) continue;
+        instructionsToExecute--;
+        //device pages hold no code, an opcode from one stops the CPU like one it does not know
+        if (__builtin_expect(mem.isMapped(PC >> 8), 0)) {
+            fetchByte();
+            goto INSTRUCTION_NOT_HANDLED;
+        }
         byte instruction{fetchByte()};
         switch (instruction) {
             case INS_LDA_IM : /*2 cycles*/ {
@@ -228,25 +238,87 @@ m6502::dword m6502::CPU::execute(uint64_t instructionsToExecute) {
                 SP = X;
                 fetchByte();
             } break;
+            case INS_BRK : /*7 cycles*/ {
+                fetchByte();    //the byte after BRK is skipped
+                enterInterrupt(IRQ_VECTOR, true);
+            } break;
+            case INS_RTI : /*6 cycles*/ {
+                readByte(PC);
+                PS = pullByteFromStack(true, true);
+                byte PCL = pullByteFromStack(false, true);
+                byte PCH = pullByteFromStack();
+                PC = (PCH << 8) | PCL;
+            } break;
             default: {
                 goto INSTRUCTION_NOT_HANDLED;
             }
         }
     }
+    instructionsExecuted = instructionsRequested - instructionsToExecute;
+    return cycles.getCycles();
     INSTRUCTION_NOT_HANDLED:
+    //the unknown opcode was counted down but not executed
+    instructionsExecuted = instructionsRequested - instructionsToExecute - 1;
+    halted = true;
     return cycles.getCycles();
 }
 
+uint64_t m6502::CPU::run(uint64_t budget, bool& stopped) {
+    uint64_t used{0}, instructions{0};
+    while (used < budget && !stopped) {
+        const auto slice = static_cast<sdword>(std::min<uint64_t>(budget - used, INT32_MAX));
+        ranBefore = used;
+        const dword spent = execute(UINT64_MAX, slice);
+        //its fetch may have used up the budget just as well
+        stopped = halted;
+        used += spent;
+        instructions += instructionsExecuted;
+    }
+    ranBefore = 0;
+    instructionsExecuted = instructions;
+    return used;
+}
+
+m6502::CPU::Snapshot m6502::CPU::snapshot() {
+    return Snapshot{PC, SP, A, X, Y, PS, cycles.getCycles(), instructionsExecuted, interrupts, mem.checkpoint()};
+}
+
+void m6502::CPU::restore(const Snapshot& snapshot) {
+    PC = snapshot.PC;
+    SP = snapshot.SP;
+    A = snapshot.A;
+    X = snapshot.X;
+    Y = snapshot.Y;
+    PS = snapshot.PS;
+    cycles.setCycles(snapshot.cycles);
+    instructionsExecuted = snapshot.instructionsExecuted;
+    interrupts = snapshot.interrupts;
+    mem.revert(snapshot.mem);
+}
+
+std::vector<m6502::CPU> m6502::CPU::fork(size_t children) const {
+    return std::vector<CPU>(children, *this);
+}
+
+uint64_t m6502::CPU::hash() const {
+    const uint64_t registers = PC | uint64_t{SP} << 16 | uint64_t{A} << 24 | uint64_t{X} << 32 | uint64_t{Y} << 40 |
+                               uint64_t{PS.to_ulong()} << 48;
+    //odd multipliers, so registers that differ always change the hash of the same memory
+    return mem.hash() * 0xD6E8FEB86659FD93ull + (registers + 1) * 0x9E3779B97F4A7C15ull;
+}
+
 void m6502::CPU::reset() {
-    PC = mem[0xFFFC] | (mem[0xFFFD] << 8);
+    PC = mem.read(RESET_VECTOR) | (mem.read(RESET_VECTOR + 1) << 8);
     SP = 0xFF;
     PS.reset();
     A = X = Y = 0;
+    //nmiEdges keeps counting, recorders compare against it
+    interrupts = 0;
 }
 
 m6502::byte m6502::CPU::readByte(word address) {
     CyclesIncrementer cd(cycles);
-    return mem[address];
+    return mem.read(address);
 }
 
 m6502::word m6502::CPU::readWord(word address) {
@@ -256,7 +328,7 @@ m6502::word m6502::CPU::readWord(word address) {
 
 m6502::byte m6502::CPU::fetchByte() {
     CyclesIncrementer cd(cycles);
-    return mem[PC++];
+    return mem.fetch(PC++);
 }
 
 /*    6502 is little Endian which means that the first byte read
@@ -281,7 +353,7 @@ void m6502::CPU::writeWord(word data, word address) {
 }
 
 void m6502::CPU::writeByte(byte data, word address) {
-    mem[address] = data;
+    mem.write(address, data);
     ++cycles;
 }
 
@@ -296,6 +368,34 @@ void m6502::CPU::bitInstructionSetStatus(byte result) {
     PS.set(StatusFlags::V, (result & 0x40) >> 6);
 }
 
+bool m6502::CPU::takeInterrupt() {
+    word vector;
+    if (interrupts & NMI) {
+        interrupts &= ~NMI;
+        vector = NMI_VECTOR;
+    } else if (!PS.test(StatusFlags::I)) {
+        vector = IRQ_VECTOR;
+    } else {
+        return false;
+    }
+    //two reads of the next opcode that are thrown away
+    readByte(PC);
+    readByte(PC);
+    enterInterrupt(vector, false);
+    return true;
+}
+
+void m6502::CPU::enterInterrupt(word vector, bool brk) {
+    pushWordToStack(PC);
+    //B only tells BRK from IRQ on the stack, U always reads as 1
+    std::bitset<StatusFlags::numFlags> pushed{PS};
+    pushed.set(StatusFlags::B, brk);
+    pushed.set(StatusFlags::U);
+    pushByteToStack(static_cast<byte>(pushed.to_ulong()));
+    PS.set(StatusFlags::I);
+    PC = readWord(vector);
+}
+
 void m6502::CPU::pushByteToStack(byte data) {
     writeByte(data, SPToAddress());
     SP--;
@@ -416,3 +516,8 @@ m6502::word m6502::CPU::writeAddrIndirectY() {
     ++cycles;
     return address + Y;
 }
+
+std::shared_ptr<m6502::Clock> m6502::CPU::makeClock(double Mhz) {
+    if (Mhz > 0) return std::make_shared<TSCClock>(Mhz);
+    return std::make_shared<VirtualClock>();
+}
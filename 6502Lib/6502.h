@@ -1,16 +1,14 @@
 #ifndef INC_6502_EMULATION_6502_H
 #define INC_6502_EMULATION_6502_H
 
-#include <iostream>
-#include <chrono>
 #include <bitset>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "6502Clock.h"
+#include "6502Memory.h"
 
 namespace m6502 {
-    typedef uint8_t byte;
-    typedef uint16_t word;
-    typedef uint32_t dword;
-    typedef int32_t sdword;
-
     struct CPU;
 }
 
@@ -18,41 +16,39 @@ struct m6502::CPU {
     word PC;    //program counter
     byte SP;    //stack pointer
     byte A, X, Y;   //registers
-
-    static dword cycleDuration;
+    uint64_t instructionsExecuted{0};   //by the last call to execute() or run()
+    bool halted{false};                 //the last execute() came back on an opcode it does not know
 
     /*carry, zero, interrupt disable, decimal mode, break command,
      * unused-always 1, overflow, negative*/
     enum StatusFlags {C, Z, I, D, B, U, V, N, numFlags};
     std::bitset<StatusFlags::numFlags> PS;
 
-    struct Mem {
-        static constexpr dword MAX_MEM = 1024 * 64;
-        byte data[MAX_MEM];
-
-        Mem() {initialize();}
-        void initialize() { for (dword i{0}; i < MAX_MEM; i++) data[i] = 0; }
-        byte operator[](dword address) const { return data[address]; }
-        byte& operator[](dword address) { return data[address]; }
-    };
+    typedef Memory Mem;
     Mem mem;
 
+    /*interrupt lines, one bit each so that execute() checks for all of them in one test per
+     * instruction. IRQ is a level, taken while it is asserted and I is clear, NMI an edge,
+     * taken once per nmi() call*/
+    enum Interrupts : byte {IRQ = 1, NMI = 2};
+    byte interrupts{0};
+    //nmi() calls so far, which tell an edge from one still pending, see InputRecorder
+    uint64_t nmiEdges{0};
+    void irq(bool asserted) { interrupts = asserted ? interrupts | IRQ : interrupts & ~IRQ; }
+    void nmi() {
+        interrupts |= NMI;
+        nmiEdges++;
+    }
+    static constexpr word NMI_VECTOR = 0xFFFA, RESET_VECTOR = 0xFFFC, IRQ_VECTOR = 0xFFFE;
+
+    //clock created by CPU(double), shared by copies of this CPU
+    std::shared_ptr<Clock> ownedClock;
+    static std::shared_ptr<Clock> makeClock(double Mhz);
     struct Cycles {
-        explicit Cycles(double Mhz = 1) : cycles{0} {
-            setCycleDuration(Mhz);
-        };
-        static dword getTCSFrequency() {
-            int eax{};
-            __asm__("mov $0x16, %eax\n\t");
-            __asm__("cpuid\n\t");
-            __asm__("mov %%eax, %0\n\t":"=r" (eax));
-            return eax;
-        }
+        explicit Cycles(Clock& clock) : cycles{0}, clock{&clock} {}
         Cycles&  operator++(){
             ++cycles;
-            //busy wait. There is no other way.
-            while((__builtin_ia32_rdtsc() - startTimePoint) < cycleDuration);
-            startTimePoint = __builtin_ia32_rdtsc();
+            if(clock->isPaced()) clock->tick();
             return *this;
         }
         Cycles& operator+=(sdword num) {
@@ -64,16 +60,15 @@ struct m6502::CPU {
         bool operator> (sdword other) const {return cycles > other;}
         void reset() {
             cycles = 0;
-            startTimePoint = __builtin_ia32_rdtsc();
+            clock->start();
         }
         sdword getCycles() const {return cycles;}
-        void setCycleDuration(double Mhz) {
-            cycleDuration = (getTCSFrequency() - (30 * Mhz)) / Mhz;
-        }
+        void setCycles(sdword value) {cycles = value;}
+        Clock& getClock() const {return *clock;}
+        void setClock(Clock& newClock) {clock = &newClock;}
     private:
         sdword cycles;
-        uint64_t startTimePoint;
-        uint64_t cycleDuration;
+        Clock* clock;
     };
     Cycles cycles;
 
@@ -111,12 +106,43 @@ struct m6502::CPU {
     //Register Transfers
     INS_TXA_IMP = 0x8A,
     INS_TAX_IMP = 0xAA,
-    INS_TAY_IMP = 0xA8;
+    INS_TAY_IMP = 0xA8,
+    //System Functions
+    INS_BRK = 0x00,
+    INS_RTI = 0x40,
+    //halts a real 6502; execute() stops on it as on every opcode it does not know
+    INS_JAM = 0x02;
 
-    explicit CPU(double Mhz = 1) {
+    //paced at Mhz by the time stamp counter, a frequency of 0 runs unthrottled
+    explicit CPU(double Mhz = 1) : ownedClock{makeClock(Mhz)}, cycles{*ownedClock} {
         reset();
-        cycles.setCycleDuration(Mhz);
     };
+    //paced by a clock the caller owns and keeps alive, e.g. a VirtualClock for tests
+    explicit CPU(Clock& clock) : cycles{clock} {
+        reset();
+    };
+    //everything execute() depends on, memory included
+    struct Snapshot {
+        word PC;
+        byte SP, A, X, Y;
+        std::bitset<StatusFlags::numFlags> PS;
+        sdword cycles;
+        uint64_t instructionsExecuted;
+        byte interrupts;
+        Mem mem;
+    };
+    //costs the pages memory uses, shared with the snapshot until either side writes
+    Snapshot snapshot();
+    //costs the pages written since the snapshot when it is the last one taken, the pages used otherwise
+    void restore(const Snapshot& snapshot);
+    /* children copies of this CPU that share its memory pages until one of them writes; each
+     * costs the pages memory uses, like snapshot(), but copies none of them. They run on the
+     * clock of this CPU; give them their own with cycles.setClock() before running them on
+     * other threads */
+    std::vector<CPU> fork(size_t children) const;
+    //of the registers and memory, costs what Memory::hash() costs
+    uint64_t hash() const;
+
     void reset();
     word readWord(word address);
     byte readByte(word address);
@@ -126,7 +152,14 @@ struct m6502::CPU {
     void writeByte(byte data, word address);
     void loadRegisterSetStatus(byte Register);
     void bitInstructionSetStatus(byte result);
-    dword execute(uint64_t instructionsToExecute = 1);
+    //stops after instructionsToExecute instructions, or at the end of the instruction that used up cycleBudget
+    dword execute(uint64_t instructionsToExecute = 1, sdword cycleBudget = INT32_MAX);
+    /* runs for budget cycles, up to an instruction more, and returns the cycles used. Sets
+     * stopped, and runs nothing once it is set, when the CPU hit an opcode it does not know.
+     * instructionsExecuted counts those of the whole run */
+    uint64_t run(uint64_t budget, bool& stopped);
+    //the cycles used so far by the run() or execute() going on, for devices and handlers called during one
+    uint64_t runCycles() const { return ranBefore + static_cast<uint64_t>(cycles.getCycles()); }
     //read instructions which return the byte in memory at the address for the given addressing mode
     inline word readAddrZeroPage();
     inline word readAddrZeroPageX();
@@ -147,10 +180,17 @@ struct m6502::CPU {
     inline word writeAddrXIndirect();
     inline word writeAddrIndirectY();
 
+    //takes a pending interrupt that is not masked, false when there is none
+    bool takeInterrupt();
+    //pushes PC and PS and jumps through vector, the end of BRK and of every interrupt
+    void enterInterrupt(word vector, bool brk);
     void pushByteToStack(byte data);
     void pushWordToStack(word data);
     word SPToAddress(bool incrementSP=false);
     byte pullByteFromStack(bool incSPBefore = false, bool incSPAfter = false);
+
+private:
+    uint64_t ranBefore{0};  //by the run() going on, before the execute() it is in
 };
 
 #endif //INC_6502_EMULATION_6502_H
\ No newline at end of file
@@ -0,0 +1,44 @@
+#ifndef INC_6502_EMULATION_6502BARRIER_H
+#define INC_6502_EMULATION_6502BARRIER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+namespace m6502 {
+    class Barrier;
+}
+
+/* Where a fixed number of threads wait for each other, once per quantum or window, so it can
+ * be used again right away. Waiting spins for a while and then gives the host CPU away, which
+ * matters once the threads outnumber the host's CPUs. */
+class m6502::Barrier {
+public:
+    explicit Barrier(size_t parties) : parties(parties) {}
+    Barrier(const Barrier&) = delete;
+    Barrier& operator=(const Barrier&) = delete;
+
+    void wait() {
+        const uint64_t phase = generation.load(std::memory_order_acquire);
+        if (arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == parties) {
+            arrived.store(0, std::memory_order_relaxed);
+            generation.store(phase + 1, std::memory_order_release);
+            return;
+        }
+        for (unsigned spins{0}; generation.load(std::memory_order_acquire) == phase;) relax(spins);
+    }
+
+    //one round of waiting for something another thread does
+    static void relax(unsigned& spins) {
+        if (++spins < 64) __builtin_ia32_pause();
+        else std::this_thread::yield();
+    }
+
+private:
+    const size_t parties;
+    std::atomic<size_t> arrived{0};
+    std::atomic<uint64_t> generation{0};
+};
+
+#endif //INC_6502_EMULATION_6502BARRIER_H
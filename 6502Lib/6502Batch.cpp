@@ -0,0 +1,147 @@
+#include "6502Batch.h"
+#include <algorithm>
+#include <chrono>
+
+m6502::BatchRunner::BatchRunner(unsigned threads, bool numaAware) {
+    threads = std::max(threads, 1u);
+    const NumaTopology topology = numaAware ? NumaTopology::detect() : NumaTopology{};
+    for (unsigned i{0}; i < threads; ++i) {
+        workers.emplace_back(new Worker{});
+        workers.back()->node = numaAware ? topology.getNodes()[i % topology.size()] : NumaTopology::Node{-1, {}};
+    }
+    for (size_t i{0}; i < workers.size(); ++i)
+        workers[i]->thread = std::thread{&BatchRunner::work, this, i};
+}
+
+m6502::BatchRunner::~BatchRunner() {
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers)
+        worker->thread.join();
+}
+
+std::vector<m6502::BatchResult> m6502::BatchRunner::run(const std::vector<BatchJob>& batch) {
+    std::vector<BatchResult> batchResults(batch.size());
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        jobs = &batch;
+        results = &batchResults;
+        for (size_t i{0}; i < workers.size(); ++i) {
+            Worker& worker = *workers[i];
+            std::lock_guard<std::mutex> queueLock{worker.mutex};
+            worker.instructions = worker.cycles = worker.steals = worker.localPages = worker.remotePages = 0;
+            for (size_t job = batch.size() * i / workers.size(); job < batch.size() * (i + 1) / workers.size(); ++job)
+                worker.queue.push_back(job);
+        }
+        busyWorkers = workers.size();
+        ++generation;
+        wake.notify_all();
+        done.wait(lock, [this] { return busyWorkers == 0; });
+        jobs = nullptr;
+        results = nullptr;
+    }
+    stats = Stats{};
+    stats.jobs = batch.size();
+    for (auto& worker : workers) {
+        stats.instructions += worker->instructions;
+        stats.cycles += worker->cycles;
+        stats.steals += worker->steals;
+        stats.localPages += worker->localPages;
+        stats.remotePages += worker->remotePages;
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return batchResults;
+}
+
+//own jobs from the back, other workers' jobs from the front so the two ends rarely meet
+bool m6502::BatchRunner::take(size_t self, size_t& job) {
+    {
+        Worker& worker = *workers[self];
+        std::lock_guard<std::mutex> lock{worker.mutex};
+        if (!worker.queue.empty()) {
+            job = worker.queue.back();
+            worker.queue.pop_back();
+            return true;
+        }
+    }
+    //workers on the same node first, so work only crosses nodes once a node has none left
+    Worker& thief = *workers[self];
+    for (bool sameNode : {true, false}) {
+        for (size_t i{1}; i < workers.size(); ++i) {
+            Worker& victim = *workers[(self + i) % workers.size()];
+            if ((victim.node.id == thief.node.id) == sameNode && steal(thief, victim, job)) return true;
+        }
+    }
+    return false;
+}
+
+bool m6502::BatchRunner::steal(Worker& thief, Worker& victim, size_t& job) {
+    std::lock_guard<std::mutex> lock{victim.mutex};
+    if (victim.queue.empty()) return false;
+    job = victim.queue.front();
+    victim.queue.pop_front();
+    thief.steals++;
+    return true;
+}
+
+//asks the kernel where the CPU and every page it uses ended up
+void m6502::BatchRunner::countPlacement(Worker& worker) {
+    std::vector<const void*> addresses{worker.cpu.get()};
+    worker.cpu->mem.usedPages().forEach([&](dword page) { addresses.push_back(worker.cpu->mem.pageData(page)); });
+    for (int node : NumaTopology::nodesOf(addresses)) {
+        if (node == worker.node.id) worker.localPages++;
+        else if (node >= 0) worker.remotePages++;
+    }
+}
+
+void m6502::BatchRunner::work(size_t self) {
+    Worker& worker = *workers[self];
+    if (worker.node.id >= 0) NumaTopology::pinCurrentThread(worker.node);
+    worker.cpu.reset(new CPU{worker.clock});
+    uint64_t seen{0};
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock{mutex};
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+        size_t job;
+        while (take(self, job)) {
+            runJob(*worker.cpu, (*jobs)[job], (*results)[job]);
+            worker.instructions += (*results)[job].instructions;
+            worker.cycles += (*results)[job].cycles;
+        }
+        if (worker.node.id >= 0) countPlacement(worker);
+        std::lock_guard<std::mutex> lock{mutex};
+        if (--busyWorkers == 0) done.notify_one();
+    }
+}
+
+void m6502::BatchRunner::runJob(CPU& cpu, const BatchJob& job, BatchResult& result) {
+    if (job.from) {
+        cpu.restore(*job.from);
+    } else {
+        cpu.mem.initialize();
+        cpu.reset();
+    }
+    for (const BatchJob::Segment& segment : job.image)
+        for (size_t i{0}; i < segment.bytes.size(); ++i)
+            cpu.mem.write(static_cast<word>(segment.address + i), segment.bytes[i]);
+    if (!job.from) cpu.PC = job.start;
+    result.cycles = cpu.execute(job.instructions);
+    result.instructions = cpu.instructionsExecuted;
+    result.memory.resize(job.resultLength);
+    for (word i{0}; i < job.resultLength; ++i)
+        result.memory[i] = cpu.mem.read(static_cast<word>(job.resultAddress + i));
+    result.PC = cpu.PC;
+    result.SP = cpu.SP;
+    result.A = cpu.A;
+    result.X = cpu.X;
+    result.Y = cpu.Y;
+    result.PS = cpu.PS;
+}
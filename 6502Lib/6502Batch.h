@@ -0,0 +1,106 @@
+#ifndef INC_6502_EMULATION_6502BATCH_H
+#define INC_6502_EMULATION_6502BATCH_H
+
+#include "6502.h"
+#include "6502Numa.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace m6502 {
+    struct BatchJob;
+    struct BatchResult;
+    class BatchRunner;
+}
+
+/* an independent program run: load the image, run from start, read back a memory range.
+ * A job with a fork point starts from that state instead of a reset, with the image written
+ * over its memory; jobs share the pages of their fork point until they write them */
+struct m6502::BatchJob {
+    struct Segment {
+        word address;
+        std::vector<byte> bytes;
+    };
+    std::vector<Segment> image;     //ROM and input, copied into zeroed memory or over the fork point's
+    word start;                     //PC the job starts at, unused with a fork point
+    uint64_t instructions;          //budget, the job also ends on an unhandled opcode
+    word resultAddress;
+    word resultLength;
+    std::shared_ptr<const CPU::Snapshot> from;  //fork point, several jobs and threads may share one
+};
+
+struct m6502::BatchResult {
+    std::vector<byte> memory;       //resultLength bytes from resultAddress
+    word PC;
+    byte SP, A, X, Y;
+    std::bitset<CPU::StatusFlags::numFlags> PS;
+    uint64_t instructions;
+    uint64_t cycles;
+};
+
+/* Runs batches of jobs on a fixed set of worker threads. Every worker owns one CPU that it
+ * resets between jobs. Jobs are split into one contiguous block per worker; a worker that
+ * runs out takes from the front of another worker's block. Each job starts from the same
+ * reset state and writes to its own result slot, so results do not depend on scheduling.
+ *
+ * NUMA aware runners spread the workers over the nodes and pin each to the CPUs of its
+ * node. A worker builds its CPU on its own thread, so the first touch puts the CPU and the
+ * pages it writes on that node, and it steals from workers on its own node first. */
+class m6502::BatchRunner {
+public:
+    struct Stats {
+        uint64_t jobs;
+        uint64_t instructions;
+        uint64_t cycles;
+        uint64_t steals;        //jobs run by a worker other than the one they were given to
+        double seconds;         //wall time of the run
+        //pages of the workers' CPUs on their worker's node or elsewhere, NUMA aware runners only
+        uint64_t localPages;
+        uint64_t remotePages;
+        double instructionsPerSecond() const { return seconds > 0 ? instructions / seconds : 0; }
+        double localRatio() const { return localPages + remotePages ? static_cast<double>(localPages) / (localPages + remotePages) : 1; }
+    };
+
+    explicit BatchRunner(unsigned threads = std::thread::hardware_concurrency(), bool numaAware = false);
+    ~BatchRunner();
+    BatchRunner(const BatchRunner&) = delete;
+    BatchRunner& operator=(const BatchRunner&) = delete;
+
+    std::vector<BatchResult> run(const std::vector<BatchJob>& jobs);
+    //of the last run
+    const Stats& getStats() const { return stats; }
+    unsigned threads() const { return static_cast<unsigned>(workers.size()); }
+
+    //runs one job on the given CPU, what every worker does per job
+    static void runJob(CPU& cpu, const BatchJob& job, BatchResult& result);
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<size_t> queue;   //indices into the current batch
+        VirtualClock clock;
+        std::unique_ptr<CPU> cpu;   //built by the worker thread
+        NumaTopology::Node node;    //id -1 when not placed
+        uint64_t instructions, cycles, steals, localPages, remotePages;
+        std::thread thread;
+    };
+
+    void work(size_t self);
+    bool take(size_t self, size_t& job);
+    bool steal(Worker& thief, Worker& victim, size_t& job);
+    static void countPlacement(Worker& worker);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    uint64_t generation{0};
+    size_t busyWorkers{0};
+    bool stopping{false};
+    const std::vector<BatchJob>* jobs{nullptr};
+    std::vector<BatchResult>* results{nullptr};
+    Stats stats{};
+};
+
+#endif //INC_6502_EMULATION_6502BATCH_H
@@ -0,0 +1,146 @@
+#include "6502Board.h"
+#include "6502Barrier.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+constexpr m6502::sdword m6502::Board::DEFAULT_QUANTUM;
+
+//strict mode: the bus of a CPU's memory, shared regions are served here and the rest goes on to the bus it had
+struct m6502::Board::Port : Bus {
+    Board& board;
+    size_t self;
+    Bus* next;
+    Port(Board& board, size_t self, Bus* next) : board(board), self(self), next(next) {}
+
+    byte read(word address) override {
+        SharedRam* ram = board.regionOf(address);
+        if (!ram) return next ? next->read(address) : 0;
+        if (!board.running) return ram->at(address);
+        const uint64_t cycle = board.beginAccess(self);
+        const byte data = ram->at(address);
+        board.endAccess(self, cycle);
+        return data;
+    }
+    void write(word address, byte data) override {
+        SharedRam* ram = board.regionOf(address);
+        if (!ram) {
+            if (next) next->write(address, data);
+            return;
+        }
+        if (!board.running) {
+            ram->at(address) = data;
+            return;
+        }
+        const uint64_t cycle = board.beginAccess(self);
+        ram->at(address) = data;
+        board.endAccess(self, cycle);
+    }
+};
+
+m6502::Board::Board(sdword quantum, bool strict) : quantum(std::max(quantum, 1)), strict(strict) {}
+
+//strict mode: the CPUs outlive their ports, so they get the regions as shared ram and their own bus back
+m6502::Board::~Board() {
+    for (auto& slot : cpus) {
+        if (!slot->port) continue;
+        Memory& mem = slot->cpu->mem;
+        for (auto& region : regions) mem.map(*region);
+        if (slot->port->next) mem.map(*slot->port->next, 0, 0);
+        else mem.unmap(0, 0);
+    }
+}
+
+void m6502::Board::share(word address, dword length) {
+    regions.emplace_back(new SharedRam{address, length});
+    for (auto& slot : cpus) mapShared(*slot, *regions.back());
+}
+
+size_t m6502::Board::add(CPU& cpu) {
+    cpus.emplace_back(new Slot{});
+    Slot& slot = *cpus.back();
+    slot.cpu = &cpu;
+    slot.cycles = elapsed;
+    if (strict) slot.port.reset(new Port{*this, cpus.size() - 1, cpu.mem.getBus()});
+    for (auto& region : regions) mapShared(slot, *region);
+    return cpus.size() - 1;
+}
+
+void m6502::Board::mapShared(Slot& slot, const SharedRam& ram) {
+    if (strict) slot.cpu->mem.map(*slot.port, ram.getAddress() / Page::SIZE, static_cast<dword>(ram.getPages()));
+    else slot.cpu->mem.map(ram);
+}
+
+m6502::SharedRam* m6502::Board::regionOf(word address) const {
+    for (auto& region : regions)
+        if (region->contains(address)) return region.get();
+    return nullptr;
+}
+
+void m6502::Board::run(uint64_t cycles) {
+    const auto start = std::chrono::steady_clock::now();
+    const uint64_t end = elapsed + cycles;
+    for (auto& slot : cpus) {
+        slot->accesses = slot->stalls = 0;
+        slot->next.store(slot->stopped ? UINT64_MAX : slot->cycles, std::memory_order_relaxed);
+    }
+    running = true;
+    Barrier barrier{cpus.size()};
+    std::vector<std::thread> threads;
+    for (size_t i{0}; i < cpus.size(); ++i)
+        threads.emplace_back(&Board::work, this, i, end, std::ref(barrier));
+    for (std::thread& thread : threads) thread.join();
+    running = false;
+
+    stats = Stats{};
+    stats.quanta = (cycles + quantum - 1) / quantum;
+    for (auto& slot : cpus) {
+        stats.cycles += slot->cycles - std::min(slot->cycles, elapsed);
+        stats.sharedAccesses += slot->accesses;
+        stats.stalledAccesses += slot->stalls;
+    }
+    elapsed = end;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void m6502::Board::work(size_t self, uint64_t end, Barrier& barrier) {
+    Slot& slot = *cpus[self];
+    for (uint64_t boundary = elapsed; boundary < end;) {
+        boundary = std::min(boundary + quantum, end);
+        //a CPU that overshot the last boundary sits this one out as far as it is ahead
+        if (!slot.stopped && slot.cycles < boundary) {
+            slot.cycles += slot.cpu->run(boundary - slot.cycles, slot.stopped);
+        }
+        if (strict) {
+            //nobody waits for a CPU that is parked here, and nobody goes on before all have said where they are
+            slot.next.store(UINT64_MAX, std::memory_order_release);
+            barrier.wait();
+            slot.next.store(slot.stopped ? UINT64_MAX : slot.cycles, std::memory_order_release);
+        }
+        barrier.wait();
+    }
+}
+
+//ties go to the lower index
+uint64_t m6502::Board::beginAccess(size_t self) {
+    Slot& slot = *cpus[self];
+    const uint64_t cycle = slot.cycles + slot.cpu->runCycles();
+    slot.next.store(cycle, std::memory_order_release);
+    slot.accesses++;
+    bool stalled{false};
+    for (size_t other{0}; other < cpus.size(); ++other) {
+        if (other == self) continue;
+        const std::atomic<uint64_t>& next = cpus[other]->next;
+        for (unsigned spins{0};; Barrier::relax(spins)) {
+            const uint64_t at = next.load(std::memory_order_acquire);
+            if (at > cycle || (at == cycle && other > self)) break;
+            stalled = true;
+        }
+    }
+    slot.stalls += stalled;
+    return cycle;
+}
+
+void m6502::Board::endAccess(size_t self, uint64_t cycle) {
+    cpus[self]->next.store(cycle + 1, std::memory_order_release);
+}
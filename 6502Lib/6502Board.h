@@ -0,0 +1,103 @@
+#ifndef INC_6502_EMULATION_6502BOARD_H
+#define INC_6502_EMULATION_6502BOARD_H
+
+#include "6502.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace m6502 {
+    class Barrier;
+    class Board;
+}
+
+/* Several CPUs on one board, a host and a disk controller say, each with its own memory but
+ * sharing the RAM of the regions declared with share(). run() gives every CPU a thread of its
+ * own and lets them run a quantum of cycles at a time, with a barrier after each quantum, so
+ * no CPU gets more than a quantum ahead of another.
+ *
+ * Shared RAM is mapped into every memory as SharedRam: reads, writes and fetches go straight
+ * to it and cost what any other access costs. Within a quantum the CPUs run freely, so which
+ * of two accesses from different CPUs goes first depends on the host.
+ *
+ * In strict mode accesses to the shared regions are serialized in emulated time instead: an
+ * access at cycle t waits until every other CPU has got past t, or is at t with a higher
+ * index, which makes a run independent of the host. The one exception is the last
+ * instruction of a quantum, which may run a few cycles past its end: its accesses go before
+ * those of CPUs that stopped short of them, so results still depend on the quantum there.
+ * The regions go through a bus for that, so in strict mode they hold no code, and a CPU that
+ * reaches a shared access waits for the slowest other CPU to reach its next shared access or
+ * the end of its quantum. Add CPUs after attaching their devices, the board forwards the rest
+ * of the bus to them.
+ *
+ * The CPUs belong to the caller and stay where they are; the board only keeps pointers. They
+ * may outlive it: its regions stay in their memories as shared ram, in strict mode too, and
+ * the rest of the bus goes to their devices again. */
+class m6502::Board {
+public:
+    static constexpr sdword DEFAULT_QUANTUM = 1000;
+
+    struct Stats {
+        uint64_t quanta;
+        uint64_t cycles;            //of all CPUs together
+        uint64_t sharedAccesses;    //strict mode only
+        uint64_t stalledAccesses;   //that had to wait for another CPU, strict mode only
+        double seconds;
+        double cyclesPerSecond() const { return seconds > 0 ? cycles / seconds : 0; }
+    };
+
+    explicit Board(sdword quantum = DEFAULT_QUANTUM, bool strict = false);
+    ~Board();
+    Board(const Board&) = delete;
+    Board& operator=(const Board&) = delete;
+
+    //pages of [address, address + length) are shared by every CPU, those added already included
+    void share(word address, dword length);
+    size_t add(CPU& cpu);
+    size_t size() const { return cpus.size(); }
+
+    //every CPU runs for cycles more cycles, or until it stops on an unhandled opcode
+    void run(uint64_t cycles);
+    bool isStopped(size_t cpu) const { return cpus[cpu]->stopped; }
+    /* the board cycle a CPU got to. Board cycles count from its construction, a CPU added later
+     * starts at the current one */
+    uint64_t getCycles(size_t cpu) const { return cpus[cpu]->cycles; }
+    uint64_t now() const { return elapsed; }
+    bool isStrict() const { return strict; }
+    //of the last run
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct Port;
+    /* padded by a cache line on either side rather than aligned, which new only honours from
+     * C++17 on: slots are allocated one by one, so no two share a line whatever malloc hands out */
+    struct Slot {
+        char before[64];
+        CPU* cpu;
+        std::unique_ptr<Port> port;     //strict mode only
+        uint64_t cycles;
+        uint64_t accesses, stalls;      //shared, in this run
+        bool stopped;
+        /* strict mode: no shared access of this CPU happens before this cycle, what the others
+         * wait on. UINT64_MAX while it waits at a barrier or once it stopped */
+        std::atomic<uint64_t> next{0};
+        char after[64];
+    };
+
+    void work(size_t self, uint64_t end, Barrier& barrier);
+    //strict mode: waits until the access CPU self is at is the next one in emulated time, returns its cycle
+    uint64_t beginAccess(size_t self);
+    void endAccess(size_t self, uint64_t cycle);
+    SharedRam* regionOf(word address) const;
+    void mapShared(Slot& slot, const SharedRam& ram);
+
+    sdword quantum;
+    bool strict;
+    bool running{false};
+    uint64_t elapsed{0};
+    std::vector<std::unique_ptr<SharedRam>> regions;
+    std::vector<std::unique_ptr<Slot>> cpus;
+    Stats stats{};
+};
+
+#endif //INC_6502_EMULATION_6502BOARD_H
@@ -0,0 +1,59 @@
+#include "6502Clock.h"
+#include <chrono>
+#include <cpuid.h>
+
+/*CPUID leaf 0x16 reports the TSC (base) frequency on recent Intel parts. Elsewhere, AMD and
+ * most hypervisors, it reads 0 so the TSC is timed against steady_clock once instead.*/
+static uint32_t measureTCSFrequency() {
+    unsigned int eax{}, ebx{}, ecx{}, edx{};
+    if (__get_cpuid_max(0, nullptr) >= 0x16) {
+        __cpuid(0x16, eax, ebx, ecx, edx);
+        if (eax) return eax;
+    }
+    auto start = std::chrono::steady_clock::now();
+    uint64_t startTSC = __builtin_ia32_rdtsc();
+    while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(20));
+    uint64_t ticks = __builtin_ia32_rdtsc() - startTSC;
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    return static_cast<uint32_t>(ticks * 1000 / elapsed.count());
+}
+
+uint32_t m6502::TSCClock::getTCSFrequency() {
+    static const uint32_t frequency{measureTCSFrequency()};
+    return frequency;
+}
+
+//a few ticks per cycle go to the loop itself, the wait is shortened by that much
+void m6502::TSCClock::setCycleDuration(double Mhz) {
+    cycleDuration = (getTCSFrequency() - (30 * Mhz)) / Mhz;
+    stats.requestedMhz = Mhz;
+    resetPacingStats();
+}
+
+void m6502::TSCClock::resetPacingStats() {
+    const double Mhz = stats.requestedMhz;
+    stats = PacingStats{};
+    stats.requestedMhz = Mhz;
+    stats.idealTicks = static_cast<uint64_t>(getTCSFrequency() / Mhz);
+}
+
+double m6502::TSCClock::PacingStats::achievedMhz() const {
+    return ticks ? cycles * static_cast<double>(getTCSFrequency()) / ticks : 0;
+}
+
+double m6502::TSCClock::PacingStats::driftMicroseconds() const {
+    return (static_cast<double>(ticks) - static_cast<double>(cycles) * idealTicks) / getTCSFrequency();
+}
+
+double m6502::TSCClock::PacingStats::driftPPM() const {
+    return cycles ? 1e6 * (static_cast<double>(ticks) / (static_cast<double>(cycles) * idealTicks) - 1) : 0;
+}
+
+uint64_t m6502::TSCClock::PacingStats::overshootPercentile(double fraction) const {
+    uint64_t seen{0};
+    for (int i{0}; i < BUCKETS; ++i) {
+        seen += overshoot[i];
+        if (seen && seen >= fraction * cycles) return i ? (uint64_t{1} << i) - 1 : 0;
+    }
+    return maxOvershoot;
+}
@@ -0,0 +1,88 @@
+#ifndef INC_6502_EMULATION_6502CLOCK_H
+#define INC_6502_EMULATION_6502CLOCK_H
+
+#include <cstdint>
+
+namespace m6502 {
+    struct Clock;
+    struct VirtualClock;
+    struct TSCClock;
+}
+
+//timing source the CPU paces its cycles against
+struct m6502::Clock {
+    virtual ~Clock() = default;
+    //called when execute() starts, time between two executes is not paced
+    virtual void start() = 0;
+    //returns once the next emulated cycle is due
+    virtual void tick() = 0;
+    //clocks that never wait are not ticked at all
+    bool isPaced() const {return paced;}
+protected:
+    explicit Clock(bool paced) : paced{paced} {}
+    bool paced;
+};
+
+//counts cycles exactly but never waits, the CPU runs at host speed
+struct m6502::VirtualClock : Clock {
+    VirtualClock() : Clock{false} {}
+    void start() override {}
+    void tick() override {}
+};
+
+//busy waits on the time stamp counter to run at a fixed frequency
+struct m6502::TSCClock : Clock {
+    /*how closely pacing tracks the requested frequency. Waits are binned by how far they
+     * overshot their deadline: bucket 0 is on time, bucket i holds [2^(i-1), 2^i) TSC ticks.*/
+    struct PacingStats {
+        static constexpr int BUCKETS = 32;
+        double requestedMhz;
+        uint64_t cycles;        //paced cycles since the stats were reset
+        uint64_t ticks;         //TSC ticks those cycles took
+        uint64_t idealTicks;    //TSC ticks per cycle at the requested frequency
+        uint64_t maxOvershoot;
+        uint64_t overshoot[BUCKETS];
+
+        double achievedMhz() const;
+        //how far behind (positive) or ahead of the ideal schedule the paced cycles ran
+        double driftMicroseconds() const;
+        double driftPPM() const;
+        //upper bound in TSC ticks of the bucket holding the given fraction of the waits
+        uint64_t overshootPercentile(double fraction) const;
+    };
+
+    explicit TSCClock(double Mhz = 1) : Clock{true} {
+        setCycleDuration(Mhz);
+        start();
+    }
+    //TSC frequency in MHz
+    static uint32_t getTCSFrequency();
+    void start() override {
+        startTimePoint = __builtin_ia32_rdtsc();
+    }
+    void tick() override {
+        //busy wait. There is no other way.
+        uint64_t now;
+        while(((now = __builtin_ia32_rdtsc()) - startTimePoint) < cycleDuration);
+        const uint64_t previous = startTimePoint;
+        startTimePoint = __builtin_ia32_rdtsc();
+        recordWait(now - previous - cycleDuration, startTimePoint - previous);
+    }
+    void setCycleDuration(double Mhz);
+    const PacingStats& getPacingStats() const {return stats;}
+    void resetPacingStats();
+private:
+    void recordWait(uint64_t overshoot, uint64_t ticks) {
+        stats.cycles++;
+        stats.ticks += ticks;
+        stats.maxOvershoot = overshoot > stats.maxOvershoot ? overshoot : stats.maxOvershoot;
+        int bucket = overshoot ? 64 - __builtin_clzll(overshoot) : 0;
+        stats.overshoot[bucket < PacingStats::BUCKETS ? bucket : PacingStats::BUCKETS - 1]++;
+    }
+
+    uint64_t startTimePoint;
+    uint64_t cycleDuration;
+    PacingStats stats;
+};
+
+#endif //INC_6502_EMULATION_6502CLOCK_H
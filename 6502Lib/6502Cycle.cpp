@@ -0,0 +1,365 @@
+#include "6502Cycle.h"
+#include <array>
+#include <coroutine>
+#include <exception>
+
+//the coroutine, started suspended and only ever resumed by step()
+struct m6502::CycleCPU::Core {
+    struct promise_type {
+        Core get_return_object() { return Core{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+    std::coroutine_handle<promise_type> handle;
+};
+
+//suspends at an access step() is about to do, and hands its data back when resumed
+struct m6502::CycleCPU::BusCycle {
+    CycleCPU& self;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<>) const noexcept {}
+    byte await_resume() const noexcept { return self.access.data; }
+};
+
+namespace {
+    using m6502::CPU;
+    using m6502::byte;
+
+    //how an instruction gets its operand: read modes end with the value, write modes with the address
+    enum class Mode : byte {
+        None, Immediate,
+        ZeroPage, ZeroPageX, ZeroPageY, Absolute, AbsoluteX, AbsoluteY, XIndirect, IndirectY,
+        ZeroPageW, ZeroPageXW, ZeroPageYW, AbsoluteW, AbsoluteXW, AbsoluteYW, XIndirectW, IndirectYW
+    };
+    enum class Operation : byte {
+        Stop, LDA, LDX, LDY, STA, STX, STY, AND, EOR, ORA, BIT,
+        JSR, RTS, JMP, JMPIndirect, PHA, PHP, PLA, PLP, TSX, TXS, BRK, RTI
+    };
+    struct Decoded {
+        Operation operation;
+        Mode mode;
+    };
+
+    constexpr std::array<Decoded, 256> makeDecodeTable() {
+        std::array<Decoded, 256> table{};
+        for (Decoded& entry : table) entry = {Operation::Stop, Mode::None};
+        auto set = [&table](byte opcode, Operation operation, Mode mode) { table[opcode] = {operation, mode}; };
+        //Load/Store Operations
+        set(CPU::INS_LDA_IM, Operation::LDA, Mode::Immediate); set(CPU::INS_LDA_ZP, Operation::LDA, Mode::ZeroPage);
+        set(CPU::INS_LDA_ZPX, Operation::LDA, Mode::ZeroPageX); set(CPU::INS_LDA_ABS, Operation::LDA, Mode::Absolute);
+        set(CPU::INS_LDA_ABSX, Operation::LDA, Mode::AbsoluteX); set(CPU::INS_LDA_ABSY, Operation::LDA, Mode::AbsoluteY);
+        set(CPU::INS_LDA_XIND, Operation::LDA, Mode::XIndirect); set(CPU::INS_LDA_INDY, Operation::LDA, Mode::IndirectY);
+        set(CPU::INS_LDX_IM, Operation::LDX, Mode::Immediate); set(CPU::INS_LDX_ZP, Operation::LDX, Mode::ZeroPage);
+        set(CPU::INS_LDX_ZPY, Operation::LDX, Mode::ZeroPageY); set(CPU::INS_LDX_ABS, Operation::LDX, Mode::Absolute);
+        set(CPU::INS_LDX_ABSY, Operation::LDX, Mode::AbsoluteY);
+        set(CPU::INS_LDY_IM, Operation::LDY, Mode::Immediate); set(CPU::INS_LDY_ZP, Operation::LDY, Mode::ZeroPage);
+        set(CPU::INS_LDY_ZPX, Operation::LDY, Mode::ZeroPageX); set(CPU::INS_LDY_ABS, Operation::LDY, Mode::Absolute);
+        set(CPU::INS_LDY_ABSX, Operation::LDY, Mode::AbsoluteX);
+        set(CPU::INS_STA_ZP, Operation::STA, Mode::ZeroPageW); set(CPU::INS_STA_ZPX, Operation::STA, Mode::ZeroPageXW);
+        set(CPU::INS_STA_ABS, Operation::STA, Mode::AbsoluteW); set(CPU::INS_STA_ABSX, Operation::STA, Mode::AbsoluteXW);
+        set(CPU::INS_STA_ABSY, Operation::STA, Mode::AbsoluteYW); set(CPU::INS_STA_XIND, Operation::STA, Mode::XIndirectW);
+        set(CPU::INS_STA_INDY, Operation::STA, Mode::IndirectYW);
+        set(CPU::INS_STX_ZP, Operation::STX, Mode::ZeroPageW); set(CPU::INS_STX_ZPY, Operation::STX, Mode::ZeroPageYW);
+        set(CPU::INS_STX_ABS, Operation::STX, Mode::AbsoluteW);
+        set(CPU::INS_STY_ZP, Operation::STY, Mode::ZeroPageW); set(CPU::INS_STY_ZPX, Operation::STY, Mode::ZeroPageXW);
+        set(CPU::INS_STY_ABS, Operation::STY, Mode::AbsoluteW);
+        //Logical Operations
+        for (Operation operation : {Operation::AND, Operation::EOR, Operation::ORA}) {
+            const bool isAND = operation == Operation::AND, isEOR = operation == Operation::EOR;
+            set(isAND ? CPU::INS_AND_IM : isEOR ? CPU::INS_EOR_IM : CPU::INS_ORA_IM, operation, Mode::Immediate);
+            set(isAND ? CPU::INS_AND_ZP : isEOR ? CPU::INS_EOR_ZP : CPU::INS_ORA_ZP, operation, Mode::ZeroPage);
+            set(isAND ? CPU::INS_AND_ZPX : isEOR ? CPU::INS_EOR_ZPX : CPU::INS_ORA_ZPX, operation, Mode::ZeroPageX);
+            set(isAND ? CPU::INS_AND_ABS : isEOR ? CPU::INS_EOR_ABS : CPU::INS_ORA_ABS, operation, Mode::Absolute);
+            set(isAND ? CPU::INS_AND_ABSX : isEOR ? CPU::INS_EOR_ABSX : CPU::INS_ORA_ABSX, operation, Mode::AbsoluteX);
+            set(isAND ? CPU::INS_AND_ABSY : isEOR ? CPU::INS_EOR_ABSY : CPU::INS_ORA_ABSY, operation, Mode::AbsoluteY);
+            set(isAND ? CPU::INS_AND_XIND : isEOR ? CPU::INS_EOR_XIND : CPU::INS_ORA_XIND, operation, Mode::XIndirect);
+            set(isAND ? CPU::INS_AND_INDY : isEOR ? CPU::INS_EOR_INDY : CPU::INS_ORA_INDY, operation, Mode::IndirectY);
+        }
+        set(CPU::INS_BIT_ZP, Operation::BIT, Mode::ZeroPage); set(CPU::INS_BIT_ABS, Operation::BIT, Mode::Absolute);
+        //Jumps and Calls, Stack Operations, System Functions
+        set(CPU::INS_JSR, Operation::JSR, Mode::None); set(CPU::INS_RTS, Operation::RTS, Mode::None);
+        set(CPU::INS_JMP_ABS, Operation::JMP, Mode::AbsoluteW); set(CPU::INS_JMP_IND, Operation::JMPIndirect, Mode::AbsoluteW);
+        set(CPU::INS_PHA_IMP, Operation::PHA, Mode::None); set(CPU::INS_PHP_IMP, Operation::PHP, Mode::None);
+        set(CPU::INS_PLA_IMP, Operation::PLA, Mode::None); set(CPU::INS_PLP_IMP, Operation::PLP, Mode::None);
+        set(CPU::INS_TSX_IMP, Operation::TSX, Mode::None); set(CPU::INS_TXS_IMP, Operation::TXS, Mode::None);
+        set(CPU::INS_BRK, Operation::BRK, Mode::None); set(CPU::INS_RTI, Operation::RTI, Mode::None);
+        return table;
+    }
+
+    constexpr std::array<Decoded, 256> decodeTable = makeDecodeTable();
+
+    //the vector of the interrupt to take next, 0 for none; as CPU::takeInterrupt()
+    m6502::word takeInterrupt(CPU& cpu) {
+        if (cpu.interrupts & CPU::NMI) {
+            cpu.interrupts &= ~CPU::NMI;
+            return CPU::NMI_VECTOR;
+        }
+        return cpu.PS.test(CPU::StatusFlags::I) ? 0 : CPU::IRQ_VECTOR;
+    }
+
+    //page crossed by adding index to the low byte of address
+    bool crosses(m6502::word address, byte index) {
+        return (address & 0xFF) + index > 0xFF;
+    }
+}
+
+m6502::CycleCPU::CycleCPU(CPU& cpu) : cpu(cpu), frame(execute().handle.address()) {
+    //up to the first access
+    std::coroutine_handle<>::from_address(frame).resume();
+}
+
+m6502::CycleCPU::~CycleCPU() {
+    std::coroutine_handle<>::from_address(frame).destroy();
+}
+
+bool m6502::CycleCPU::step() {
+    if (stopped) return false;
+    const auto core = std::coroutine_handle<>::from_address(frame);
+    if (atBoundary) {
+        //back to the interrupt check when one is pending by now
+        if (cpu.interrupts) {
+            atBoundary = false;
+            core.resume();
+        } else {
+            access.address = cpu.PC;
+        }
+    }
+    switch (access.kind) {
+        case Access::FETCH: access.data = cpu.mem.fetch(access.address); break;
+        case Access::READ: access.data = cpu.mem.read(access.address); break;
+        case Access::WRITE: cpu.mem.write(access.address, access.data); break;
+        case Access::IDLE: break;
+    }
+    last = access;
+    ++cycle;
+    //the rest of the instruction up to its next access, or to its end
+    core.resume();
+    return true;
+}
+
+m6502::CycleCPU::BusCycle m6502::CycleCPU::fetch() {
+    access = {cpu.PC++, 0, Access::FETCH};
+    return BusCycle{*this};
+}
+
+m6502::CycleCPU::BusCycle m6502::CycleCPU::read(word address) {
+    access = {address, 0, Access::READ};
+    return BusCycle{*this};
+}
+
+m6502::CycleCPU::BusCycle m6502::CycleCPU::write(word address, byte data) {
+    access = {address, data, Access::WRITE};
+    return BusCycle{*this};
+}
+
+m6502::CycleCPU::BusCycle m6502::CycleCPU::idle() {
+    access = {0, 0, Access::IDLE};
+    return BusCycle{*this};
+}
+
+m6502::CycleCPU::BusCycle m6502::CycleCPU::push(byte data) {
+    return write(0x100 | cpu.SP--, data);
+}
+
+//PC moves on once the fetch is done, so that PC can still be changed between instructions
+m6502::CycleCPU::BusCycle m6502::CycleCPU::fetchOpcode() {
+    access = {cpu.PC, 0, Access::FETCH};
+    atBoundary = true;
+    return BusCycle{*this};
+}
+
+//CPU::execute() one bus cycle at a time, its quirks included
+m6502::CycleCPU::Core m6502::CycleCPU::execute() {
+    using Flags = CPU::StatusFlags;
+    for (;;) {
+        if (const word vector = cpu.interrupts ? takeInterrupt(cpu) : 0) {
+            co_await read(cpu.PC);
+            co_await read(cpu.PC);
+            co_await push(cpu.PC >> 8);
+            co_await push(cpu.PC & 0xFF);
+            std::bitset<Flags::numFlags> pushed{cpu.PS};
+            pushed.reset(Flags::B).set(Flags::U);
+            co_await push(static_cast<byte>(pushed.to_ulong()));
+            cpu.PS.set(Flags::I);
+            const byte low = co_await read(vector);
+            cpu.PC = low | (co_await read(vector + 1)) << 8;
+            continue;
+        }
+
+        //step() clears atBoundary when an interrupt came up before the opcode was fetched
+        const byte opcode = co_await fetchOpcode();
+        if (!atBoundary) continue;
+        atBoundary = false;
+        const bool device = cpu.mem.isMapped(cpu.PC >> 8);
+        cpu.PC++;
+        const Decoded decoded = decodeTable[opcode];
+        if (decoded.operation == Operation::Stop || device) {
+            stopped = true;
+            co_return;
+        }
+        instructions++;
+
+        word address{0};
+        byte value{0};
+        switch (decoded.mode) {
+            case Mode::None: break;
+            case Mode::Immediate: {
+                value = co_await fetch();
+            } break;
+            case Mode::ZeroPage: {
+                value = co_await read(co_await fetch());
+            } break;
+            case Mode::ZeroPageX:
+            case Mode::ZeroPageY: {
+                const byte base = co_await fetch();
+                co_await idle();
+                value = co_await read(static_cast<byte>(base + (decoded.mode == Mode::ZeroPageX ? cpu.X : cpu.Y)));
+            } break;
+            case Mode::Absolute: {
+                const byte low = co_await fetch();
+                value = co_await read(low | (co_await fetch()) << 8);
+            } break;
+            case Mode::AbsoluteX:
+            case Mode::AbsoluteY: {
+                const byte index = decoded.mode == Mode::AbsoluteX ? cpu.X : cpu.Y;
+                const byte low = co_await fetch();
+                const word base = low | (co_await fetch()) << 8;
+                const word effective = base + index;
+                value = co_await read(effective);
+                if (crosses(base, index)) value = co_await read(effective - 0x100);
+            } break;
+            case Mode::XIndirect: {
+                const byte pointer = co_await fetch() + cpu.X;
+                co_await idle();
+                const byte low = co_await read(pointer);
+                value = co_await read(low | (co_await read(static_cast<byte>(pointer + 1))) << 8);
+            } break;
+            case Mode::IndirectY: {
+                const byte pointer = co_await fetch();
+                const byte low = co_await read(pointer);
+                const word base = low | (co_await read(pointer + 1)) << 8;
+                if (crosses(base, cpu.Y)) co_await idle();
+                value = co_await read(base + cpu.Y);
+            } break;
+            case Mode::ZeroPageW: {
+                address = co_await fetch();
+            } break;
+            case Mode::ZeroPageXW:
+            case Mode::ZeroPageYW: {
+                co_await idle();
+                address = static_cast<byte>(co_await fetch() + (decoded.mode == Mode::ZeroPageXW ? cpu.X : cpu.Y));
+            } break;
+            case Mode::AbsoluteW: {
+                const byte low = co_await fetch();
+                address = low | (co_await fetch()) << 8;
+            } break;
+            case Mode::AbsoluteXW:
+            case Mode::AbsoluteYW: {
+                const byte index = decoded.mode == Mode::AbsoluteXW ? cpu.X : cpu.Y;
+                const byte low = co_await fetch();
+                const word base = low | (co_await fetch()) << 8;
+                co_await idle();
+                address = crosses(base, index) ? base + index - 0x100 : base + index;
+            } break;
+            case Mode::XIndirectW: {
+                const byte pointer = co_await fetch() + cpu.X;
+                co_await idle();
+                const byte low = co_await read(pointer);
+                address = low | (co_await read(static_cast<byte>(pointer + 1))) << 8;
+            } break;
+            case Mode::IndirectYW: {
+                const byte pointer = co_await fetch();
+                const byte low = co_await read(pointer);
+                address = low | (co_await read(pointer + 1)) << 8;
+                co_await idle();
+                address += cpu.Y;
+            } break;
+        }
+
+        switch (decoded.operation) {
+            case Operation::Stop: break;
+            case Operation::LDA: cpu.A = value; cpu.loadRegisterSetStatus(cpu.A); break;
+            case Operation::LDX: cpu.X = value; cpu.loadRegisterSetStatus(cpu.X); break;
+            case Operation::LDY: cpu.Y = value; cpu.loadRegisterSetStatus(cpu.Y); break;
+            case Operation::AND: cpu.A &= value; cpu.loadRegisterSetStatus(cpu.A); break;
+            case Operation::EOR: cpu.A ^= value; cpu.loadRegisterSetStatus(cpu.A); break;
+            case Operation::ORA: cpu.A |= value; cpu.loadRegisterSetStatus(cpu.A); break;
+            case Operation::BIT: cpu.bitInstructionSetStatus(value & cpu.A); break;
+            case Operation::STA: co_await write(address, cpu.A); break;
+            case Operation::STX: co_await write(address, cpu.X); break;
+            case Operation::STY: co_await write(address, cpu.Y); break;
+            case Operation::JSR: {
+                const byte low = co_await fetch();
+                co_await idle();
+                co_await push(cpu.PC >> 8);
+                co_await push(cpu.PC & 0xFF);
+                cpu.PC = (co_await fetch()) << 8 | low;
+            } break;
+            case Operation::RTS: {
+                co_await read(cpu.PC);
+                cpu.SP++;
+                co_await idle();
+                const byte low = co_await read(0x100 | cpu.SP++);
+                cpu.PC = (co_await read(0x100 | cpu.SP)) << 8 | low;
+                cpu.PC++;
+                co_await idle();
+            } break;
+            case Operation::JMP: cpu.PC = address; break;
+            case Operation::JMPIndirect: {
+                const byte low = co_await read(address);
+                cpu.PC = (co_await read((address & 0xFF) == 0xFF ? address & 0xFF00 : address + 1)) << 8 | low;
+            } break;
+            case Operation::PHA: {
+                co_await fetch();
+                co_await push(cpu.A);
+            } break;
+            case Operation::PHP: {
+                co_await fetch();
+                co_await push(static_cast<byte>(cpu.PS.to_ulong()));
+            } break;
+            case Operation::PLA:
+            case Operation::PLP: {
+                co_await fetch();
+                cpu.SP++;
+                co_await idle();
+                const byte pulled = co_await read(0x100 | cpu.SP);
+                if (decoded.operation == Operation::PLA) {
+                    cpu.A = pulled;
+                    cpu.loadRegisterSetStatus(cpu.A);
+                } else {
+                    cpu.PS = pulled;
+                }
+            } break;
+            case Operation::TSX: {
+                cpu.X = cpu.SP;
+                cpu.loadRegisterSetStatus(cpu.X);
+                co_await fetch();
+            } break;
+            case Operation::TXS: {
+                cpu.SP = cpu.X;
+                co_await fetch();
+            } break;
+            case Operation::BRK: {
+                co_await fetch();
+                co_await push(cpu.PC >> 8);
+                co_await push(cpu.PC & 0xFF);
+                std::bitset<Flags::numFlags> pushed{cpu.PS};
+                pushed.set(Flags::B).set(Flags::U);
+                co_await push(static_cast<byte>(pushed.to_ulong()));
+                cpu.PS.set(Flags::I);
+                const byte low = co_await read(CPU::IRQ_VECTOR);
+                cpu.PC = low | (co_await read(CPU::IRQ_VECTOR + 1)) << 8;
+            } break;
+            case Operation::RTI: {
+                co_await read(cpu.PC);
+                cpu.SP++;
+                co_await idle();
+                cpu.PS = co_await read(0x100 | cpu.SP++);
+                const byte low = co_await read(0x100 | cpu.SP++);
+                cpu.PC = (co_await read(0x100 | cpu.SP)) << 8 | low;
+            } break;
+        }
+    }
+}
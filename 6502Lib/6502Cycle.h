@@ -0,0 +1,84 @@
+#ifndef INC_6502_EMULATION_6502CYCLE_H
+#define INC_6502_EMULATION_6502CYCLE_H
+
+#include "6502.h"
+
+namespace m6502 {
+    class CycleCPU;
+}
+
+/* Runs a CPU one bus cycle at a time, for systems whose video or sound chips have to see
+ * memory and the interrupt lines as they are in the middle of an instruction. The instruction
+ * set is written as a coroutine that suspends at every bus cycle, so the state of a half done
+ * instruction lives in the coroutine frame instead of a hand written state machine, and
+ * step() is one resume and one memory access. run() calls the other chips in between, inlined
+ * into the loop, without a virtual call per cycle.
+ *
+ * The registers and memory are those of the CPU it steps, between two steps they show the
+ * instruction as far as it got. Instructions take the same bus cycles in the same order as in
+ * CPU::execute(), cycles without a bus access included. An instruction is done with the step
+ * of its last bus cycle, and interrupts raised up to then are taken before the next one. The
+ * cycles are its own: the CPU's clock is neither read nor paced.
+ *
+ * The coroutine needs C++20 and is built into the 6502Cycle library; this header is C++14. */
+class m6502::CycleCPU {
+public:
+    //what the CPU does on the bus in a cycle
+    struct Access {
+        enum Kind : byte {FETCH, READ, WRITE, IDLE};
+        word address;
+        byte data;          //read or written
+        Kind kind;
+    };
+
+    explicit CycleCPU(CPU& cpu);
+    ~CycleCPU();
+    CycleCPU(const CycleCPU&) = delete;
+    CycleCPU& operator=(const CycleCPU&) = delete;
+
+    /* one bus cycle: the CPU goes on to its next access and does it. False, without using a
+     * cycle, once it stopped on an opcode it does not know; that opcode's fetch was its last cycle */
+    bool step();
+    //steps cycles times, or until the CPU stops, and calls chips(cycle) after every cycle
+    template<class Chips> uint64_t run(uint64_t cycles, Chips&& chips);
+    uint64_t run(uint64_t cycles) { return run(cycles, [](uint64_t) {}); }
+
+    //the last cycle step() ran
+    const Access& lastAccess() const { return last; }
+    uint64_t getCycles() const { return cycle; }
+    //started so far, an instruction counts from its opcode fetch
+    uint64_t getInstructions() const { return instructions; }
+    bool isStopped() const { return stopped; }
+    //between two instructions, where the registers are those execute() would leave and may be changed
+    bool atInstructionBoundary() const { return atBoundary; }
+
+private:
+    struct Core;
+    struct BusCycle;
+    Core execute();
+    BusCycle fetch();
+    BusCycle read(word address);
+    BusCycle write(word address, byte data);
+    BusCycle idle();
+    BusCycle push(byte data);
+    BusCycle fetchOpcode();
+
+    CPU& cpu;
+    void* frame;            //of the coroutine
+    Access access{};        //the next one, once the coroutine got to it
+    Access last{};
+    uint64_t cycle{0};
+    uint64_t instructions{0};
+    bool atBoundary{false};
+    bool stopped{false};
+};
+
+template<class Chips>
+uint64_t m6502::CycleCPU::run(uint64_t cycles, Chips&& chips) {
+    const uint64_t start = cycle;
+    while (cycle - start < cycles && step())
+        chips(cycle);
+    return cycle - start;
+}
+
+#endif //INC_6502_EMULATION_6502CYCLE_H
@@ -0,0 +1,64 @@
+#include "6502Dedup.h"
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+
+namespace {
+    bool isZero(const m6502::byte* data) {
+        return !std::memcmp(data, m6502::Page::zero.data, m6502::Page::SIZE);
+    }
+}
+
+const m6502::Deduplicator::Stats& m6502::Deduplicator::run() {
+    const auto start = std::chrono::steady_clock::now();
+    stats = Stats{};
+    stats.memories = memories.size();
+
+    //the page every equal page is merged into, and the memory that had it first
+    struct Canonical {
+        Page* page;
+        Memory* memory;
+        dword index;
+    };
+    std::unordered_multimap<uint64_t, Canonical> canonical;
+    auto drop = [this](Page* page) {
+        if (page->references.load(std::memory_order_acquire) == 1) stats.bytesReclaimed += Page::SIZE;
+        Page::release(page);
+    };
+
+    for (Memory* memory : memories) {
+        const Memory::PageSet used = memory->used;
+        used.forEach([&](dword index) {
+            Page* page = memory->pages[index];
+            //devices and shared ram, not copy on write memory
+            if (page == &Page::io || page->pinned) return;
+            stats.pagesScanned++;
+            if (isZero(page->data)) {
+                memory->pages[index] = &Page::zero;
+                memory->writable[index] = nullptr;
+                memory->used.reset(index);
+                drop(page);
+                stats.zeroPages++;
+                return;
+            }
+            //kept on the page, so pages seen by an earlier run are not hashed again
+            const uint64_t hash = memory->pageHash(index);
+            auto candidates = canonical.equal_range(hash);
+            for (auto candidate = candidates.first; candidate != candidates.second; ++candidate) {
+                Canonical& first = candidate->second;
+                if (first.page == page) return;
+                if (std::memcmp(first.page->data, page->data, Page::SIZE)) continue;
+                //both are shared from here on, neither memory may write without copying
+                first.memory->writable[first.index] = nullptr;
+                memory->writable[index] = nullptr;
+                memory->pages[index] = Page::share(first.page);
+                drop(page);
+                stats.mergedPages++;
+                return;
+            }
+            canonical.insert({hash, {page, memory, index}});
+        });
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
@@ -0,0 +1,37 @@
+#ifndef INC_6502_EMULATION_6502DEDUP_H
+#define INC_6502_EMULATION_6502DEDUP_H
+
+#include "6502Memory.h"
+#include <vector>
+
+namespace m6502 {
+    class Deduplicator;
+}
+
+/* Finds pages with the same contents across many memories and makes them all refer to one
+ * of them, shared and copied again on the next write like any other shared page. Pages that
+ * are all zero go back to the zero page. Meant for instances that sit idle for long with
+ * mostly the same memory: run it between their runs, never while one of them executes. */
+class m6502::Deduplicator {
+public:
+    struct Stats {
+        size_t memories;
+        uint64_t pagesScanned;
+        uint64_t zeroPages;         //put back to the zero page
+        uint64_t mergedPages;       //now referring to an equal page of another memory
+        uint64_t bytesReclaimed;    //of pages freed because nothing refers to them any more
+        double seconds;
+    };
+
+    void add(Memory& memory) { memories.push_back(&memory); }
+    void clear() { memories.clear(); }
+    //one pass over every page all memories use
+    const Stats& run();
+    const Stats& getStats() const { return stats; }
+
+private:
+    std::vector<Memory*> memories;
+    Stats stats{};
+};
+
+#endif //INC_6502_EMULATION_6502DEDUP_H
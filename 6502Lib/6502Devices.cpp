@@ -0,0 +1,53 @@
+#include "6502Devices.h"
+#include <cassert>
+
+m6502::Devices::Devices(const EventQueue& time) : time(time) {}
+
+void m6502::Devices::add(Device& device, word address, dword length) {
+    assert(length && address + length <= Memory::MAX_MEM);
+    ranges.push_back({&device, address, length});
+    for (dword page = address / Page::SIZE; page <= (address + length - 1) / Page::SIZE; ++page) {
+        byPage[page].push_back(ranges.size() - 1);
+        pages.set(page);
+    }
+}
+
+void m6502::Devices::attach(Memory& memory) {
+    pages.forEach([this, &memory](dword page) { memory.map(*this, page, 1); });
+}
+
+void m6502::Devices::synchronize() {
+    const uint64_t now = time.now();
+    for (const Range& range : ranges) {
+        if (range.device->synchronizedTo() < now) {
+            stats.advances++;
+            stats.advancedCycles += now - range.device->synchronizedTo();
+        }
+        range.device->synchronize(now);
+    }
+}
+
+const m6502::Devices::Range* m6502::Devices::find(word address) {
+    stats.accesses++;
+    for (size_t index : byPage[address >> 8]) {
+        const Range* range = &ranges[index];
+        if (address < range->address || static_cast<dword>(address - range->address) >= range->length) continue;
+        const uint64_t now = time.now();
+        if (range->device->synchronizedTo() < now) {
+            stats.advances++;
+            stats.advancedCycles += now - range->device->synchronizedTo();
+            range->device->synchronize(now);
+        }
+        return range;
+    }
+    return nullptr;
+}
+
+m6502::byte m6502::Devices::read(word address) {
+    const Range* range = find(address);
+    return range ? range->device->read(static_cast<word>(address - range->address)) : 0;
+}
+
+void m6502::Devices::write(word address, byte data) {
+    if (const Range* range = find(address)) range->device->write(static_cast<word>(address - range->address), data);
+}
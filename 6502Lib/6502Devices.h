@@ -0,0 +1,76 @@
+#ifndef INC_6502_EMULATION_6502DEVICES_H
+#define INC_6502_EMULATION_6502DEVICES_H
+
+#include "6502Events.h"
+#include <vector>
+
+namespace m6502 {
+    struct Device;
+    class Devices;
+}
+
+/* A memory mapped peripheral that is only brought up to date when the CPU reads or writes
+ * it. It remembers the cycle it was last synchronized at and, on the next access, runs
+ * everything that happened since in one call to advance(). A device that nobody touches
+ * costs nothing, and what the CPU reads is still what it would have read cycle by cycle.
+ * Things a device has to do by itself, raising a line say, go into an EventQueue. */
+struct m6502::Device {
+    virtual ~Device() = default;
+    //runs the device from cycle from to cycle to, with no accesses in between
+    virtual void advance(uint64_t from, uint64_t to) = 0;
+    //offset from the address the device was added at, the device is up to date
+    virtual byte read(word offset) = 0;
+    virtual void write(word offset, byte data) = 0;
+
+    uint64_t synchronizedTo() const { return synchronized; }
+    void synchronize(uint64_t cycle) {
+        if (cycle <= synchronized) return;
+        advance(synchronized, cycle);
+        synchronized = cycle;
+    }
+
+private:
+    uint64_t synchronized{0};
+};
+
+/* The devices of a machine and the pages of its address space they sit in. The pages go to
+ * the bus in every memory attached; a byte of such a page that no device answers for reads
+ * as 0 and ignores writes. Accesses happen at time.now(), the cycle the access starts at. */
+class m6502::Devices : public Bus {
+public:
+    struct Stats {
+        uint64_t accesses;
+        uint64_t advances;          //calls to Device::advance()
+        uint64_t advancedCycles;    //cycles the devices caught up on, all together
+    };
+
+    explicit Devices(const EventQueue& time);
+
+    //device answers for [address, address + length), which must not overlap another device
+    void add(Device& device, word address, dword length);
+    //the pages of every device added go to this bus in memory
+    void attach(Memory& memory);
+    //every device up to now, for instance before looking at their state from outside
+    void synchronize();
+
+    byte read(word address) override;
+    void write(word address, byte data) override;
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct Range {
+        Device* device;
+        word address;
+        dword length;
+    };
+    //the device at address, brought up to date, nullptr for none
+    const Range* find(word address);
+
+    const EventQueue& time;
+    std::vector<Range> ranges;
+    std::vector<size_t> byPage[Memory::PAGES];     //indices into ranges
+    Memory::PageSet pages;
+    Stats stats{};
+};
+
+#endif //INC_6502_EMULATION_6502DEVICES_H
@@ -0,0 +1,59 @@
+#include "6502Diff.h"
+#include <cstring>
+#include <iomanip>
+
+namespace {
+    m6502::StateDiff::Registers registersOf(const m6502::CPU& cpu) {
+        return {cpu.PC, cpu.SP, cpu.A, cpu.X, cpu.Y, static_cast<m6502::byte>(cpu.PS.to_ulong())};
+    }
+}
+
+m6502::StateDiff m6502::diff(const CPU& a, const CPU& b) {
+    StateDiff diff;
+    diff.a = registersOf(a);
+    diff.b = registersOf(b);
+    if (a.mem.hash() == b.mem.hash()) return diff;
+
+    constexpr dword groupSize = Memory::PAGES / Memory::HASH_GROUPS;
+    for (dword group{0}; group < Memory::HASH_GROUPS; ++group) {
+        if (a.mem.groupHash(group) == b.mem.groupHash(group)) continue;
+        for (dword page = group * groupSize; page < (group + 1) * groupSize; ++page) {
+            const byte* dataA = a.mem.pageData(page);
+            const byte* dataB = b.mem.pageData(page);
+            if (dataA == dataB || a.mem.pageHash(page) == b.mem.pageHash(page)) continue;
+            diff.pagesCompared++;
+            if (!std::memcmp(dataA, dataB, Page::SIZE)) continue;
+            diff.pages++;
+            if (diff.page >= 0) continue;
+            dword offset{0};
+            while (dataA[offset] == dataB[offset]) ++offset;
+            diff.page = static_cast<int>(page);
+            diff.address = static_cast<int>(page * Page::SIZE + offset);
+            diff.byteA = dataA[offset];
+            diff.byteB = dataB[offset];
+        }
+    }
+    return diff;
+}
+
+std::ostream& m6502::operator<<(std::ostream& out, const StateDiff& diff) {
+    const std::ios_base::fmtflags flags = out.flags();
+    out << std::hex << std::uppercase << std::setfill('0');
+    if (diff.same()) out << "same state\n";
+    auto field = [&out](const char* name, unsigned a, unsigned b, int width) {
+        if (a != b) out << name << ' ' << std::setw(width) << a << " vs " << std::setw(width) << b << '\n';
+    };
+    field("PC", diff.a.PC, diff.b.PC, 4);
+    field("SP", diff.a.SP, diff.b.SP, 2);
+    field("A", diff.a.A, diff.b.A, 2);
+    field("X", diff.a.X, diff.b.X, 2);
+    field("Y", diff.a.Y, diff.b.Y, 2);
+    field("PS", diff.a.PS, diff.b.PS, 2);
+    if (diff.page >= 0) {
+        out << "memory from $" << std::setw(4) << diff.address << ": " << std::setw(2) << unsigned{diff.byteA}
+            << " vs " << std::setw(2) << unsigned{diff.byteB} << '\n';
+        out << std::dec << diff.pages << " pages differ\n";
+    }
+    out.flags(flags);
+    return out;
+}
@@ -0,0 +1,38 @@
+#ifndef INC_6502_EMULATION_6502DIFF_H
+#define INC_6502_EMULATION_6502DIFF_H
+
+#include "6502.h"
+#include <ostream>
+
+namespace m6502 {
+    struct StateDiff;
+    //compares the hashes of a and b from the root down and only the bytes of pages whose hashes differ
+    StateDiff diff(const CPU& a, const CPU& b);
+}
+
+//where two machine states part, for finding out why two runs that should agree hash differently
+struct m6502::StateDiff {
+    struct Registers {
+        word PC;
+        byte SP, A, X, Y, PS;
+        bool operator==(const Registers& other) const {
+            return PC == other.PC && SP == other.SP && A == other.A && X == other.X && Y == other.Y && PS == other.PS;
+        }
+    };
+    Registers a, b;
+    int page{-1};               //first page whose contents differ, -1 when memory agrees
+    int address{-1};            //first differing byte in that page
+    byte byteA{0}, byteB{0};    //what a and b hold there
+    size_t pages{0};            //that differ
+    size_t pagesCompared{0};    //byte by byte, because their hashes differ
+
+    bool registersDiffer() const { return !(a == b); }
+    bool same() const { return !registersDiffer() && page < 0; }
+};
+
+namespace m6502 {
+    //one line per finding
+    std::ostream& operator<<(std::ostream& out, const StateDiff& diff);
+}
+
+#endif //INC_6502_EMULATION_6502DIFF_H
@@ -0,0 +1,59 @@
+#include "6502Events.h"
+#include <algorithm>
+#include <functional>
+
+void m6502::EventQueue::schedule(Handler& handler, uint64_t cycle) {
+    live.erase(handler.pending);
+    handler.pending = ++sequence;
+    live.insert(sequence);
+    heap.push_back({cycle, sequence, &handler});
+    std::push_heap(heap.begin(), heap.end(), std::greater<Event>{});
+}
+
+void m6502::EventQueue::cancel(Handler& handler) {
+    //the event stays in the heap until it comes up, then goes without its handler being looked at
+    live.erase(handler.pending);
+    handler.pending = 0;
+}
+
+uint64_t m6502::EventQueue::next() {
+    skipStale();
+    return heap.empty() ? UINT64_MAX : heap.front().cycle;
+}
+
+void m6502::EventQueue::skipStale() {
+    while (!heap.empty() && !live.count(heap.front().sequence)) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<Event>{});
+        heap.pop_back();
+    }
+}
+
+void m6502::EventQueue::fireDue() {
+    for (skipStale(); !heap.empty() && heap.front().cycle <= base; skipStale()) {
+        const Event event = heap.front();
+        std::pop_heap(heap.begin(), heap.end(), std::greater<Event>{});
+        heap.pop_back();
+        live.erase(event.sequence);
+        event.handler->pending = 0;
+        const uint64_t late = base - event.cycle;
+        stats.events++;
+        stats.lateCycles += late;
+        stats.maxLateCycles = std::max(stats.maxLateCycles, late);
+        event.handler->onEvent(*this, event.cycle);
+    }
+}
+
+uint64_t m6502::EventQueue::run(CPU& cpu, uint64_t cycles) {
+    const uint64_t start = base;
+    const uint64_t end = base + cycles;
+    fireDue();
+    while (base < end && !stopped) {
+        const uint64_t until = heap.empty() ? end : std::min(end, heap.front().cycle);
+        running = &cpu;
+        base += cpu.run(until - base, stopped);
+        running = nullptr;
+        stats.slices++;
+        fireDue();
+    }
+    return base - start;
+}
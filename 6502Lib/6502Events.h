@@ -0,0 +1,76 @@
+#ifndef INC_6502_EMULATION_6502EVENTS_H
+#define INC_6502_EMULATION_6502EVENTS_H
+
+#include "6502.h"
+#include <unordered_set>
+#include <vector>
+
+namespace m6502 {
+    class EventQueue;
+}
+
+/* Runs a CPU together with timers and devices without ticking them every cycle. Each
+ * handler, a timer say, has at most one pending event: the next cycle something happens
+ * to it. The CPU runs freely up to the earliest event, at the end of the instruction that
+ * reaches it the event fires, and the handler schedules its next one. Peripherals cost per
+ * event instead of per cycle.
+ *
+ * Cycles count from the construction of the queue. The CPU only stops between instructions,
+ * so an event fires up to an instruction late; handlers get the cycle it was due at. */
+class m6502::EventQueue {
+public:
+    struct Handler {
+        virtual ~Handler() = default;
+        //cycle is the one the event was due at, queue.now() is at most an instruction later
+        virtual void onEvent(EventQueue& queue, uint64_t cycle) = 0;
+    private:
+        friend class EventQueue;
+        uint64_t pending{0};    //sequence number of the handler's live event, 0 for none
+    };
+
+    struct Stats {
+        uint64_t events;        //fired
+        uint64_t slices;        //runs of the CPU between events
+        uint64_t lateCycles;    //fired events were late by, all together
+        uint64_t maxLateCycles;
+    };
+
+    //replaces the handler's pending event, a cycle already passed fires as soon as run() gets to it
+    void schedule(Handler& handler, uint64_t cycle);
+    //after this, or once its event fired, the handler may go away while the queue lives on
+    void cancel(Handler& handler);
+    bool isScheduled(const Handler& handler) const { return handler.pending != 0; }
+    //the cycle of the earliest pending event, UINT64_MAX for none
+    uint64_t next();
+
+    //runs cpu for cycles more cycles, or until it stops on an unhandled opcode, returns the cycles run
+    uint64_t run(CPU& cpu, uint64_t cycles);
+    //the current cycle, during run() too
+    uint64_t now() const { return running ? base + running->runCycles() : base; }
+    bool isStopped() const { return stopped; }
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct Event {
+        uint64_t cycle;
+        uint64_t sequence;      //keeps events due at the same cycle in the order they were scheduled
+        Handler* handler;
+        bool operator>(const Event& other) const {
+            return cycle != other.cycle ? cycle > other.cycle : sequence > other.sequence;
+        }
+    };
+
+    //drops events whose handler rescheduled or cancelled since, without touching the handler
+    void skipStale();
+    void fireDue();
+
+    std::vector<Event> heap;
+    std::unordered_set<uint64_t> live;  //sequence numbers of the events that still fire
+    uint64_t sequence{0};
+    uint64_t base{0};           //cycle the current slice started at
+    const CPU* running{nullptr};
+    bool stopped{false};
+    Stats stats{};
+};
+
+#endif //INC_6502_EMULATION_6502EVENTS_H
@@ -0,0 +1,186 @@
+#include "6502Image.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+m6502::MappedFile::MappedFile(const std::string& path) {
+#ifdef __linux__
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat status{};
+    if (fstat(fd, &status) == 0 && S_ISREG(status.st_mode)) {
+        length = static_cast<size_t>(status.st_size);
+        if (!length) {
+            open = true;
+        } else {
+            //the mapping keeps the file, the descriptor is not needed past here
+            void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                bytes = static_cast<const byte*>(mapped);
+                open = true;
+            } else {
+                length = 0;
+            }
+        }
+    }
+    close(fd);
+#else
+    std::ifstream file{path, std::ios::binary};
+    if (!file) return;
+    read.assign(std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{});
+    bytes = read.empty() ? nullptr : read.data();
+    length = read.size();
+    open = true;
+#endif
+}
+
+m6502::MappedFile::~MappedFile() {
+#ifdef __linux__
+    if (bytes) munmap(const_cast<byte*>(bytes), length);
+#endif
+}
+
+void m6502::Image::clear() {
+    file.reset();
+    decoded.clear();
+    segments.clear();
+}
+
+bool m6502::Image::parse(Format format, const byte* bytes, size_t length, word address) {
+    clear();
+    switch (format) {
+        case RAW:
+            if (length) segments.push_back({address, bytes, length});
+            return true;
+        case PRG:
+            if (length < 2) return false;
+            if (length > 2) segments.push_back({static_cast<dword>(bytes[0] | bytes[1] << 8), bytes + 2, length - 2});
+            return true;
+        case INTEL_HEX:
+            if (parseIntelHex(reinterpret_cast<const char*>(bytes), length)) return true;
+            clear();
+            return false;
+    }
+    return false;
+}
+
+bool m6502::Image::open(const std::string& path, Format format, word address) {
+    std::unique_ptr<MappedFile> mapped{new MappedFile{path}};
+    if (!mapped->isOpen() || !parse(format, mapped->data(), mapped->size(), address)) {
+        clear();
+        return false;
+    }
+    //intel hex is decoded by now, raw and prg segments point into the mapping
+    if (format != INTEL_HEX) file = std::move(mapped);
+    return true;
+}
+
+namespace {
+    int hexDigit(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    }
+}
+
+//:LLAAAATT, LL data bytes and a checksum that makes all of them add up to 0
+bool m6502::Image::parseIntelHex(const char* text, size_t length) {
+    struct Run {
+        dword address;
+        std::vector<byte> bytes;
+    };
+    std::vector<Run> runs;
+    dword base{0};
+    bool ended{false};
+    size_t at{0};
+    auto next = [&](byte& value) {
+        if (at + 2 > length) return false;
+        const int high = hexDigit(text[at]), low = hexDigit(text[at + 1]);
+        if (high < 0 || low < 0) return false;
+        value = static_cast<byte>(high << 4 | low);
+        at += 2;
+        return true;
+    };
+    while (at < length && !ended) {
+        if (text[at] == '\r' || text[at] == '\n' || text[at] == ' ' || text[at] == '\t') {
+            at++;
+            continue;
+        }
+        if (text[at++] != ':') return false;
+        byte count, high, low, type;
+        if (!next(count) || !next(high) || !next(low) || !next(type)) return false;
+        byte sum = static_cast<byte>(count + high + low + type);
+        byte data[255];
+        for (byte i{0}; i < count; ++i) {
+            if (!next(data[i])) return false;
+            sum = static_cast<byte>(sum + data[i]);
+        }
+        byte checksum;
+        if (!next(checksum) || static_cast<byte>(sum + checksum) != 0) return false;
+        switch (type) {
+            case 0x00: {
+                const dword address = base + static_cast<dword>(high << 8 | low);
+                //records that carry on where the last one stopped go into the same segment
+                if (runs.empty() || runs.back().address + runs.back().bytes.size() != address)
+                    runs.push_back({address, {}});
+                runs.back().bytes.insert(runs.back().bytes.end(), data, data + count);
+                break;
+            }
+            case 0x01:
+                ended = true;
+                break;
+            case 0x02:
+                if (count != 2) return false;
+                base = static_cast<dword>(data[0] << 8 | data[1]) << 4;
+                break;
+            case 0x04:
+                if (count != 2) return false;
+                base = static_cast<dword>(data[0] << 8 | data[1]) << 16;
+                break;
+            case 0x03:
+            case 0x05:
+                //start addresses, the CPU takes its own from the reset vector
+                break;
+            default:
+                return false;
+        }
+    }
+    if (!ended) return false;
+    for (Run& run : runs) {
+        if (run.bytes.empty()) continue;
+        decoded.push_back(std::move(run.bytes));
+        segments.push_back({run.address, decoded.back().data(), decoded.back().size()});
+    }
+    return true;
+}
+
+size_t m6502::Image::size() const {
+    size_t bytes{0};
+    for (const Segment& segment : segments) bytes += segment.length;
+    return bytes;
+}
+
+size_t m6502::Image::loadInto(Memory& memory) const {
+    size_t copied{0};
+    for (const Segment& segment : segments) {
+        if (segment.address >= Memory::MAX_MEM) continue;
+        const size_t length = std::min<size_t>(segment.length, Memory::MAX_MEM - segment.address);
+        //a page at a time, each one made the memory's own once
+        for (size_t done{0}; done < length;) {
+            const dword address = segment.address + static_cast<dword>(done);
+            const size_t chunk = std::min<size_t>(length - done, Page::SIZE - address % Page::SIZE);
+            std::memcpy(&memory[address], segment.bytes + done, chunk);
+            done += chunk;
+        }
+        copied += length;
+    }
+    return copied;
+}
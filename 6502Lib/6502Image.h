@@ -0,0 +1,76 @@
+#ifndef INC_6502_EMULATION_6502IMAGE_H
+#define INC_6502_EMULATION_6502IMAGE_H
+
+#include "6502Memory.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace m6502 {
+    class MappedFile;
+    class Image;
+}
+
+/* A file mapped read only into the address space, so its bytes are used where they are
+ * instead of being read first: opening costs the same for a few bytes as for megabytes, and
+ * parts nobody looks at are never read from disk. Where there is no mmap the file is read. */
+class m6502::MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool isOpen() const { return open; }
+    //valid as long as the file is, nullptr for an empty one
+    const byte* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const byte* bytes{nullptr};
+    size_t length{0};
+    bool open{false};
+    std::vector<byte> read;     //without mmap
+};
+
+/* A program or rom image as segments of bytes and the addresses they go to, from
+ *  RAW        the bytes as they are, at an address given with them
+ *  PRG        a little endian load address in the first two bytes, the rest goes there
+ *  INTEL_HEX  text records with their own addresses and checksums; extended segment and
+ *             linear address records give addresses past 64 KB, for banked images
+ * Raw and prg segments refer to the bytes they were parsed from, or to the file open()
+ * mapped, without copying; intel hex is decoded into the image. Parsing fails, leaving the
+ * image empty, on anything malformed. */
+class m6502::Image {
+public:
+    enum Format : byte {RAW, PRG, INTEL_HEX};
+
+    struct Segment {
+        dword address;
+        const byte* bytes;
+        size_t length;
+    };
+
+    //from bytes that have to stay valid as long as the image
+    bool parse(Format format, const byte* bytes, size_t length, word address = 0);
+    //from a file, mapped rather than read
+    bool open(const std::string& path, Format format, word address = 0);
+
+    const std::vector<Segment>& getSegments() const { return segments; }
+    bool isEmpty() const { return segments.empty(); }
+    //of all segments together
+    size_t size() const;
+    /* copies the segments into memory, the parts past 64 KB left out, and returns the bytes
+     * copied. The pages written become the memory's own, as with operator[] */
+    size_t loadInto(Memory& memory) const;
+
+private:
+    bool parseIntelHex(const char* text, size_t length);
+    void clear();
+
+    std::unique_ptr<MappedFile> file;
+    std::vector<std::vector<byte>> decoded;    //of intel hex segments
+    std::vector<Segment> segments;
+};
+
+#endif //INC_6502_EMULATION_6502IMAGE_H
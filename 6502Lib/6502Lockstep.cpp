@@ -0,0 +1,163 @@
+#include "6502Lockstep.h"
+#include "6502LockstepKernel.h"
+#include <algorithm>
+#include <cassert>
+
+namespace {
+    //one 32 bit lane, runs sorted tails and every slot when AVX2 is unavailable
+    struct Scalar {
+        static constexpr size_t width = 1;
+        uint32_t v;
+
+        Scalar(uint32_t v) : v(v) {}
+
+        static Scalar load(const uint32_t* p) { return *p; }
+        void store(uint32_t* p) const { *p = v; }
+
+        friend Scalar operator+(Scalar a, Scalar b) { return a.v + b.v; }
+        friend Scalar operator-(Scalar a, Scalar b) { return a.v - b.v; }
+        friend Scalar operator&(Scalar a, Scalar b) { return a.v & b.v; }
+        friend Scalar operator|(Scalar a, Scalar b) { return a.v | b.v; }
+        friend Scalar operator^(Scalar a, Scalar b) { return a.v ^ b.v; }
+        friend Scalar operator<<(Scalar a, int n) { return a.v << n; }
+        friend Scalar operator>>(Scalar a, int n) { return a.v >> n; }
+        friend Scalar operator~(Scalar a) { return ~a.v; }
+        static Scalar eq(Scalar a, Scalar b) { return a.v == b.v ? 0xFFFFFFFFu : 0u; }
+        static Scalar gt(Scalar a, Scalar b) { return a.v > b.v ? 0xFFFFFFFFu : 0u; }
+        static Scalar select(Scalar mask, Scalar a, Scalar b) { return mask.v ? a : b; }
+        static unsigned bits(Scalar mask) { return mask.v >> 31; }
+        static Scalar broadcast(Scalar a, unsigned) { return a; }
+        static uint32_t lane(Scalar a, unsigned) { return a.v; }
+
+        static Scalar gather(const m6502::byte* memory, Scalar offset) { return memory[offset.v]; }
+        static void scatter(m6502::byte* memory, Scalar offset, Scalar value, Scalar mask) {
+            if (mask.v) memory[offset.v] = static_cast<m6502::byte>(value.v);
+        }
+    };
+
+    //which opcodes the kernel knows, found by running each one on a scratch lane
+    struct HandledOpcodes {
+        bool handled[256];
+        HandledOpcodes() {
+            std::vector<m6502::byte> memory(m6502::CPU::Mem::MAX_MEM + 3);
+            uint32_t PC{0}, SP{0xFF}, A{0}, X{0}, Y{0}, PS{0}, cycles{0}, base{0}, remaining{1}, halted{0}, interrupts{0};
+            m6502::LockstepLanes lanes{&PC, &SP, &A, &X, &Y, &PS, &cycles, &base, &remaining, &halted, &interrupts,
+                                       memory.data(), handled};
+            for (int opcode{0}; opcode < 256; ++opcode) {
+                LockstepKernel<Scalar> kernel{lanes, 0};
+                handled[opcode] = kernel.execute(static_cast<m6502::byte>(opcode));
+            }
+        }
+    };
+    const HandledOpcodes& handledOpcodes() {
+        static const HandledOpcodes opcodes;
+        return opcodes;
+    }
+}
+
+m6502::LockstepCPU::LockstepCPU(size_t instances)
+        : PC(instances), SP(instances), A(instances), X(instances), Y(instances), PS(instances),
+          cycles(instances), base(instances), instance(instances), halted(instances), remaining(instances),
+          interrupts(instances), executed(instances),
+          slotOf(instances), images(instances * CPU::Mem::MAX_MEM + 3), avx2{hasAVX2()} {
+    assert(instances * CPU::Mem::MAX_MEM < (size_t{1} << 31));
+    for (size_t i{0}; i < instances; ++i) {
+        base[i] = static_cast<uint32_t>(i * CPU::Mem::MAX_MEM);
+        instance[i] = slotOf[i] = static_cast<uint32_t>(i);
+        SP[i] = 0xFF;
+    }
+}
+
+bool m6502::LockstepCPU::hasAVX2() {
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+}
+
+bool m6502::LockstepCPU::load(size_t i, const CPU& cpu) {
+    if (cpu.mem.getBus()) return false;
+    const size_t slot = slotOf[i];
+    PC[slot] = cpu.PC;
+    SP[slot] = cpu.SP;
+    A[slot] = cpu.A;
+    X[slot] = cpu.X;
+    Y[slot] = cpu.Y;
+    PS[slot] = static_cast<uint32_t>(cpu.PS.to_ulong());
+    interrupts[slot] = cpu.interrupts;
+    cpu.mem.copyTo(memory(i));
+    return true;
+}
+
+void m6502::LockstepCPU::store(size_t i, CPU& cpu) const {
+    const size_t slot = slotOf[i];
+    cpu.PC = static_cast<word>(PC[slot]);
+    cpu.SP = static_cast<byte>(SP[slot]);
+    cpu.A = static_cast<byte>(A[slot]);
+    cpu.X = static_cast<byte>(X[slot]);
+    cpu.Y = static_cast<byte>(Y[slot]);
+    cpu.PS = PS[slot];
+    cpu.interrupts = static_cast<byte>(interrupts[slot]);
+    cpu.mem.copyFrom(memory(i));
+}
+
+void m6502::LockstepCPU::execute(uint64_t instructionsToExecute) {
+    //remaining counts down in 32 bits, longer runs go in slices
+    constexpr uint64_t SLICE = 0x7FFFFFFF;
+    //a chunk goes on masked while at least this many of its 8 slots agree
+    constexpr unsigned MIN_LANES = 4;
+    //regrouping stops paying off once chunks split up after this few steps on average
+    constexpr uint64_t MIN_STEPS_PER_CHUNK = 16;
+
+    std::fill(cycles.begin(), cycles.end(), 0);
+    std::fill(executed.begin(), executed.end(), 0);
+    std::fill(halted.begin(), halted.end(), 0);
+    bool vectors = avx2;
+    for (size_t pending; (pending = regroup(instructionsToExecute));) {
+        //regroup() moved the registers
+        LockstepLanes lanes{PC.data(), SP.data(), A.data(), X.data(), Y.data(), PS.data(), cycles.data(), base.data(),
+                            remaining.data(), halted.data(), interrupts.data(), images.data(), handledOpcodes().handled};
+        for (size_t slot{0}; slot < pending; ++slot)
+            remaining[slot] = static_cast<uint32_t>(std::min(instructionsToExecute - executed[slot], SLICE));
+        uint64_t chunks{0}, steps{0};
+        size_t slot{0};
+        if (vectors) {
+            for (; slot + 8 <= pending; slot += 8, ++chunks) {
+                LockstepChunkStats chunk = lockstepChunkAVX2(lanes, slot, MIN_LANES);
+                steps += chunk.steps;
+                stats.vectorSteps += chunk.steps;
+                stats.vectorLanes += chunk.lanes;
+            }
+        }
+        for (; slot < pending; ++slot)
+            stats.scalarLanes += lockstepChunk<Scalar>(lanes, slot, 1).lanes;
+        for (slot = 0; slot < pending; ++slot)
+            executed[slot] += std::min(instructionsToExecute - executed[slot], SLICE) - remaining[slot];
+        if (steps < chunks * MIN_STEPS_PER_CHUNK) vectors = false;
+    }
+}
+
+size_t m6502::LockstepCPU::regroup(uint64_t instructionsToExecute) {
+    std::vector<uint32_t> order(size());
+    for (size_t slot{0}; slot < order.size(); ++slot) order[slot] = static_cast<uint32_t>(slot);
+    auto running = std::stable_partition(order.begin(), order.end(), [this, instructionsToExecute](uint32_t slot) {
+        return !halted[slot] && executed[slot] < instructionsToExecute;
+    });
+    const size_t pending = running - order.begin();
+    if (!pending) return 0;
+    stats.regroups++;
+    std::stable_sort(order.begin(), running, [this](uint32_t a, uint32_t b) { return PC[a] < PC[b]; });
+    permute(order);
+    return pending;
+}
+
+void m6502::LockstepCPU::permute(const std::vector<uint32_t>& order) {
+    auto apply = [&order](auto& values) {
+        auto reordered = values;
+        for (size_t slot{0}; slot < order.size(); ++slot)
+            reordered[slot] = values[order[slot]];
+        values.swap(reordered);
+    };
+    apply(PC); apply(SP); apply(A); apply(X); apply(Y); apply(PS);
+    apply(cycles); apply(base); apply(instance); apply(halted); apply(interrupts); apply(executed);
+    for (size_t slot{0}; slot < instance.size(); ++slot)
+        slotOf[instance[slot]] = static_cast<uint32_t>(slot);
+}
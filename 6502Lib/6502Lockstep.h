@@ -0,0 +1,68 @@
+#ifndef INC_6502_EMULATION_6502LOCKSTEP_H
+#define INC_6502_EMULATION_6502LOCKSTEP_H
+
+#include "6502.h"
+#include <vector>
+
+namespace m6502 {
+    class LockstepCPU;
+}
+
+/* Many instances of the same machine run side by side, for sweeping one program over many
+ * inputs. Registers live in structure of arrays form, one slot per instance, and each instance
+ * has its own memory. Slots are sorted by PC and taken 8 at a time into AVX2 registers, where
+ * they stay for as many instructions as they keep agreeing on PC and opcode. When a chunk
+ * splits up, the biggest agreeing group goes on with the others masked off; once it gets
+ * smaller than half the chunk, the chunk hands its slots back and they are sorted by PC again
+ * so that instances that came back to the same code meet in a chunk. Sorted tails shorter
+ * than a chunk, and everything once instances stop meeting again, run one slot at a time.
+ *
+ * execute() gives every instance the same result as CPU::execute would, including cycles
+ * and the interrupts pending on load(). */
+class m6502::LockstepCPU {
+public:
+    struct Stats {
+        uint64_t vectorSteps;   //instructions run for a chunk of 8 slots at once
+        uint64_t vectorLanes;   //instance-instructions in those steps
+        uint64_t scalarLanes;   //instance-instructions run one at a time
+        uint64_t regroups;      //times the slots were sorted by PC
+    };
+
+    //instances * 64 KB of memory, at most 32767 instances so gather offsets fit 31 bits
+    explicit LockstepCPU(size_t instances);
+    size_t size() const { return instance.size(); }
+
+    static bool hasAVX2();
+    //with AVX2 off every slot runs through the scalar kernel, e.g. for comparisons
+    void useAVX2(bool enable) { avx2 = enable && hasAVX2(); }
+
+    /* registers and memory of one instance from a CPU. False for a CPU with devices, whose
+     * reads the instances could not pass on, the instance is left as it was */
+    bool load(size_t instance, const CPU& cpu);
+    //into a CPU, which only comes to own the pages that differ; its devices stay
+    void store(size_t instance, CPU& cpu) const;
+    byte* memory(size_t instance) { return &images[static_cast<size_t>(instance) * CPU::Mem::MAX_MEM]; }
+    const byte* memory(size_t instance) const { return &images[static_cast<size_t>(instance) * CPU::Mem::MAX_MEM]; }
+
+    //every instance executes up to instructionsToExecute instructions, stopping early on an unhandled opcode
+    void execute(uint64_t instructionsToExecute = 1);
+    //of the last execute()
+    dword getCycles(size_t instance) const { return cycles[slotOf[instance]]; }
+    uint64_t getInstructionsExecuted(size_t instance) const { return executed[slotOf[instance]]; }
+    const Stats& getStats() const { return stats; }
+
+private:
+    //sorts the unfinished slots by PC in front of the finished ones, returns how many there are
+    size_t regroup(uint64_t instructionsToExecute);
+    //reorders slots: slot k takes what was in slot order[k]
+    void permute(const std::vector<uint32_t>& order);
+
+    std::vector<uint32_t> PC, SP, A, X, Y, PS, cycles, base, instance, halted, remaining, interrupts;
+    std::vector<uint64_t> executed;
+    std::vector<uint32_t> slotOf;   //instance -> slot
+    std::vector<byte> images;
+    bool avx2;
+    Stats stats{};
+};
+
+#endif //INC_6502_EMULATION_6502LOCKSTEP_H
@@ -0,0 +1,55 @@
+/* Built with -mavx2. Only call into here after LockstepCPU::hasAVX2() said yes, and keep
+ * std templates out: an inline function instantiated here could be chosen by the linker
+ * for callers elsewhere that run on machines without AVX2. */
+#include "6502LockstepKernel.h"
+#include <immintrin.h>
+
+namespace {
+    //eight 32 bit lanes
+    struct Avx2 {
+        static constexpr size_t width = 8;
+        __m256i v;
+
+        Avx2(__m256i v) : v(v) {}
+        Avx2(uint32_t value) : v(_mm256_set1_epi32(static_cast<int>(value))) {}
+
+        static Avx2 load(const uint32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+        void store(uint32_t* p) const { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+
+        friend Avx2 operator+(Avx2 a, Avx2 b) { return _mm256_add_epi32(a.v, b.v); }
+        friend Avx2 operator-(Avx2 a, Avx2 b) { return _mm256_sub_epi32(a.v, b.v); }
+        friend Avx2 operator&(Avx2 a, Avx2 b) { return _mm256_and_si256(a.v, b.v); }
+        friend Avx2 operator|(Avx2 a, Avx2 b) { return _mm256_or_si256(a.v, b.v); }
+        friend Avx2 operator^(Avx2 a, Avx2 b) { return _mm256_xor_si256(a.v, b.v); }
+        friend Avx2 operator<<(Avx2 a, int n) { return _mm256_sll_epi32(a.v, _mm_cvtsi32_si128(n)); }
+        friend Avx2 operator>>(Avx2 a, int n) { return _mm256_srl_epi32(a.v, _mm_cvtsi32_si128(n)); }
+        friend Avx2 operator~(Avx2 a) { return _mm256_xor_si256(a.v, _mm256_set1_epi32(-1)); }
+        //all ones where true, lanes stay far below 2^31 so signed compares are fine
+        static Avx2 eq(Avx2 a, Avx2 b) { return _mm256_cmpeq_epi32(a.v, b.v); }
+        static Avx2 gt(Avx2 a, Avx2 b) { return _mm256_cmpgt_epi32(a.v, b.v); }
+        static Avx2 select(Avx2 mask, Avx2 a, Avx2 b) { return _mm256_blendv_epi8(b.v, a.v, mask.v); }
+        //one bit per lane of a mask
+        static unsigned bits(Avx2 mask) { return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(mask.v))); }
+        static Avx2 broadcast(Avx2 a, unsigned lane) { return _mm256_permutevar8x32_epi32(a.v, _mm256_set1_epi32(static_cast<int>(lane))); }
+        static uint32_t lane(Avx2 a, unsigned lane) { return static_cast<uint32_t>(_mm256_cvtsi256_si32(broadcast(a, lane).v)); }
+
+        //bytes at memory + offset, reading 3 bytes past each one
+        static Avx2 gather(const m6502::byte* memory, Avx2 offsets) {
+            return _mm256_and_si256(_mm256_i32gather_epi32(reinterpret_cast<const int*>(memory), offsets.v, 1), _mm256_set1_epi32(0xFF));
+        }
+        //AVX2 has no scatter, every lane writes into its own image so order does not matter
+        static void scatter(m6502::byte* memory, Avx2 offsets, Avx2 values, Avx2 mask) {
+            alignas(32) uint32_t o[width], d[width];
+            offsets.store(o);
+            values.store(d);
+            for (unsigned lanes = bits(mask); lanes; lanes &= lanes - 1) {
+                const unsigned i = __builtin_ctz(lanes);
+                memory[o[i]] = static_cast<m6502::byte>(d[i]);
+            }
+        }
+    };
+}
+
+m6502::LockstepChunkStats m6502::lockstepChunkAVX2(const LockstepLanes& lanes, size_t slot, unsigned minLanes) {
+    return lockstepChunk<Avx2>(lanes, slot, minLanes);
+}
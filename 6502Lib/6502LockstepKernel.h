@@ -0,0 +1,364 @@
+#ifndef INC_6502_EMULATION_6502LOCKSTEPKERNEL_H
+#define INC_6502_EMULATION_6502LOCKSTEPKERNEL_H
+
+/* The instruction kernel of LockstepCPU, written once over a lane type V that holds one
+ * 32 bit value per lane. It is compiled twice, for scalar lanes in 6502Lockstep.cpp and
+ * for AVX2 lanes in 6502LockstepAVX2.cpp (built with -mavx2). Everything here has internal
+ * linkage so the AVX2 instantiation can never be picked for the scalar one at link time.
+ *
+ * Every lane of a call runs the same opcode, but reads and writes its own memory image,
+ * and must end up exactly where CPU::execute would, cycle counts included. */
+
+#include "6502.h"
+
+namespace m6502 {
+    //structure of arrays view of the lanes, indexed by slot
+    struct LockstepLanes {
+        uint32_t *PC, *SP, *A, *X, *Y, *PS, *cycles;
+        uint32_t *base;         //offset of the slot's memory image in memory
+        uint32_t *remaining;    //instructions the slot may still execute, counted down
+        uint32_t *halted;       //set once the slot fetched an opcode execute() does not know
+        uint32_t *interrupts;   //the lines of CPU::interrupts
+        byte* memory;           //images of every instance, followed by 3 bytes of padding for gathers
+        const bool* handled;    //opcodes the kernel knows
+    };
+
+    struct LockstepChunkStats {
+        uint64_t steps;         //instructions run for a group of lanes at once
+        uint64_t lanes;         //instance-instructions in those steps
+    };
+
+    //runs the 8 slots from slot until they are done or fewer than minLanes still agree. Only call it when hasAVX2().
+    LockstepChunkStats lockstepChunkAVX2(const LockstepLanes& lanes, size_t slot, unsigned minLanes);
+}
+
+namespace {
+    template<class V>
+    struct LockstepKernel {
+        const m6502::LockstepLanes& lanes;
+        size_t slot;
+        V PC, SP, A, X, Y, PS, cycles, base, remaining, halted, interrupts;
+        V active{0xFFFFFFFFu};  //lanes the current instruction applies to, only these write memory
+
+        LockstepKernel(const m6502::LockstepLanes& lanes, size_t slot) : lanes(lanes), slot(slot),
+                PC{V::load(lanes.PC + slot)}, SP{V::load(lanes.SP + slot)}, A{V::load(lanes.A + slot)},
+                X{V::load(lanes.X + slot)}, Y{V::load(lanes.Y + slot)}, PS{V::load(lanes.PS + slot)},
+                cycles{V::load(lanes.cycles + slot)}, base{V::load(lanes.base + slot)},
+                remaining{V::load(lanes.remaining + slot)}, halted{V::load(lanes.halted + slot)},
+                interrupts{V::load(lanes.interrupts + slot)} {}
+
+        void store() const {
+            PC.store(lanes.PC + slot);
+            SP.store(lanes.SP + slot);
+            A.store(lanes.A + slot);
+            X.store(lanes.X + slot);
+            Y.store(lanes.Y + slot);
+            PS.store(lanes.PS + slot);
+            cycles.store(lanes.cycles + slot);
+            remaining.store(lanes.remaining + slot);
+            halted.store(lanes.halted + slot);
+            interrupts.store(lanes.interrupts + slot);
+        }
+
+        //bus accesses, one cycle each like CPU::readByte/writeByte
+        V readByte(V address) {
+            cycles = cycles + 1;
+            return V::gather(lanes.memory, base + (address & 0xFFFF));
+        }
+        void writeByte(V data, V address) {
+            cycles = cycles + 1;
+            V::scatter(lanes.memory, base + (address & 0xFFFF), data, active);
+        }
+        V fetchByte() {
+            V data = readByte(PC);
+            PC = (PC + 1) & 0xFFFF;
+            return data;
+        }
+        V fetchWord() {
+            V low = fetchByte();
+            return low | (fetchByte() << 8);
+        }
+        V readWord(V address) {
+            V low = readByte(address);
+            return low | (readByte(address + 1) << 8);
+        }
+        void pushByteToStack(V data) {
+            writeByte(data, SP | 0x100);
+            SP = (SP - 1) & 0xFF;
+        }
+        V pullByteFromStack(bool incSPBefore, bool incSPAfter) {
+            if (incSPBefore) {
+                SP = (SP + 1) & 0xFF;
+                cycles = cycles + 1;
+            }
+            V address = SP | 0x100;
+            if (incSPAfter) SP = (SP + 1) & 0xFF;
+            return readByte(address);
+        }
+
+        void loadRegisterSetStatus(V value) {
+            PS = (PS & ~0x82u) | (V::eq(value, 0) & 0x02) | (value & 0x80);
+        }
+        void bitInstructionSetStatus(V result) {
+            PS = (PS & ~0xC2u) | (V::eq(result, 0) & 0x02) | (result & 0xC0);
+        }
+        V loadRegister(V value) {
+            loadRegisterSetStatus(value);
+            return value;
+        }
+
+        //addressing modes, the same accesses and internal cycles as CPU::readAddr*/writeAddr*
+        V readAddrZeroPage() { return readByte(fetchByte()); }
+        V readAddrZeroPageX() { return readIndexedZeroPage(X); }
+        V readAddrZeroPageY() { return readIndexedZeroPage(Y); }
+        V readIndexedZeroPage(V index) {
+            V address = (fetchByte() + index) & 0xFF;
+            cycles = cycles + 1;
+            return readByte(address);
+        }
+        V readAddrAbsolute() { return readByte(fetchWord()); }
+        V readAddrAbsoluteX() { return readIndexedAbsolute(X); }
+        V readAddrAbsoluteY() { return readIndexedAbsolute(Y); }
+        V readIndexedAbsolute(V index) {
+            V address = fetchWord();
+            V effectiveAddress = address + index;
+            V data = readByte(effectiveAddress);
+            //crossing lanes read a second time, the others keep their first read
+            V crossed = V::gt((address & 0xFF) + index, 0xFF);
+            V cycleBefore = cycles;
+            V second = readByte(effectiveAddress - 0x100);
+            cycles = cycleBefore + (crossed & 1);
+            return V::select(crossed, second, data);
+        }
+        V readAddrXIndirect() { return readByte(writeAddrXIndirect()); }
+        V readAddrIndirectY() {
+            V address = readWord(fetchByte());
+            cycles = cycles + (V::gt((address & 0xFF) + Y, 0xFF) & 1);
+            return readByte(address + Y);
+        }
+
+        V writeAddrZeroPage() { return fetchByte(); }
+        V writeAddrZeroPageX() { return writeIndexedZeroPage(X); }
+        V writeAddrZeroPageY() { return writeIndexedZeroPage(Y); }
+        V writeIndexedZeroPage(V index) {
+            cycles = cycles + 1;
+            return (fetchByte() + index) & 0xFF;
+        }
+        V writeAddrAbsolute() { return fetchWord(); }
+        V writeAddrAbsoluteX() { return writeIndexedAbsolute(X); }
+        V writeAddrAbsoluteY() { return writeIndexedAbsolute(Y); }
+        V writeIndexedAbsolute(V index) {
+            V address = fetchWord();
+            V effectiveAddress = address + index;
+            cycles = cycles + 1;
+            return V::select(V::gt((address & 0xFF) + index, 0xFF), effectiveAddress - 0x100, effectiveAddress);
+        }
+        V writeAddrXIndirect() {
+            V startAddress = (fetchByte() + X) & 0xFF;
+            cycles = cycles + 1;
+            V low = readByte(startAddress);
+            return low | (readByte((startAddress + 1) & 0xFF) << 8);
+        }
+        V writeAddrIndirectY() {
+            V address = readWord(fetchByte());
+            cycles = cycles + 1;
+            return address + Y;
+        }
+
+        //one instruction on every lane, false if execute() does not know the opcode
+        bool execute(m6502::byte instruction) {
+            using m6502::CPU;
+            fetchByte();
+            switch (instruction) {
+                case CPU::INS_LDA_IM: A = loadRegister(fetchByte()); break;
+                case CPU::INS_LDX_IM: X = loadRegister(fetchByte()); break;
+                case CPU::INS_LDY_IM: Y = loadRegister(fetchByte()); break;
+                case CPU::INS_LDA_ZP: A = loadRegister(readAddrZeroPage()); break;
+                case CPU::INS_LDX_ZP: X = loadRegister(readAddrZeroPage()); break;
+                case CPU::INS_LDY_ZP: Y = loadRegister(readAddrZeroPage()); break;
+                case CPU::INS_LDA_ZPX: A = loadRegister(readAddrZeroPageX()); break;
+                case CPU::INS_LDY_ZPX: Y = loadRegister(readAddrZeroPageX()); break;
+                case CPU::INS_LDX_ZPY: X = loadRegister(readAddrZeroPageY()); break;
+                case CPU::INS_LDA_ABS: A = loadRegister(readAddrAbsolute()); break;
+                case CPU::INS_LDX_ABS: X = loadRegister(readAddrAbsolute()); break;
+                case CPU::INS_LDY_ABS: Y = loadRegister(readAddrAbsolute()); break;
+                case CPU::INS_LDA_ABSX: A = loadRegister(readAddrAbsoluteX()); break;
+                case CPU::INS_LDY_ABSX: Y = loadRegister(readAddrAbsoluteX()); break;
+                case CPU::INS_LDA_ABSY: A = loadRegister(readAddrAbsoluteY()); break;
+                case CPU::INS_LDX_ABSY: X = loadRegister(readAddrAbsoluteY()); break;
+                case CPU::INS_LDA_XIND: A = loadRegister(readAddrXIndirect()); break;
+                case CPU::INS_LDA_INDY: A = loadRegister(readAddrIndirectY()); break;
+                case CPU::INS_STA_ZP: writeByte(A, writeAddrZeroPage()); break;
+                case CPU::INS_STX_ZP: writeByte(X, writeAddrZeroPage()); break;
+                case CPU::INS_STY_ZP: writeByte(Y, writeAddrZeroPage()); break;
+                case CPU::INS_STA_ZPX: writeByte(A, writeAddrZeroPageX()); break;
+                case CPU::INS_STX_ZPY: writeByte(X, writeAddrZeroPageY()); break;
+                case CPU::INS_STY_ZPX: writeByte(Y, writeAddrZeroPageX()); break;
+                case CPU::INS_STA_ABS: writeByte(A, writeAddrAbsolute()); break;
+                case CPU::INS_STX_ABS: writeByte(X, writeAddrAbsolute()); break;
+                case CPU::INS_STY_ABS: writeByte(Y, writeAddrAbsolute()); break;
+                case CPU::INS_STA_ABSX: writeByte(A, writeAddrAbsoluteX()); break;
+                case CPU::INS_STA_ABSY: writeByte(A, writeAddrAbsoluteY()); break;
+                case CPU::INS_STA_XIND: writeByte(A, writeAddrXIndirect()); break;
+                case CPU::INS_STA_INDY: writeByte(A, writeAddrIndirectY()); break;
+                case CPU::INS_AND_IM: A = loadRegister(fetchByte() & A); break;
+                case CPU::INS_EOR_IM: A = loadRegister(fetchByte() ^ A); break;
+                case CPU::INS_ORA_IM: A = loadRegister(fetchByte() | A); break;
+                case CPU::INS_AND_ZP: A = loadRegister(readAddrZeroPage() & A); break;
+                case CPU::INS_EOR_ZP: A = loadRegister(readAddrZeroPage() ^ A); break;
+                case CPU::INS_ORA_ZP: A = loadRegister(readAddrZeroPage() | A); break;
+                case CPU::INS_AND_ZPX: A = loadRegister(readAddrZeroPageX() & A); break;
+                case CPU::INS_EOR_ZPX: A = loadRegister(readAddrZeroPageX() ^ A); break;
+                case CPU::INS_ORA_ZPX: A = loadRegister(readAddrZeroPageX() | A); break;
+                case CPU::INS_AND_ABS: A = loadRegister(readAddrAbsolute() & A); break;
+                case CPU::INS_EOR_ABS: A = loadRegister(readAddrAbsolute() ^ A); break;
+                case CPU::INS_ORA_ABS: A = loadRegister(readAddrAbsolute() | A); break;
+                case CPU::INS_AND_ABSX: A = loadRegister(readAddrAbsoluteX() & A); break;
+                case CPU::INS_EOR_ABSX: A = loadRegister(readAddrAbsoluteX() ^ A); break;
+                case CPU::INS_ORA_ABSX: A = loadRegister(readAddrAbsoluteX() | A); break;
+                case CPU::INS_AND_ABSY: A = loadRegister(readAddrAbsoluteY() & A); break;
+                case CPU::INS_EOR_ABSY: A = loadRegister(readAddrAbsoluteY() ^ A); break;
+                case CPU::INS_ORA_ABSY: A = loadRegister(readAddrAbsoluteY() | A); break;
+                case CPU::INS_AND_XIND: A = loadRegister(readAddrXIndirect() & A); break;
+                case CPU::INS_EOR_XIND: A = loadRegister(readAddrXIndirect() ^ A); break;
+                case CPU::INS_ORA_XIND: A = loadRegister(readAddrXIndirect() | A); break;
+                case CPU::INS_AND_INDY: A = loadRegister(readAddrIndirectY() & A); break;
+                case CPU::INS_EOR_INDY: A = loadRegister(readAddrIndirectY() ^ A); break;
+                case CPU::INS_ORA_INDY: A = loadRegister(readAddrIndirectY() | A); break;
+                case CPU::INS_BIT_ZP: bitInstructionSetStatus(readAddrZeroPage() & A); break;
+                case CPU::INS_BIT_ABS: bitInstructionSetStatus(readAddrAbsolute() & A); break;
+                case CPU::INS_JSR: {
+                    V subAddrLow = fetchByte();
+                    cycles = cycles + 1;    //internal operation
+                    pushByteToStack(PC >> 8);
+                    pushByteToStack(PC & 0xFF);
+                    PC = (fetchByte() << 8) | subAddrLow;
+                } break;
+                case CPU::INS_RTS: {
+                    readByte(PC);
+                    V PCL = pullByteFromStack(true, true);
+                    V PCH = pullByteFromStack(false, false);
+                    PC = (((PCH << 8) | PCL) + 1) & 0xFFFF;
+                    cycles = cycles + 1;
+                } break;
+                case CPU::INS_JMP_ABS: PC = fetchWord(); break;
+                case CPU::INS_JMP_IND: {
+                    V pointer = fetchWord();
+                    V latch = readByte(pointer);
+                    //the page wrap bug of the original JMP ($xxFF)
+                    V high = V::select(V::eq(pointer & 0xFF, 0xFF), pointer & 0xFF00, pointer + 1);
+                    PC = (readByte(high) << 8) | latch;
+                } break;
+                case CPU::INS_PHA_IMP: fetchByte(); pushByteToStack(A); break;
+                case CPU::INS_PHP_IMP: fetchByte(); pushByteToStack(PS); break;
+                case CPU::INS_PLA_IMP: fetchByte(); A = loadRegister(pullByteFromStack(true, false)); break;
+                case CPU::INS_PLP_IMP: fetchByte(); PS = pullByteFromStack(true, false); break;
+                case CPU::INS_TSX_IMP: X = loadRegister(SP); fetchByte(); break;
+                case CPU::INS_TXS_IMP: SP = X; fetchByte(); break;
+                case CPU::INS_BRK: {
+                    fetchByte();
+                    pushByteToStack(PC >> 8);
+                    pushByteToStack(PC & 0xFF);
+                    //B and U set on the stack, then I
+                    pushByteToStack(PS | 0x30);
+                    PS = PS | 0x04;
+                    PC = readWord(V(uint32_t{CPU::IRQ_VECTOR}));
+                } break;
+                case CPU::INS_RTI: {
+                    readByte(PC);
+                    PS = pullByteFromStack(true, true);
+                    V low = pullByteFromStack(false, true);
+                    PC = low | (pullByteFromStack(false, false) << 8);
+                } break;
+                default: return false;
+            }
+            return true;
+        }
+
+        //the lanes in mask take their pending interrupt like CPU::takeInterrupt, it is no instruction
+        void interrupt(V mask) {
+            using m6502::CPU;
+            const V before[] {PC, SP, PS, cycles, interrupts};
+            const V nmi = ~V::eq(interrupts & uint32_t{CPU::NMI}, 0);
+            active = mask;
+            //two reads of the next opcode that are thrown away
+            readByte(PC);
+            readByte(PC);
+            pushByteToStack(PC >> 8);
+            pushByteToStack(PC & 0xFF);
+            //B clear and U set on the stack, then I
+            pushByteToStack((PS & ~0x10u) | 0x20);
+            PS = PS | 0x04;
+            PC = readWord(V::select(nmi, V(uint32_t{CPU::NMI_VECTOR}), V(uint32_t{CPU::IRQ_VECTOR})));
+            interrupts = V::select(nmi, interrupts & ~uint32_t{CPU::NMI}, interrupts);
+            active = 0xFFFFFFFFu;
+            PC = V::select(mask, PC, before[0]);
+            SP = V::select(mask, SP, before[1]);
+            PS = V::select(mask, PS, before[2]);
+            cycles = V::select(mask, cycles, before[3]);
+            interrupts = V::select(mask, interrupts, before[4]);
+        }
+
+        /*one instruction on the lanes in mask. Lanes outside it keep their registers; they still
+         * gather from their own image, which is harmless, but do not write memory.*/
+        void step(m6502::byte instruction, V mask, bool allLanes) {
+            const bool handled = lanes.handled[instruction];
+            if (allLanes) {
+                execute(instruction);
+            } else {
+                const V before[] {PC, SP, A, X, Y, PS, cycles};
+                active = mask;
+                execute(instruction);
+                active = 0xFFFFFFFFu;
+                PC = V::select(mask, PC, before[0]);
+                SP = V::select(mask, SP, before[1]);
+                A = V::select(mask, A, before[2]);
+                X = V::select(mask, X, before[3]);
+                Y = V::select(mask, Y, before[4]);
+                PS = V::select(mask, PS, before[5]);
+                cycles = V::select(mask, cycles, before[6]);
+            }
+            if (handled) remaining = remaining - (mask & 1);
+            else halted = halted | mask;
+        }
+
+        /*keeps stepping whichever group the first live lane belongs to. Stops when every lane
+         * is done, or when that group has fewer than minLanes lanes, so they can be regrouped.*/
+        m6502::LockstepChunkStats run(unsigned minLanes) {
+            constexpr unsigned ALL_LANES = (1u << V::width) - 1;
+            m6502::LockstepChunkStats stats{0, 0};
+            while (true) {
+                const V live = ~(halted | V::eq(remaining, 0));
+                const unsigned liveBits = V::bits(live);
+                if (!liveBits) break;
+                //NMI, or IRQ with I clear, goes before the next instruction as in CPU::execute
+                const V irq = interrupts & ~(PS >> 2) & uint32_t{m6502::CPU::IRQ};
+                const V pending = live & ~V::eq((interrupts & uint32_t{m6502::CPU::NMI}) | irq, 0);
+                if (V::bits(pending)) {
+                    interrupt(pending);
+                    continue;
+                }
+                const unsigned leader = __builtin_ctz(liveBits);
+                const V opcodes = V::gather(lanes.memory, base + PC);
+                const m6502::byte instruction = static_cast<m6502::byte>(V::lane(opcodes, leader));
+                const V mask = live & V::eq(PC, V::broadcast(PC, leader)) & V::eq(opcodes, instruction);
+                const unsigned maskBits = V::bits(mask);
+                const unsigned count = __builtin_popcount(maskBits);
+                if (count < minLanes && stats.steps) break;
+                step(instruction, mask, maskBits == ALL_LANES);
+                stats.steps++;
+                stats.lanes += count;
+            }
+            store();
+            return stats;
+        }
+    };
+
+    template<class V>
+    m6502::LockstepChunkStats lockstepChunk(const m6502::LockstepLanes& lanes, size_t slot, unsigned minLanes) {
+        LockstepKernel<V> kernel{lanes, slot};
+        return kernel.run(minLanes);
+    }
+}
+
+#endif //INC_6502_EMULATION_6502LOCKSTEPKERNEL_H
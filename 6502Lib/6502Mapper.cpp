@@ -0,0 +1,113 @@
+#include "6502Mapper.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+m6502::Mapper::Mapper(dword bankSize) : pagesPerBank(std::max<dword>(bankSize / Page::SIZE, 1)) {
+    assert(bankSize % Page::SIZE == 0 && bankSize <= Memory::MAX_MEM);
+}
+
+m6502::Mapper::~Mapper() {
+    for (Page* page : banks) delete page;
+}
+
+namespace {
+    m6502::Page* residentPage() {
+        m6502::Page* page = new m6502::Page;
+        page->resident = true;
+        page->references.store(2, std::memory_order_relaxed);
+        return page;
+    }
+
+    //length bytes of rom, the rest of the page 0
+    m6502::Page* romPage(const m6502::byte* bytes, size_t length) {
+        m6502::Page* rom = residentPage();
+        if (length) std::memcpy(rom->data, bytes, length);
+        std::memset(rom->data + length, 0, m6502::Page::SIZE - length);
+        return rom;
+    }
+}
+
+m6502::dword m6502::Mapper::addRom(const byte* bytes, size_t length) {
+    const dword first = getBanks();
+    addBanks(bytes, length, false);
+    return first;
+}
+
+m6502::dword m6502::Mapper::mapRom(const byte* bytes, size_t length) {
+    const dword first = getBanks();
+    addBanks(bytes, length, true);
+    return first;
+}
+
+void m6502::Mapper::addBanks(const byte* bytes, size_t length, bool lazily) {
+    const size_t bankSize = getBankSize();
+    for (size_t offset{0}; offset < length; offset += bankSize) {
+        for (dword i{0}; i < pagesPerBank; ++i) {
+            const size_t at = offset + i * Page::SIZE;
+            const size_t count = at < length ? std::min<size_t>(length - at, Page::SIZE) : 0;
+            if (lazily) {
+                sources.resize(banks.size());
+                sources.push_back({bytes + at, static_cast<dword>(count)});
+                banks.push_back(nullptr);
+            } else {
+                banks.push_back(romPage(bytes + at, count));
+            }
+        }
+    }
+}
+
+m6502::dword m6502::Mapper::addRam(dword count) {
+    const dword first = getBanks();
+    for (dword i{0}; i < count * pagesPerBank; ++i) {
+        Page* ram = residentPage();
+        std::memset(ram->data, 0, Page::SIZE);
+        ram->pinned = true;
+        banks.push_back(ram);
+    }
+    return first;
+}
+
+size_t m6502::Mapper::addWindow(Memory& memory, word address, dword bank) {
+    assert(address % Page::SIZE == 0 && address / Page::SIZE + pagesPerBank <= Memory::PAGES);
+    windows.push_back({&memory, address / Page::SIZE, 0});
+    select(windows.size() - 1, bank);
+    return windows.size() - 1;
+}
+
+void m6502::Mapper::select(size_t window, dword bank) {
+    const dword count = getBanks();
+    if (!count) return;
+    Window& selecting = windows[window];
+    selecting.bank = bank % count;
+    Page** selected = banks.data() + selecting.bank * pagesPerBank;
+    for (dword i{0}; i < pagesPerBank; ++i) {
+        if (selected[i]) continue;
+        const Source& source = sources[selected - banks.data() + i];
+        selected[i] = romPage(source.bytes, source.length);
+        stats.pagesLoaded++;
+    }
+    selecting.memory->map(selecting.firstPage, selected, pagesPerBank);
+    stats.switches++;
+    stats.pagesMapped += pagesPerBank;
+}
+
+std::vector<m6502::dword> m6502::Mapper::selection() const {
+    std::vector<dword> banks;
+    for (const Window& window : windows) banks.push_back(window.bank);
+    return banks;
+}
+
+void m6502::Mapper::restore(const std::vector<dword>& selection) {
+    //windows added since keep their bank
+    for (size_t window{0}; window < selection.size() && window < windows.size(); ++window)
+        windows[window].bank = selection[window];
+}
+
+m6502::byte m6502::Mapper::read(word offset) {
+    return offset < windows.size() ? static_cast<byte>(windows[offset].bank) : 0;
+}
+
+void m6502::Mapper::write(word offset, byte data) {
+    if (offset < windows.size()) select(offset, data);
+}
@@ -0,0 +1,91 @@
+#ifndef INC_6502_EMULATION_6502MAPPER_H
+#define INC_6502_EMULATION_6502MAPPER_H
+
+#include "6502Devices.h"
+#include <vector>
+
+namespace m6502 {
+    class Mapper;
+}
+
+/* Bank switching, for programs and roms bigger than the 64 KB the CPU sees. The mapper holds
+ * banks of a fixed size, of rom and of ram, and windows into the address space of a memory
+ * that each show one of them. Its registers are a device, one per window: writing one selects
+ * the bank its window shows, reading it gives the bank selected. Selecting a bank points the
+ * window's pages at the bank's, it copies nothing, so a switch costs a few pointer writes per
+ * page whatever is in the banks.
+ *
+ * Rom banks are shared like a Rom, a write into one changes only the memory that made it and
+ * is gone once the bank is switched out. Ram banks are written in place and keep what was
+ * written while switched out; like SharedRam, copies and checkpoints of the memory share them.
+ * Which banks are selected is the mapper's and not part of the memory: save it with
+ * selection() along with a snapshot and give it back to restore() after restoring that, a
+ * Rewinder given the mapper does both itself.
+ *
+ * The banks are resident pages, kept without reference counting so a switch writes no shared
+ * counters, so the mapper has to outlive the memories it maps into and their copies, as
+ * devices do anyway: declare it before the CPU. */
+class m6502::Mapper : public Device {
+public:
+    struct Stats {
+        uint64_t switches;
+        uint64_t pagesMapped;
+        uint64_t pagesLoaded;       //copied from mapped roms on their first selection
+    };
+
+    //banks of bankSize bytes, a multiple of a page
+    explicit Mapper(dword bankSize);
+    ~Mapper();
+    Mapper(const Mapper&) = delete;
+    Mapper& operator=(const Mapper&) = delete;
+
+    //bytes as rom banks, the last one padded with 0; returns the first of them
+    dword addRom(const byte* bytes, size_t length);
+    /* the same, but referring to bytes instead of copying them, a page of them is only copied
+     * the first time its bank is selected. For images too big to copy up front, a MappedFile
+     * say; bytes have to stay valid as long as the mapper */
+    dword mapRom(const byte* bytes, size_t length);
+    //banks of ram, all 0; returns the first of them
+    dword addRam(dword count);
+    dword getBanks() const { return static_cast<dword>(banks.size() / pagesPerBank); }
+    dword getBankSize() const { return pagesPerBank * Page::SIZE; }
+
+    //a window into memory at address, on a page boundary, showing bank; returns the window, which is also its register
+    size_t addWindow(Memory& memory, word address, dword bank);
+    //banks past the last one wrap around, as if the register had only the bits it needs
+    void select(size_t window, dword bank);
+    dword selected(size_t window) const { return windows[window].bank; }
+    size_t getWindows() const { return windows.size(); }
+    //the bank of every window, to keep along with a snapshot of the memories
+    std::vector<dword> selection() const;
+    /* after the memories went back to a snapshot, which shows the banks saved with it already:
+     * the registers read them again and nothing is mapped */
+    void restore(const std::vector<dword>& selection);
+
+    void advance(uint64_t, uint64_t) override {}
+    byte read(word offset) override;
+    void write(word offset, byte data) override;
+    const Stats& getStats() const { return stats; }
+
+private:
+    //where a page of a mapped rom not selected so far comes from
+    struct Source {
+        const byte* bytes;
+        dword length;
+    };
+    struct Window {
+        Memory* memory;
+        dword firstPage;
+        dword bank;
+    };
+
+    const dword pagesPerBank;
+    void addBanks(const byte* bytes, size_t length, bool lazily);
+
+    std::vector<Page*> banks;       //pagesPerBank of them per bank, nullptr until loaded
+    std::vector<Source> sources;    //by page like banks, as far as there are mapped roms
+    std::vector<Window> windows;
+    Stats stats{};
+};
+
+#endif //INC_6502_EMULATION_6502MAPPER_H
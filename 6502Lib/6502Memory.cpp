@@ -0,0 +1,348 @@
+#include "6502Memory.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+m6502::Page m6502::Page::zero{};
+m6502::Page m6502::Page::io{};
+
+m6502::Memory::Memory() {
+    std::fill(pages, pages + PAGES, &Page::zero);
+    std::fill(writable, writable + PAGES, nullptr);
+}
+
+m6502::Memory::Memory(const Memory& other) : Memory() {
+    used = other.used;
+    bus = other.bus;
+    used.forEach([this, &other](dword page) {
+        pages[page] = Page::share(other.pages[page]);
+        //checkpoints have nothing writable, so copying one from several threads at once writes nothing
+        if (other.writable[page]) other.writable[page] = nullptr;
+    });
+}
+
+//takes everything, checkpoints stay checkpoints, other is left all zero
+m6502::Memory::Memory(Memory&& other) noexcept : used(other.used), dirty(other.dirty), stale(other.stale),
+        baseline(other.baseline), identity(other.identity), spare(std::move(other.spare)), bus(other.bus),
+        hashes(std::move(other.hashes)) {
+    std::copy(other.pages, other.pages + PAGES, pages);
+    std::copy(other.writable, other.writable + PAGES, writable);
+    std::fill(other.pages, other.pages + PAGES, &Page::zero);
+    std::fill(other.writable, other.writable + PAGES, nullptr);
+    other.used.clear();
+    other.dirty.clear();
+    other.baseline = other.identity = 0;
+}
+
+m6502::Memory& m6502::Memory::operator=(const Memory& other) {
+    if (this == &other) return *this;
+    for (dword page{0}; page < PAGES; ++page) {
+        Page* previous = pages[page];
+        pages[page] = Page::share(other.pages[page]);
+        if (other.writable[page]) other.writable[page] = nullptr;
+        writable[page] = nullptr;
+        Page::release(previous);
+    }
+    used = other.used;
+    bus = other.bus;
+    dirty.fill();
+    hashes.reset();
+    return *this;
+}
+
+m6502::Memory::~Memory() {
+    used.forEach([this](dword page) { Page::release(pages[page]); });
+    for (Page* page : spare) delete page;
+}
+
+void m6502::Memory::initialize() {
+    PageSet mapped;
+    used.forEach([this, &mapped](dword page) {
+        Page* previous = pages[page];
+        if (previous == &Page::io || previous->pinned) {
+            mapped.set(page);
+            return;
+        }
+        if (previous->references.load(std::memory_order_acquire) == 1 && spare.size() < SPARE_PAGES) spare.push_back(previous);
+        else Page::release(previous);
+        pages[page] = &Page::zero;
+        writable[page] = nullptr;
+        touch(page);
+    });
+    used = mapped;
+}
+
+void m6502::Memory::clearDirty() {
+    dirty.forEach([this](dword page) { writable[page] = nullptr; });
+    dirty.clear();
+    baseline = 0;
+}
+
+m6502::Memory m6502::Memory::checkpoint() {
+    static std::atomic<uint64_t> epochs{0};
+    clearDirty();
+    Memory copy{*this};
+    copy.identity = baseline = ++epochs;
+    return copy;
+}
+
+void m6502::Memory::revert(const Memory& checkpoint) {
+    if (!checkpoint.identity || checkpoint.identity != baseline) {
+        *this = checkpoint;
+    } else {
+        dirty.forEach([this, &checkpoint](dword page) {
+            Page* current = pages[page];
+            Page* original = checkpoint.pages[page];
+            if (current == original) return;
+            //a page of our own gets the old contents back in place, sparing the allocation on the next write
+            if (original != &Page::zero && current != &Page::zero && current != &Page::io && current->references.load(std::memory_order_acquire) == 1) {
+                std::memcpy(current->data, original->data, Page::SIZE);
+                current->hash.store(original->hash.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            } else {
+                pages[page] = Page::share(original);
+                Page::release(current);
+            }
+            stale.set(page);
+            if (checkpoint.used.test(page)) used.set(page);
+            else used.reset(page);
+        });
+    }
+    clearDirty();
+    baseline = checkpoint.identity;
+}
+
+void m6502::Memory::writeShared(word address, byte data) {
+    if (pages[address >> 8] == &Page::io) bus->write(address, data);
+    else ownPage(address >> 8)[address & 0xFF] = data;
+}
+
+//copy on write, unless every other reference has gone away in the meantime
+m6502::byte* m6502::Memory::ownPage(dword page) {
+    if (writable[page]) return writable[page];
+    touch(page);
+    Page* shared = pages[page];
+    if (shared->pinned) return writable[page] = shared->data;
+    if (shared != &Page::zero && shared != &Page::io && shared->references.load(std::memory_order_acquire) == 1) {
+        shared->hash.store(0, std::memory_order_relaxed);
+        return writable[page] = shared->data;
+    }
+    Page* own;
+    if (shared == &Page::zero && !spare.empty()) {
+        own = spare.back();
+        spare.pop_back();
+        std::memset(own->data, 0, Page::SIZE);
+    } else {
+        own = new Page;
+        std::memcpy(own->data, shared->data, Page::SIZE);
+    }
+    own->hash.store(0, std::memory_order_relaxed);
+    pages[page] = own;
+    used.set(page);
+    Page::release(shared);
+    return writable[page] = own->data;
+}
+
+void m6502::Memory::map(const Rom& rom) {
+    map(rom.firstPage, rom.pages.data(), static_cast<dword>(rom.pages.size()));
+}
+
+void m6502::Memory::map(const SharedRam& ram) {
+    map(ram.firstPage, ram.pages.data(), static_cast<dword>(ram.pages.size()));
+}
+
+void m6502::Memory::map(dword first, Page* const* mapped, dword count) {
+    assert(first + count <= PAGES);
+    for (dword i{0}; i < count; ++i) {
+        const dword page = first + i;
+        Page* previous = pages[page];
+        pages[page] = Page::share(mapped[i]);
+        writable[page] = mapped[i]->pinned ? mapped[i]->data : nullptr;
+        Page::release(previous);
+        used.set(page);
+        touch(page);
+    }
+}
+
+void m6502::Memory::map(Bus& bus, dword first, dword count) {
+    this->bus = &bus;
+    for (dword page = first; page < first + count && page < PAGES; ++page) {
+        Page::release(pages[page]);
+        pages[page] = &Page::io;
+        writable[page] = nullptr;
+        used.set(page);
+        touch(page);
+    }
+}
+
+void m6502::Memory::unmap(dword first, dword count) {
+    bool mapped{false};
+    used.forEach([this, first, count, &mapped](dword page) {
+        Page* previous = pages[page];
+        const bool io = previous == &Page::io;
+        if (page < first || page - first >= count || !(io || previous->pinned)) {
+            mapped |= io;
+            return;
+        }
+        Page::release(previous);
+        pages[page] = &Page::zero;
+        writable[page] = nullptr;
+        used.reset(page);
+        touch(page);
+    });
+    if (!mapped) bus = nullptr;
+}
+
+void m6502::Memory::copyTo(byte* destination) const {
+    for (dword page{0}; page < PAGES; ++page)
+        std::memcpy(destination + page * Page::SIZE, pages[page]->data, Page::SIZE);
+}
+
+void m6502::Memory::copyFrom(const byte* source) {
+    for (dword page{0}; page < PAGES; ++page) {
+        const byte* data = source + page * Page::SIZE;
+        if (pages[page] == &Page::io || !std::memcmp(pages[page]->data, data, Page::SIZE)) continue;
+        std::memcpy(ownPage(page), data, Page::SIZE);
+    }
+}
+
+bool m6502::Memory::operator==(const Memory& other) const {
+    for (dword page{0}; page < PAGES; ++page)
+        if (pages[page] != other.pages[page] && std::memcmp(pages[page]->data, other.pages[page]->data, Page::SIZE))
+            return false;
+    return true;
+}
+
+namespace {
+    //the finalizer of splitmix64
+    uint64_t mix(uint64_t h) {
+        h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+        h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+        return h ^ (h >> 31);
+    }
+
+    uint64_t hashData(const m6502::byte* data) {
+        uint64_t h{0x9E3779B97F4A7C15ull};
+        for (m6502::dword i{0}; i < m6502::Page::SIZE; i += 8) {
+            uint64_t chunk;
+            std::memcpy(&chunk, data + i, sizeof chunk);
+            h = (h ^ chunk) * 0xFF51AFD7ED558CCDull;
+            h ^= h >> 29;
+        }
+        //0 stands for not hashed yet
+        return mix(h) | 1;
+    }
+
+    //what a page adds to the root, depending on where it is
+    uint64_t term(m6502::dword page, uint64_t hash) {
+        return mix(hash ^ (page + 1) * 0x9E3779B97F4A7C15ull);
+    }
+
+    uint64_t zeroHash() {
+        static const uint64_t hash = hashData(m6502::Page::zero.data);
+        return hash;
+    }
+}
+
+uint64_t m6502::Memory::pageHash(dword page) const {
+    if (writable[page]) return hashData(writable[page]);
+    const Page* shared = pages[page];
+    if (shared == &Page::zero) return zeroHash();
+    //changes without this memory writing it
+    if (shared->pinned) return hashData(shared->data);
+    uint64_t hash = shared->hash.load(std::memory_order_relaxed);
+    if (!hash) {
+        hash = hashData(shared->data);
+        shared->hash.store(hash, std::memory_order_relaxed);
+    }
+    return hash;
+}
+
+uint64_t m6502::Memory::groupHash(dword group) const {
+    updateHashes();
+    return hashes->groups[group];
+}
+
+uint64_t m6502::Memory::hash() const {
+    updateHashes();
+    return hashes->root;
+}
+
+void m6502::Memory::updateHashes() const {
+    static const Hashes zero = [] {
+        Hashes all{};
+        for (dword page{0}; page < PAGES; ++page) {
+            const uint64_t added = term(page, zeroHash());
+            all.root += added;
+            all.groups[page / (PAGES / HASH_GROUPS)] += added;
+            all.pages[page] = zeroHash();
+        }
+        return all;
+    }();
+    if (!hashes) {
+        hashes.reset(new Hashes(zero));
+        stale = used;
+    }
+    PageSet changed = stale;
+    for (dword word{0}; word < PAGES / 64; ++word) changed.words[word] |= hashes->pinned.words[word];
+    changed.forEach([this](dword page) {
+        //a write into it goes through ownPage() again, which marks it stale
+        writable[page] = nullptr;
+        const uint64_t now = used.test(page) ? pageHash(page) : zeroHash();
+        if (pages[page]->pinned) hashes->pinned.set(page);
+        else hashes->pinned.reset(page);
+        if (now == hashes->pages[page]) return;
+        const uint64_t change = term(page, now) - term(page, hashes->pages[page]);
+        hashes->root += change;
+        hashes->groups[page / (PAGES / HASH_GROUPS)] += change;
+        hashes->pages[page] = now;
+    });
+    stale.clear();
+}
+
+size_t m6502::Memory::ownPages() const {
+    size_t count{0};
+    used.forEach([this, &count](dword page) {
+        count += pages[page] != &Page::io && pages[page]->references.load(std::memory_order_relaxed) == 1;
+    });
+    return count;
+}
+
+m6502::Memory::PageSet m6502::Memory::sharedPages() const {
+    PageSet shared;
+    used.forEach([this, &shared](dword page) {
+        if (pages[page]->references.load(std::memory_order_relaxed) > 1) shared.set(page);
+    });
+    return shared;
+}
+
+m6502::Rom::Rom(word address, const byte* bytes, size_t length) : firstPage{address / Page::SIZE} {
+    assert(address + length <= Memory::MAX_MEM);
+    const dword end = static_cast<dword>(address + length);
+    for (dword page = firstPage; page * Page::SIZE < end; ++page) {
+        Page* rom = new Page;
+        std::memset(rom->data, 0, Page::SIZE);
+        for (dword i{0}; i < Page::SIZE; ++i) {
+            const dword at = page * Page::SIZE + i;
+            if (at >= address && at < end) rom->data[i] = bytes[at - address];
+        }
+        pages.push_back(rom);
+    }
+}
+
+m6502::Rom::~Rom() {
+    for (Page* page : pages) Page::release(page);
+}
+
+m6502::SharedRam::SharedRam(word address, dword length) : firstPage{address / Page::SIZE} {
+    assert(address + length <= Memory::MAX_MEM);
+    for (dword page = firstPage; page * Page::SIZE < address + length; ++page) {
+        Page* ram = new Page;
+        std::memset(ram->data, 0, Page::SIZE);
+        ram->pinned = true;
+        pages.push_back(ram);
+    }
+}
+
+m6502::SharedRam::~SharedRam() {
+    for (Page* page : pages) Page::release(page);
+}
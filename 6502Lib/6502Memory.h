@@ -0,0 +1,253 @@
+#ifndef INC_6502_EMULATION_6502MEMORY_H
+#define INC_6502_EMULATION_6502MEMORY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace m6502 {
+    typedef uint8_t byte;
+    typedef uint16_t word;
+    typedef uint32_t dword;
+    typedef int32_t sdword;
+
+    struct Page;
+    struct Bus;
+    class Memory;
+    class Rom;
+    class SharedRam;
+    class Mapper;
+    class Deduplicator;
+}
+
+//256 bytes, reference counted so that memories and roms can share it
+struct m6502::Page {
+    static constexpr dword SIZE = 256;
+    std::atomic<dword> references{1};
+    //written in place by every memory it is mapped into, never copied, see SharedRam
+    bool pinned{false};
+    /* not reference counted, its owner keeps it for as long as any memory may map it, see
+     * Mapper. Its references stay at 2, its owner's and the memories', so no memory takes it
+     * for its own */
+    bool resident{false};
+    //of data, 0 until Memory::pageHash() works it out and again whenever a memory may write data
+    mutable std::atomic<uint64_t> hash{0};
+    byte data[SIZE];
+
+    //every page of a new memory until it is written, never freed
+    static Page zero;
+    //stands for the pages a bus answers for, reads as 0 to anything but the memory's reads and writes
+    static Page io;
+
+    static Page* share(Page* page) {
+        if (page != &zero && page != &io && !page->resident) page->references.fetch_add(1, std::memory_order_relaxed);
+        return page;
+    }
+    static void release(Page* page) {
+        if (page != &zero && page != &io && !page->resident && page->references.fetch_sub(1, std::memory_order_acq_rel) == 1) delete page;
+    }
+};
+
+//where reads and writes of the pages mapped to it go instead of memory, see Devices
+struct m6502::Bus {
+    virtual ~Bus() = default;
+    virtual byte read(word address) = 0;
+    virtual void write(word address, byte data) = 0;
+};
+
+/* The 64 KB address space as 256 pages. Pages are shared between copies of a memory and
+ * with the roms mapped into it, and a memory only gets its own copy of a page on the first
+ * write into it. So many instances of one machine only cost the pages each of them wrote,
+ * and initialize() only has to put back the pages that are not the zero page.
+ *
+ * Reads and writes into pages this memory already owns go straight to the page. A memory
+ * must not be copied while another thread writes into it. */
+class m6502::Memory {
+public:
+    static constexpr dword MAX_MEM = 1024 * 64;
+    static constexpr dword PAGES = MAX_MEM / Page::SIZE;
+
+    //one bit per page
+    struct PageSet {
+        uint64_t words[PAGES / 64]{};
+
+        void set(dword page) { words[page / 64] |= uint64_t{1} << (page % 64); }
+        void reset(dword page) { words[page / 64] &= ~(uint64_t{1} << (page % 64)); }
+        bool test(dword page) const { return words[page / 64] >> (page % 64) & 1; }
+        void clear() { for (uint64_t& bits : words) bits = 0; }
+        void fill() { for (uint64_t& bits : words) bits = ~uint64_t{0}; }
+        size_t count() const {
+            size_t pages{0};
+            for (uint64_t bits : words) pages += __builtin_popcountll(bits);
+            return pages;
+        }
+        //f(page) for every page in the set, in order, at a cost of the pages in it
+        template<class F> void forEach(F f) const {
+            for (dword word{0}; word < PAGES / 64; ++word)
+                for (uint64_t bits = words[word]; bits; bits &= bits - 1)
+                    f(word * 64 + static_cast<dword>(__builtin_ctzll(bits)));
+        }
+    };
+
+    Memory();
+    //shares every page, until either side writes into it
+    Memory(const Memory& other);
+    Memory(Memory&& other) noexcept;
+    Memory& operator=(const Memory& other);
+    ~Memory();
+
+    //all zero again. Pages this memory owned are kept for its next writes.
+    void initialize();
+
+    byte read(word address) const {
+        const Page* page = pages[address >> 8];
+        if (__builtin_expect(page == &Page::io, 0)) return bus->read(address);
+        return page->data[address & 0xFF];
+    }
+    void write(word address, byte data) {
+        byte* page = writable[address >> 8];
+        if (page) page[address & 0xFF] = data;
+        else writeShared(address, data);
+    }
+    //for instruction fetches, which skip the bus: device pages hold no code, the CPU stops on an opcode from one
+    byte fetch(word address) const { return pages[address >> 8]->data[address & 0xFF]; }
+    byte operator[](dword address) const { return read(static_cast<word>(address)); }
+    //for setting memory up, the page becomes this memory's own as if it was written
+    byte& operator[](dword address) { return ownPage(static_cast<word>(address) >> 8)[address & 0xFF]; }
+
+    //the pages of rom replace the ones here, shared until written
+    void map(const Rom& rom);
+    //the pages of ram replace the ones here, written in place by this memory and every other it is mapped into
+    void map(const SharedRam& ram);
+    /* pages replace [first, first + count) here, shared until written like a rom's, pinned ones
+     * written in place like shared ram's. Costs a few pointer writes per page, see Mapper */
+    void map(dword first, Page* const* pages, dword count);
+    /* reads and writes of pages [first, first + count) go to bus from now on. One bus per memory,
+     * copies share it, and initialize() keeps it; writing a page through operator[] turns it
+     * back into memory */
+    void map(Bus& bus, dword first, dword count);
+    bool isMapped(dword page) const { return pages[page] == &Page::io; }
+    //shared ram and the like, written in place for every memory it is mapped into
+    bool isPinned(dword page) const { return pages[page]->pinned; }
+    /* pages of [first, first + count) that go to the bus or are pinned read as 0 again and
+     * are this memory's own from then on. Once no page goes to the bus the memory has none */
+    void unmap(dword first, dword count);
+    Bus* getBus() const { return bus; }
+    //device pages come out as 0
+    void copyTo(byte* destination) const;
+    //pages that differ from source become this memory's own, shared ram is written in place, device pages are left alone
+    void copyFrom(const byte* source);
+    bool operator==(const Memory& other) const;
+    bool operator!=(const Memory& other) const { return !(*this == other); }
+    //where a page currently lives, for placement checks
+    const byte* pageData(dword page) const { return pages[page]->data; }
+    //pages nobody else refers to, what this memory costs on its own
+    size_t ownPages() const;
+    //used pages some other memory or rom refers to as well
+    PageSet sharedPages() const;
+    //pages that are not the zero page
+    const PageSet& usedPages() const { return used; }
+    //pages written, mapped or initialized since the last clearDirty()
+    const PageSet& dirtyPages() const { return dirty; }
+    void clearDirty();
+
+    /* Hashes of the contents. Pages only change through a memory that has them writable, so
+     * the hash of every other page is kept on the page and shared with everyone using it. The
+     * root adds up one term per page, and the terms of a group of 16 pages give a level to
+     * search down when comparing. The memory keeps the sums and the hash behind every term, so
+     * hash() only swaps the terms of the pages changed since it last looked: it costs those
+     * and the pinned pages, which other memories change, and a copy's first call costs the
+     * pages used. Keeping the sums makes it a write as far as other threads are concerned. */
+    static constexpr dword HASH_GROUPS = 16;
+    uint64_t pageHash(dword page) const;
+    uint64_t groupHash(dword group) const;
+    uint64_t hash() const;
+
+    //a copy of this memory as it is now, which revert() goes back to
+    Memory checkpoint();
+    //back to checkpoint, which only has to touch the pages dirty since then if it is the last one taken
+    void revert(const Memory& checkpoint);
+
+private:
+    friend class Deduplicator;
+    //pages kept by initialize() for reuse
+    static constexpr size_t SPARE_PAGES = 32;
+
+    //the root, the group sums and what they were made of, as of the last hash()
+    struct Hashes {
+        uint64_t root;
+        uint64_t groups[HASH_GROUPS];
+        uint64_t pages[PAGES];
+        PageSet pinned;     //hashed again every time
+    };
+
+    void writeShared(word address, byte data);
+    byte* ownPage(dword page);
+    //page's contents or mapping changed, for revert() and hash()
+    void touch(dword page) {
+        dirty.set(page);
+        stale.set(page);
+    }
+    void updateHashes() const;
+
+    Page* pages[PAGES];
+    PageSet used, dirty;
+    //pages touched since the last hash(), which then stops writing into them in place until they are touched again
+    mutable PageSet stale;
+    //the checkpoint dirty is relative to, and the one this memory is, 0 for none
+    uint64_t baseline{0}, identity{0};
+    std::vector<Page*> spare;
+    Bus* bus{nullptr};
+    //data of the pages only this memory refers to, nullptr where a write has to check first.
+    //copying from a memory shares its pages, so it clears them there too, and clearDirty()
+    //clears them so that the next write marks the page again.
+    mutable byte* writable[PAGES];
+    mutable std::unique_ptr<Hashes> hashes;     //from the first hash() on
+};
+
+/* Bytes at a fixed address, for instance a program or a system rom, held in pages that every
+ * memory it is mapped into shares. Mapping replaces whole pages, so the rest of its first and
+ * last page reads as 0. Writes into a mapped rom change only the memory that made them. */
+class m6502::Rom {
+public:
+    Rom(word address, const byte* bytes, size_t length);
+    Rom(const Rom&) = delete;
+    Rom& operator=(const Rom&) = delete;
+    ~Rom();
+
+    word getAddress() const { return static_cast<word>(firstPage * Page::SIZE); }
+    size_t getPages() const { return pages.size(); }
+
+private:
+    friend class Memory;
+    dword firstPage;
+    std::vector<Page*> pages;
+};
+
+/* Bytes at a fixed address that every memory it is mapped into reads and writes in place, for
+ * instance the RAM two CPUs of a board share. Its pages are never copied on write, so copies
+ * and checkpoints of such a memory go on sharing them and restoring a snapshot leaves them
+ * as they are. Mapping replaces whole pages, so all of its first and last page is shared.
+ * Memories on different threads write into it without synchronization, see Board. */
+class m6502::SharedRam {
+public:
+    SharedRam(word address, dword length);
+    SharedRam(const SharedRam&) = delete;
+    SharedRam& operator=(const SharedRam&) = delete;
+    ~SharedRam();
+
+    word getAddress() const { return static_cast<word>(firstPage * Page::SIZE); }
+    size_t getPages() const { return pages.size(); }
+    bool contains(word address) const { return address / Page::SIZE - firstPage < pages.size(); }
+    //by address in the 64 KB space, which contains() has to hold for
+    byte& at(word address) { return pages[address / Page::SIZE - firstPage]->data[address % Page::SIZE]; }
+
+private:
+    friend class Memory;
+    dword firstPage;
+    std::vector<Page*> pages;
+};
+
+#endif //INC_6502_EMULATION_6502MEMORY_H
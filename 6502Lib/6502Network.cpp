@@ -0,0 +1,136 @@
+#include "6502Network.h"
+#include "6502Barrier.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <thread>
+
+constexpr m6502::word m6502::SerialPort::DATA;
+constexpr m6502::word m6502::SerialPort::STATUS;
+constexpr m6502::word m6502::SerialPort::REGISTERS;
+
+m6502::byte m6502::SerialPort::read(word offset) {
+    if (offset == STATUS) return static_cast<byte>(std::min<size_t>(received.size(), 0xFF));
+    if (received.empty()) return 0;
+    const byte data = received.front();
+    received.pop_front();
+    updateIRQ();
+    return data;
+}
+
+void m6502::SerialPort::write(word offset, byte data) {
+    if (offset == STATUS) {
+        irqEnabled = data & 1;
+        updateIRQ();
+        return;
+    }
+    outbox[node.window & 1].push_back({node.queue.now() + latency, data});
+    sent++;
+}
+
+void m6502::SerialPort::onEvent(EventQueue& queue, uint64_t cycle) {
+    while (!inFlight.empty() && inFlight.front().cycle <= cycle) {
+        received.push_back(inFlight.front().data);
+        inFlight.pop_front();
+        arrived++;
+    }
+    if (!inFlight.empty()) queue.schedule(*this, inFlight.front().cycle);
+    updateIRQ();
+}
+
+void m6502::SerialPort::deliver(uint64_t window) {
+    std::vector<Message>& sentBefore = peer->outbox[(window - 1) & 1];
+    if (sentBefore.empty()) return;
+    //one sender and one latency, so they arrive in the order they were sent
+    const bool idle = inFlight.empty();
+    inFlight.insert(inFlight.end(), sentBefore.begin(), sentBefore.end());
+    sentBefore.clear();
+    if (idle) node.queue.schedule(*this, inFlight.front().cycle);
+}
+
+void m6502::SerialPort::updateIRQ() {
+    const bool raise = irqEnabled && !received.empty();
+    if (raise == asserting) return;
+    asserting = raise;
+    if (raise) node.asserting++;
+    else node.asserting--;
+    node.cpu.irq(node.asserting != 0);
+}
+
+m6502::Network::Network() = default;
+
+m6502::Network::~Network() = default;
+
+size_t m6502::Network::add(CPU& cpu) {
+    nodes.emplace_back(new Node{cpu});
+    return nodes.size() - 1;
+}
+
+size_t m6502::Network::connect(size_t a, word addressA, size_t b, word addressB, uint64_t latency) {
+    assert(latency > 0 && a != b);
+    links.emplace_back();
+    Link& link = links.back();
+    link.ends[0].reset(new SerialPort{*nodes[a], latency});
+    link.ends[1].reset(new SerialPort{*nodes[b], latency});
+    link.ends[0]->peer = link.ends[1].get();
+    link.ends[1]->peer = link.ends[0].get();
+    nodes[a]->devices.add(*link.ends[0], addressA, SerialPort::REGISTERS);
+    nodes[b]->devices.add(*link.ends[1], addressB, SerialPort::REGISTERS);
+    nodes[a]->ports.push_back(link.ends[0].get());
+    nodes[b]->ports.push_back(link.ends[1].get());
+    nodes[a]->devices.attach(nodes[a]->cpu.mem);
+    nodes[b]->devices.attach(nodes[b]->cpu.mem);
+    lookahead = lookahead ? std::min(lookahead, latency) : latency;
+    return links.size() - 1;
+}
+
+void m6502::Network::run(uint64_t cycles, unsigned threads) {
+    const auto start = std::chrono::steady_clock::now();
+    if (!threads) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<size_t>(threads, std::max<size_t>(nodes.size(), 1)));
+    const uint64_t end = elapsed + cycles;
+    //without links the nodes never have to meet
+    const uint64_t window = lookahead ? lookahead : std::max<uint64_t>(cycles, 1);
+
+    uint64_t before{0};
+    for (auto& node : nodes) {
+        node->devices.attach(node->cpu.mem);
+        before += node->queue.now();
+    }
+    uint64_t sentBefore{0};
+    for (Link& link : links) sentBefore += link.ends[0]->sent + link.ends[1]->sent;
+
+    Barrier barrier{threads};
+    std::vector<std::thread> workers;
+    for (unsigned i{1}; i < threads; ++i)
+        workers.emplace_back(&Network::work, this, i, threads, end, std::ref(barrier));
+    work(0, threads, end, barrier);
+    for (std::thread& worker : workers) worker.join();
+
+    stats = Stats{};
+    stats.windows = (cycles + window - 1) / window;
+    stats.lookahead = window;
+    stats.threads = threads;
+    for (auto& node : nodes) stats.cycles += node->queue.now();
+    stats.cycles -= before;
+    for (Link& link : links) stats.messages += link.ends[0]->sent + link.ends[1]->sent;
+    stats.messages -= sentBefore;
+    windows += stats.windows;
+    elapsed = end;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void m6502::Network::work(size_t first, size_t stride, uint64_t end, Barrier& barrier) {
+    const uint64_t window = lookahead ? lookahead : std::max<uint64_t>(end - elapsed, 1);
+    uint64_t number = windows;
+    for (uint64_t from = elapsed; from < end; from = std::min(from + window, end), ++number) {
+        const uint64_t to = std::min(from + window, end);
+        for (size_t i = first; i < nodes.size(); i += stride) {
+            Node& node = *nodes[i];
+            node.window = number;
+            for (SerialPort* port : node.ports) port->deliver(number);
+            if (!node.queue.isStopped() && node.queue.now() < to) node.queue.run(node.cpu, to - node.queue.now());
+        }
+        barrier.wait();
+    }
+}
@@ -0,0 +1,141 @@
+#ifndef INC_6502_EMULATION_6502NETWORK_H
+#define INC_6502_EMULATION_6502NETWORK_H
+
+#include "6502Devices.h"
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace m6502 {
+    class Barrier;
+    class SerialPort;
+    class Network;
+}
+
+/* Nodes that talk over serial links, each a CPU with its own event queue and devices, run on
+ * worker threads as a conservative parallel discrete event simulation. Nothing sent at
+ * cycle t arrives before t plus the latency of its link, so with the shortest latency as
+ * lookahead every node can run a whole window of that many cycles without hearing from the
+ * others: the workers run their nodes through a window, wait for each other at a barrier, and
+ * hand over what was sent at the start of the next. There are no null messages and no
+ * rollback, the cost of synchronizing is one barrier per window, so links of a few hundred
+ * cycles or more keep it small.
+ *
+ * Bytes only change hands at barriers and every node runs its window on its own, so a run
+ * gives the same result for a given setup whatever the number of threads, the host or how
+ * the cycles are split into runs. A node may end a window up to an instruction late; a byte
+ * that arrives in that time is still taken at the end of the instruction that reached its
+ * cycle, as it would be without windows. Set up the nodes, their devices and the links
+ * before the first run(); cycles count from the construction of the network. The CPUs
+ * belong to the caller. */
+class m6502::Network {
+public:
+    struct Stats {
+        uint64_t windows;
+        uint64_t lookahead;     //cycles per window
+        uint64_t messages;      //bytes sent
+        uint64_t cycles;        //of all nodes together
+        unsigned threads;
+        double seconds;
+        double cyclesPerSecond() const { return seconds > 0 ? cycles / seconds : 0; }
+    };
+
+    Network();
+    ~Network();
+    Network(const Network&) = delete;
+    Network& operator=(const Network&) = delete;
+
+    //adds a node around cpu, its devices are attached to its memory by connect() and run()
+    size_t add(CPU& cpu);
+    EventQueue& queue(size_t node) { return nodes[node]->queue; }
+    Devices& devices(size_t node) { return nodes[node]->devices; }
+    CPU& cpu(size_t node) { return nodes[node]->cpu; }
+    size_t size() const { return nodes.size(); }
+
+    /* a link between a port of node a at addressA and one of node b at addressB, bytes take
+     * latency cycles, at least 1, either way. Returns the link, whose ports are port(link, 0)
+     * and port(link, 1) */
+    size_t connect(size_t a, word addressA, size_t b, word addressB, uint64_t latency);
+    SerialPort& port(size_t link, size_t end) { return *links[link].ends[end]; }
+
+    //every node runs for cycles more cycles or until it stops, on threads workers, 0 for one per host CPU
+    void run(uint64_t cycles, unsigned threads = 0);
+    uint64_t now() const { return elapsed; }
+    bool isStopped(size_t node) const { return nodes[node]->queue.isStopped(); }
+    //shortest link latency, the window; 0 without links
+    uint64_t getLookahead() const { return lookahead; }
+    //of the last run
+    const Stats& getStats() const { return stats; }
+
+private:
+    friend class SerialPort;
+    //a CPU and what it is attached to
+    struct Node {
+        explicit Node(CPU& cpu) : cpu(cpu) {}
+        CPU& cpu;
+        EventQueue queue;
+        Devices devices{queue};
+        std::vector<SerialPort*> ports;
+        uint64_t window{0};         //the one it is running
+        unsigned asserting{0};      //ports holding the IRQ line
+    };
+    struct Link {
+        std::unique_ptr<SerialPort> ends[2];
+    };
+
+    void work(size_t first, size_t stride, uint64_t end, Barrier& barrier);
+
+    std::vector<std::unique_ptr<Node>> nodes;
+    std::vector<Link> links;
+    uint64_t lookahead{0};
+    uint64_t elapsed{0};
+    uint64_t windows{0};        //over all runs, what the ports tell their outboxes apart by
+    Stats stats{};
+};
+
+/* One end of a serial link, a device of two registers:
+ *  DATA    reading takes the oldest byte received, 0 if there is none; writing sends a byte,
+ *          which arrives at the other end the link's latency after the cycle of the write
+ *  STATUS  reading gives the bytes waiting, up to 255; writing bit 0 asks for an IRQ while
+ *          any are waiting
+ * Bytes arrive as events on the node's queue, so the CPU sees them at the end of the
+ * instruction that reaches their cycle. */
+class m6502::SerialPort : public Device, public EventQueue::Handler {
+public:
+    static constexpr word DATA = 0;
+    static constexpr word STATUS = 1;
+    static constexpr word REGISTERS = 2;
+
+    void advance(uint64_t, uint64_t) override {}
+    byte read(word offset) override;
+    void write(word offset, byte data) override;
+    void onEvent(EventQueue& queue, uint64_t cycle) override;
+
+    size_t waiting() const { return received.size(); }
+    uint64_t getSent() const { return sent; }
+    uint64_t getReceived() const { return arrived; }
+
+private:
+    friend class Network;
+    struct Message {
+        uint64_t cycle;     //it arrives at
+        byte data;
+    };
+
+    SerialPort(Network::Node& node, uint64_t latency) : node(node), latency(latency) {}
+    //takes what the other end sent in the window before window
+    void deliver(uint64_t window);
+    void updateIRQ();
+
+    Network::Node& node;
+    SerialPort* peer{nullptr};
+    const uint64_t latency;
+    //sent in even and odd windows, so one can be written while the other end takes the last one
+    std::vector<Message> outbox[2];
+    std::deque<Message> inFlight;
+    std::deque<byte> received;
+    bool irqEnabled{false}, asserting{false};
+    uint64_t sent{0}, arrived{0};
+};
+
+#endif //INC_6502_EMULATION_6502NETWORK_H
@@ -0,0 +1,98 @@
+#include "6502Numa.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#ifdef __linux__
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+m6502::NumaTopology m6502::NumaTopology::detect(const std::string& directory) {
+    NumaTopology topology;
+#ifdef __linux__
+    if (DIR* dir = opendir(directory.c_str())) {
+        while (dirent* entry = readdir(dir)) {
+            const std::string name = entry->d_name;
+            if (name.compare(0, 4, "node") || name.size() == 4 || !std::all_of(name.begin() + 4, name.end(), ::isdigit))
+                continue;
+            std::ifstream file{directory + "/" + name + "/cpulist"};
+            std::string list;
+            std::getline(file, list);
+            std::vector<int> cpus = parseCPUList(list);
+            //memory-only nodes have no CPUs to run workers on
+            if (!cpus.empty()) topology.nodes.push_back({std::stoi(name.substr(4)), cpus});
+        }
+        closedir(dir);
+    }
+#endif
+    std::sort(topology.nodes.begin(), topology.nodes.end(), [](const Node& a, const Node& b) { return a.id < b.id; });
+    if (topology.nodes.empty()) {
+        Node all{0, {}};
+        for (unsigned cpu{0}; cpu < std::max(std::thread::hardware_concurrency(), 1u); ++cpu)
+            all.cpus.push_back(static_cast<int>(cpu));
+        topology.nodes.push_back(all);
+    }
+    return topology;
+}
+
+std::vector<int> m6502::NumaTopology::parseCPUList(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ranges{list};
+    for (std::string range; std::getline(ranges, range, ',');) {
+        int first, last;
+        char dash;
+        std::stringstream bounds{range};
+        if (!(bounds >> first)) continue;
+        last = bounds >> dash >> last && dash == '-' ? last : first;
+        for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+bool m6502::NumaTopology::pinCurrentThread(const Node& node) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : node.cpus)
+        if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof set, &set) == 0;
+#else
+    (void)node;
+    return false;
+#endif
+}
+
+bool m6502::NumaTopology::preferNode(void* memory, size_t size, int node) {
+#if defined(__linux__) && defined(SYS_mbind)
+    constexpr int MPOL_PREFERRED = 1;
+    if (node < 0 || node >= 64) return false;
+    unsigned long mask = 1ul << node;
+    return syscall(SYS_mbind, memory, size, MPOL_PREFERRED, &mask, 64, 0) == 0;
+#else
+    (void)memory; (void)size; (void)node;
+    return false;
+#endif
+}
+
+std::vector<int> m6502::NumaTopology::nodesOf(const std::vector<const void*>& addresses) {
+    std::vector<int> nodes(addresses.size(), -1);
+#if defined(__linux__) && defined(SYS_move_pages)
+    if (addresses.empty()) return nodes;
+    const auto pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    std::vector<void*> pages;
+    for (const void* address : addresses)
+        pages.push_back(reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(address) / pageSize * pageSize));
+    //without target nodes move_pages only reports where each page is
+    if (syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, nodes.data(), 0) != 0)
+        std::fill(nodes.begin(), nodes.end(), -1);
+    for (int& node : nodes)
+        if (node < 0) node = -1;
+#endif
+    return nodes;
+}
@@ -0,0 +1,40 @@
+#ifndef INC_6502_EMULATION_6502NUMA_H
+#define INC_6502_EMULATION_6502NUMA_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace m6502 {
+    class NumaTopology;
+}
+
+/* The NUMA nodes of the host and the CPUs on each, as Linux lists them under
+ * /sys/devices/system/node. Hosts without that directory, and other systems, look like a
+ * single node holding every CPU, and the placement calls below then do nothing. */
+class m6502::NumaTopology {
+public:
+    struct Node {
+        int id;
+        std::vector<int> cpus;
+    };
+
+    static NumaTopology detect(const std::string& directory = "/sys/devices/system/node");
+    const std::vector<Node>& getNodes() const { return nodes; }
+    size_t size() const { return nodes.size(); }
+
+    //"0-3,8,10-11" as listed in nodeN/cpulist
+    static std::vector<int> parseCPUList(const std::string& list);
+
+    //restricts the calling thread to the CPUs of node, false if that did not work
+    static bool pinCurrentThread(const Node& node);
+    //pages of [memory, memory + size) that are not there yet are preferably taken from node
+    static bool preferNode(void* memory, size_t size, int node);
+    //node the page holding each address is on, -1 where it is not known. Looks up all of them in one call.
+    static std::vector<int> nodesOf(const std::vector<const void*>& addresses);
+
+private:
+    std::vector<Node> nodes;
+};
+
+#endif //INC_6502_EMULATION_6502NUMA_H
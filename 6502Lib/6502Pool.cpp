@@ -0,0 +1,103 @@
+#include "6502Pool.h"
+#include "6502Numa.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace {
+    //ARENA_SIZE bytes aligned to ARENA_SIZE, with hugepages if the system gives them
+    void* mapArena(size_t size, bool& huge, bool& advised) {
+        huge = advised = false;
+#ifdef __linux__
+        void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory != MAP_FAILED) {
+            huge = true;
+            return memory;
+        }
+        //no reserved hugepages: map twice the size and keep the aligned half for transparent ones
+        memory = mmap(nullptr, 2 * size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) return nullptr;
+        auto start = reinterpret_cast<uintptr_t>(memory);
+        auto aligned = (start + size - 1) / size * size;
+        if (aligned > start) munmap(memory, aligned - start);
+        if (aligned + size < start + 2 * size) munmap(reinterpret_cast<void*>(aligned + size), start + 2 * size - aligned - size);
+        memory = reinterpret_cast<void*>(aligned);
+        advised = madvise(memory, size, MADV_HUGEPAGE) == 0;
+        return memory;
+#else
+        //aligned by hand, std::aligned_alloc is C++17: the block malloc gave sits just below the arena
+        void* block = std::malloc(2 * size + sizeof(void*));
+        if (!block) return nullptr;
+        auto aligned = (reinterpret_cast<uintptr_t>(block) + sizeof(void*) + size - 1) / size * size;
+        reinterpret_cast<void**>(aligned)[-1] = block;
+        return reinterpret_cast<void*>(aligned);
+#endif
+    }
+
+    void unmapArena(void* memory, size_t size) {
+#ifdef __linux__
+        munmap(memory, size);
+#else
+        (void)size;
+        std::free(static_cast<void**>(memory)[-1]);
+#endif
+    }
+}
+
+m6502::CPUPool::CPUPool(Clock& clock, int node) : clock(clock), node(node) {}
+
+m6502::CPUPool::~CPUPool() {
+    assert(stats.inUse == 0);
+    for (Arena& arena : arenas) {
+        for (size_t slot{0}; slot < arena.built; ++slot)
+            reinterpret_cast<CPU*>(static_cast<byte*>(arena.memory) + slot * SLOT_SIZE)->~CPU();
+        unmapArena(arena.memory, arena.size);
+    }
+}
+
+m6502::CPU* m6502::CPUPool::acquire() {
+    auto start = std::chrono::steady_clock::now();
+    CPU* cpu;
+    if (!free.empty()) {
+        cpu = free.back();
+        free.pop_back();
+        //the last job's devices and shared ram may be gone by now
+        cpu->mem.unmap(0, Memory::PAGES);
+        cpu->mem.initialize();
+        cpu->reset();
+    } else {
+        if (arenas.empty() || arenas.back().built == SLOTS_PER_ARENA) grow();
+        Arena& arena = arenas.back();
+        cpu = new (static_cast<byte*>(arena.memory) + arena.built++ * SLOT_SIZE) CPU{clock};
+    }
+    stats.peakInUse = std::max(stats.peakInUse, ++stats.inUse);
+    stats.acquires++;
+    auto nanoseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    stats.acquireNanoseconds += nanoseconds;
+    stats.maxAcquireNanoseconds = std::max(stats.maxAcquireNanoseconds, nanoseconds);
+    return cpu;
+}
+
+void m6502::CPUPool::release(CPU* cpu) {
+    assert(stats.inUse > 0);
+    free.push_back(cpu);
+    stats.inUse--;
+}
+
+void m6502::CPUPool::grow() {
+    bool huge, advised;
+    void* memory = mapArena(ARENA_SIZE, huge, advised);
+    if (!memory) throw std::bad_alloc{};
+    //before anything touches it, so every page is taken from the node
+    if (node >= 0) stats.placedArenas += NumaTopology::preferNode(memory, ARENA_SIZE, node);
+    arenas.push_back({memory, ARENA_SIZE, 0});
+    stats.arenas++;
+    stats.hugeArenas += huge;
+    stats.advisedArenas += advised;
+    stats.capacity += SLOTS_PER_ARENA;
+}
@@ -0,0 +1,67 @@
+#ifndef INC_6502_EMULATION_6502POOL_H
+#define INC_6502_EMULATION_6502POOL_H
+
+#include "6502.h"
+#include <vector>
+
+namespace m6502 {
+    class CPUPool;
+}
+
+/* Hands out CPUs for short jobs without going through the allocator for each one. CPUs are
+ * built in 2 MB arenas, backed by hugepages where the system has them, so that thousands
+ * of instances sit in a few TLB entries. A released CPU stays built and goes back on a free
+ * list; acquire() resets its memory, devices and shared ram unmapped, and its registers and
+ * interrupt lines before handing it out again, which only costs the pages the last job used.
+ * A pool made for a NUMA node asks for its arenas to be placed there.
+ *
+ * Not thread safe, give every thread its own pool. */
+class m6502::CPUPool {
+public:
+    static constexpr size_t ARENA_SIZE = 2 * 1024 * 1024;
+
+    struct Stats {
+        size_t arenas;
+        size_t hugeArenas;                  //backed by reserved hugepages (MAP_HUGETLB)
+        size_t advisedArenas;               //asked for transparent hugepages instead
+        size_t placedArenas;                //bound to the pool's NUMA node
+        size_t capacity;                    //CPUs the arenas have room for
+        size_t inUse;
+        size_t peakInUse;
+        uint64_t acquires;
+        uint64_t acquireNanoseconds;        //spent in acquire(), resets included
+        uint64_t maxAcquireNanoseconds;
+        double occupancy() const { return capacity ? static_cast<double>(inUse) / capacity : 0; }
+        double averageAcquireNanoseconds() const { return acquires ? static_cast<double>(acquireNanoseconds) / acquires : 0; }
+    };
+
+    //every CPU of the pool runs on clock, which has to outlive the pool
+    explicit CPUPool(Clock& clock, int node = -1);
+    ~CPUPool();
+    CPUPool(const CPUPool&) = delete;
+    CPUPool& operator=(const CPUPool&) = delete;
+
+    //a CPU with zeroed memory and reset registers, until it is given back with release()
+    CPU* acquire();
+    void release(CPU* cpu);
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct Arena {
+        void* memory;
+        size_t size;
+        size_t built;   //CPUs constructed in it so far
+    };
+    static constexpr size_t SLOT_SIZE = (sizeof(CPU) + 63) / 64 * 64;
+    static constexpr size_t SLOTS_PER_ARENA = ARENA_SIZE / SLOT_SIZE;
+
+    void grow();
+
+    Clock& clock;
+    int node;
+    std::vector<Arena> arenas;
+    std::vector<CPU*> free;
+    Stats stats{};
+};
+
+#endif //INC_6502_EMULATION_6502POOL_H
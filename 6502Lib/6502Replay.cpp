@@ -0,0 +1,304 @@
+#include "6502Replay.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+    const char MAGIC[8] = {'6', '5', '0', '2', 'L', 'O', 'G', 2};
+}
+
+m6502::InputRecorder::InputRecorder(CPU& cpu, std::ostream& log, EventQueue* queue)
+        : cpu(cpu), log(log), queue(queue), queueStart(queue ? queue->now() : 0), devices(cpu.mem.getBus()),
+          irq(cpu.interrupts & CPU::IRQ), nmiEdges(cpu.nmiEdges) {
+    for (char c : MAGIC) put(static_cast<byte>(c));
+    for (byte value : {static_cast<byte>(cpu.PC), static_cast<byte>(cpu.PC >> 8), cpu.SP, cpu.A, cpu.X, cpu.Y,
+                       static_cast<byte>(cpu.PS.to_ulong()), cpu.interrupts})
+        put(value);
+    //device pages and shared ram belong to others, like initialize() the log leaves them alone
+    Memory::PageSet own;
+    cpu.mem.usedPages().forEach([this, &own](dword page) {
+        if (this->cpu.mem.isMapped(page)) mapped.set(page);
+        else if (!this->cpu.mem.isPinned(page)) own.set(page);
+    });
+    for (uint64_t bits : mapped.words)
+        for (dword shift{0}; shift < 64; shift += 8) put(static_cast<byte>(bits >> shift));
+    const dword pages = own.count();
+    put(static_cast<byte>(pages));
+    put(static_cast<byte>(pages >> 8));
+    own.forEach([this](dword page) {
+        put(static_cast<byte>(page));
+        const byte* data = this->cpu.mem.pageData(page);
+        for (dword i{0}; i < Page::SIZE; ++i) put(data[i]);
+    });
+    if (devices) mapped.forEach([this](dword page) { this->cpu.mem.map(tap, page, 1); });
+}
+
+m6502::InputRecorder::~InputRecorder() {
+    detach();
+}
+
+void m6502::InputRecorder::detach() {
+    if (devices) mapped.forEach([this](dword page) { cpu.mem.map(*devices, page, 1); });
+    devices = nullptr;
+}
+
+void m6502::InputRecorder::put(byte value) {
+    log.put(static_cast<char>(value));
+    stats.bytes++;
+}
+
+void m6502::InputRecorder::event(InputEvent kind, uint64_t at) {
+    for (uint64_t delta = at - lastEvent;; delta >>= 7) {
+        if (delta < 0x80) {
+            put(static_cast<byte>(delta));
+            break;
+        }
+        put(static_cast<byte>(delta | 0x80));
+    }
+    put(static_cast<byte>(kind));
+    lastEvent = at;
+    stats.events++;
+}
+
+uint64_t m6502::InputRecorder::accessCycle() const {
+    return queue ? queue->now() - queueStart : cycle + cpu.runCycles();
+}
+
+void m6502::InputRecorder::checkLines(uint64_t at) {
+    for (; nmiEdges != cpu.nmiEdges; ++nmiEdges) event(InputEvent::NMI, at);
+    if ((cpu.interrupts & CPU::IRQ) != irq) {
+        irq = cpu.interrupts & CPU::IRQ;
+        event(irq ? InputEvent::IRQ_ASSERT : InputEvent::IRQ_RELEASE, at);
+    }
+}
+
+m6502::byte m6502::InputRecorder::Tap::read(word address) {
+    const byte value = recorder.devices->read(address);
+    //the host's own reads between runs are not the CPU's inputs
+    if (recorder.running) {
+        const uint64_t at = recorder.accessCycle();
+        recorder.event(InputEvent::READ, at);
+        recorder.put(static_cast<byte>(address));
+        recorder.put(static_cast<byte>(address >> 8));
+        recorder.put(value);
+        recorder.checkLines(at);
+    }
+    return value;
+}
+
+void m6502::InputRecorder::Tap::write(word address, byte data) {
+    recorder.devices->write(address, data);
+    if (recorder.running) recorder.checkLines(recorder.accessCycle());
+}
+
+uint64_t m6502::InputRecorder::run(uint64_t cycles) {
+    if (finished) return 0;
+    const uint64_t start = cycle;
+    const uint64_t end = cycle + cycles;
+    checkLines(cycle);
+    running = true;
+    while (cycle < end && !stopped) {
+        if (queue) {
+            //up to the next event at most, so that what it does to the lines is logged at the cycle it fired at
+            const uint64_t now = queue->now(), next = queue->next();
+            cycle += queue->run(cpu, next <= now ? 0 : std::min(end - cycle, next - now));
+            stopped = queue->isStopped();
+        } else {
+            cycle += cpu.run(end - cycle, stopped);
+        }
+        checkLines(cycle);
+    }
+    running = false;
+    return cycle - start;
+}
+
+void m6502::InputRecorder::write(word address, byte value) {
+    if (finished) return;
+    cpu.mem.write(address, value);
+    event(InputEvent::WRITE, cycle);
+    put(static_cast<byte>(address));
+    put(static_cast<byte>(address >> 8));
+    put(value);
+    checkLines(cycle);
+}
+
+void m6502::InputRecorder::finish() {
+    if (finished) return;
+    checkLines(cycle);
+    event(InputEvent::END, cycle);
+    log.flush();
+    finished = true;
+    detach();
+}
+
+m6502::InputReplayer::InputReplayer(CPU& cpu, std::istream& log) : cpu(cpu), log(log) {}
+
+bool m6502::InputReplayer::get(byte& value) {
+    const int c = log.get();
+    if (c == std::char_traits<char>::eof()) return false;
+    value = static_cast<byte>(c);
+    return true;
+}
+
+bool m6502::InputReplayer::getVarint(uint64_t& value) {
+    value = 0;
+    for (int shift{0}; shift < 64; shift += 7) {
+        byte part;
+        if (!get(part)) return false;
+        value |= static_cast<uint64_t>(part & 0x7F) << shift;
+        if (!(part & 0x80)) return true;
+    }
+    return false;
+}
+
+bool m6502::InputReplayer::getEvent() {
+    uint64_t delta;
+    byte kind;
+    if (!getVarint(delta) || !get(kind)) return false;
+    next.cycle += delta;
+    next.kind = static_cast<InputEvent>(kind);
+    switch (next.kind) {
+        case InputEvent::WRITE:
+        case InputEvent::READ: {
+            byte low, high;
+            if (!get(low) || !get(high) || !get(next.value)) return false;
+            next.address = static_cast<word>(low | high << 8);
+            return true;
+        }
+        case InputEvent::IRQ_ASSERT:
+        case InputEvent::IRQ_RELEASE:
+        case InputEvent::NMI:
+        case InputEvent::END:
+            return true;
+    }
+    return false;
+}
+
+bool m6502::InputReplayer::loadState() {
+    char magic[sizeof MAGIC];
+    if (!log.read(magic, sizeof magic) || std::memcmp(magic, MAGIC, sizeof magic)) return false;
+    byte registers[8], count[2];
+    for (byte& value : registers)
+        if (!get(value)) return false;
+    Memory::PageSet recorded;
+    for (uint64_t& bits : recorded.words) {
+        for (dword shift{0}; shift < 64; shift += 8) {
+            byte part;
+            if (!get(part)) return false;
+            bits |= uint64_t{part} << shift;
+        }
+    }
+    if (!get(count[0]) || !get(count[1])) return false;
+    devices = cpu.mem.getBus();
+    cpu.mem.usedPages().forEach([this](dword page) {
+        if (cpu.mem.isMapped(page)) devicePages.set(page);
+    });
+    cpu.mem.initialize();
+    for (dword pages = count[0] | count[1] << 8; pages; --pages) {
+        byte page, data;
+        if (!get(page)) return false;
+        //the replaying CPU's own devices and shared ram are not written to
+        const bool skip = recorded.test(page) || cpu.mem.isMapped(page) || cpu.mem.isPinned(page);
+        for (dword i{0}; i < Page::SIZE; ++i) {
+            if (!get(data)) return false;
+            if (!skip) cpu.mem.write(static_cast<word>(page << 8 | i), data);
+        }
+    }
+    recorded.forEach([this](dword page) { cpu.mem.map(feed, page, 1); });
+    recordedPages = recorded;
+    cpu.PC = static_cast<word>(registers[0] | registers[1] << 8);
+    cpu.SP = registers[2];
+    cpu.A = registers[3];
+    cpu.X = registers[4];
+    cpu.Y = registers[5];
+    cpu.PS = registers[6];
+    cpu.interrupts = registers[7];
+    return true;
+}
+
+void m6502::InputReplayer::detach() {
+    recordedPages.forEach([this](dword page) {
+        if (!devicePages.test(page)) cpu.mem.unmap(page, 1);
+    });
+    if (devices) devicePages.forEach([this](dword page) { cpu.mem.map(*devices, page, 1); });
+    recordedPages.clear();
+    devicePages.clear();
+    devices = nullptr;
+}
+
+m6502::byte m6502::InputReplayer::Feed::read(word address) {
+    const Event& expected = replayer.next;
+    const uint64_t at = replayer.cycle + replayer.cpu.runCycles();
+    if (replayer.diverged || expected.kind != InputEvent::READ || expected.address != address || expected.cycle != at) {
+        replayer.diverged = true;
+        return 0;
+    }
+    const byte value = expected.value;
+    replayer.reads++;
+    replayer.stats.events++;
+    if (!replayer.getEvent()) replayer.diverged = true;
+    return value;
+}
+
+bool m6502::InputReplayer::runTo(uint64_t target) {
+    if (cycle < target) cycle += cpu.run(target - cycle, stopped);
+    //past target only for what a device access did in the middle of the instruction before
+    return cycle >= target;
+}
+
+bool m6502::InputReplayer::run() {
+    const auto start = std::chrono::steady_clock::now();
+    stats = Stats{};
+    next = Event{};
+    cycle = reads = 0;
+    stopped = diverged = false;
+    //paced or not while recording, the replay does not wait
+    VirtualClock unpaced;
+    Clock& clock = cpu.cycles.getClock();
+    cpu.cycles.setClock(unpaced);
+
+    bool ok = loadState() && getEvent();
+    for (bool ended = !ok; !ended;) {
+        if (next.kind == InputEvent::READ) {
+            //the CPU takes it itself, through the feed, in the instruction that reaches its cycle
+            const uint64_t served = reads;
+            if (cycle <= next.cycle) cycle += cpu.run(next.cycle + 1 - cycle, stopped);
+            ok = !diverged && reads != served;
+            ended = !ok;
+            continue;
+        }
+        if (!runTo(next.cycle) || diverged) {
+            ok = false;
+            break;
+        }
+        stats.events++;
+        switch (next.kind) {
+            case InputEvent::WRITE:
+                cpu.mem.write(next.address, next.value);
+                break;
+            case InputEvent::IRQ_ASSERT:
+                cpu.irq(true);
+                break;
+            case InputEvent::IRQ_RELEASE:
+                cpu.irq(false);
+                break;
+            case InputEvent::NMI:
+                cpu.nmi();
+                break;
+            default:
+                ended = true;
+        }
+        if (ended) {
+            ok = cycle == next.cycle;
+        } else if (!getEvent()) {
+            ok = false;
+            ended = true;
+        }
+    }
+
+    detach();
+    cpu.cycles.setClock(clock);
+    stats.cycles = cycle;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return ok;
+}
@@ -0,0 +1,153 @@
+#ifndef INC_6502_EMULATION_6502REPLAY_H
+#define INC_6502_EMULATION_6502REPLAY_H
+
+#include "6502Events.h"
+#include <istream>
+#include <ostream>
+
+namespace m6502 {
+    class InputRecorder;
+    class InputReplayer;
+    //kinds of events in an input log
+    enum class InputEvent : byte { WRITE = 0x01, READ = 0x02, IRQ_ASSERT = 0x03, IRQ_RELEASE = 0x04, NMI = 0x05, END = 0xFF };
+}
+
+/* Everything a CPU does follows from its state except what the host and its devices hand it
+ * while it runs. The recorder logs only those inputs, each with the cycle it arrived at, so
+ * that the replayer can run a whole session again, unpaced and without the devices, and end
+ * in the same state bit for bit.
+ *
+ * The log is append only: a header with the registers, the interrupt lines, the pages that
+ * go to devices and the other pages memory uses when recording starts, shared ram left out,
+ * then one event per input. An event is the cycles since the one before as a little endian
+ * base 128 varint, a kind byte and the kind's payload:
+ *   WRITE        address (2 bytes, little endian), value (1 byte): the host wrote memory
+ *   READ         address (2 bytes, little endian), value (1 byte): the CPU read a device
+ *   IRQ_ASSERT   nothing, the IRQ line went up
+ *   IRQ_RELEASE  nothing, the IRQ line went down
+ *   NMI          nothing, an edge on the NMI line
+ *   END          nothing, the session ran until this cycle
+ * Host inputs and what events do to the lines arrive between instructions, where the CPU
+ * stops when run for a number of cycles, so the replayer reaches their cycle exactly. Reads
+ * and the line changes a device access makes happen in the middle of an instruction at the
+ * cycle of the access; the CPU only looks at its lines between instructions, so the replayer
+ * applies those at the end of it. */
+class m6502::InputRecorder {
+public:
+    struct Stats {
+        uint64_t events;
+        uint64_t bytes;             //of the log, header included
+    };
+
+    /* writes the header, cycles count from here; the CPU, log and queue belong to the caller.
+     * With a queue, run() runs the CPU through it so that its events fire. Attach the devices
+     * before, the recorder goes between them and the CPU until finish() */
+    InputRecorder(CPU& cpu, std::ostream& log, EventQueue* queue = nullptr);
+    ~InputRecorder();
+    InputRecorder(const InputRecorder&) = delete;
+    InputRecorder& operator=(const InputRecorder&) = delete;
+
+    //runs for cycles more cycles, or until the CPU stops on an unhandled opcode, returns the cycles run
+    uint64_t run(uint64_t cycles);
+    //the host puts value into memory at address, now
+    void write(word address, byte value);
+    //ends the log, the recorder takes nothing after this
+    void finish();
+
+    uint64_t now() const { return cycle; }
+    bool isStopped() const { return stopped; }
+    const Stats& getStats() const { return stats; }
+
+private:
+    //passes the CPU's accesses on to its devices and logs what they answered
+    struct Tap : Bus {
+        explicit Tap(InputRecorder& recorder) : recorder(recorder) {}
+        byte read(word address) override;
+        void write(word address, byte data) override;
+        InputRecorder& recorder;
+    };
+
+    //the cycle of an access during run()
+    uint64_t accessCycle() const;
+    //logs what changed on the interrupt lines since the last look
+    void checkLines(uint64_t at);
+    void event(InputEvent kind, uint64_t at);
+    void put(byte value);
+    //gives the device pages back to the devices
+    void detach();
+
+    CPU& cpu;
+    std::ostream& log;
+    EventQueue* queue;
+    uint64_t queueStart{0};     //the queue's cycle when recording started
+    Tap tap{*this};
+    Bus* devices{nullptr};
+    Memory::PageSet mapped;
+    uint64_t cycle{0};
+    uint64_t lastEvent{0};
+    byte irq{0};
+    uint64_t nmiEdges{0};
+    bool running{false};
+    bool stopped{false};
+    bool finished{false};
+    Stats stats{};
+};
+
+class m6502::InputReplayer {
+public:
+    struct Stats {
+        uint64_t events;
+        uint64_t cycles;
+        double seconds;
+        double cyclesPerSecond() const { return seconds > 0 ? cycles / seconds : 0; }
+    };
+
+    /* the CPU belongs to the caller, run() puts it into the recorded state first. The pages
+     * that went to devices answer from the log while it runs and read as 0 afterwards, where
+     * the CPU has no devices of its own */
+    InputReplayer(CPU& cpu, std::istream& log);
+
+    /* runs the session as fast as the host can, whatever the CPU's clock. False when the log
+     * is damaged or ends early, or the CPU did not reach the cycle of an event or read a
+     * device other than it did while recording */
+    bool run();
+    uint64_t now() const { return cycle; }
+    const Stats& getStats() const { return stats; }
+
+private:
+    //answers the CPU's device reads from the log, drops its device writes
+    struct Feed : Bus {
+        explicit Feed(InputReplayer& replayer) : replayer(replayer) {}
+        byte read(word address) override;
+        void write(word, byte) override {}
+        InputReplayer& replayer;
+    };
+    struct Event {
+        uint64_t cycle;
+        InputEvent kind;
+        word address;
+        byte value;
+    };
+
+    bool get(byte& value);
+    bool getVarint(uint64_t& value);
+    bool getEvent();
+    bool loadState();
+    bool runTo(uint64_t target);
+    //gives the device pages back to the CPU's own devices
+    void detach();
+
+    CPU& cpu;
+    std::istream& log;
+    Feed feed{*this};
+    Bus* devices{nullptr};
+    Memory::PageSet devicePages, recordedPages;
+    Event next{};
+    uint64_t cycle{0};
+    uint64_t reads{0};
+    bool stopped{false};
+    bool diverged{false};
+    Stats stats{};
+};
+
+#endif //INC_6502_EMULATION_6502REPLAY_H
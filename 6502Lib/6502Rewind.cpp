@@ -0,0 +1,68 @@
+#include "6502Rewind.h"
+#include "6502Mapper.h"
+#include <algorithm>
+#include <chrono>
+
+constexpr uint64_t m6502::Rewinder::DEFAULT_INTERVAL;
+
+m6502::Rewinder::Rewinder(CPU& cpu, size_t budgetBytes, uint64_t interval, Mapper* mapper)
+        : cpu(cpu), mapper(mapper), budgetBytes(budgetBytes), interval(std::max<uint64_t>(interval, 1)) {
+    take();
+}
+
+void m6502::Rewinder::take() {
+    if (!ring.empty()) {
+        //what the last snapshot came to own, since the CPU wrote those pages after it
+        const size_t pages = cpu.mem.dirtyPages().count() * Page::SIZE;
+        ring.back().bytes += pages;
+        stats.bytes += pages;
+    }
+    ring.push_back({cycle, cpu.snapshot(), mapper ? mapper->selection() : std::vector<dword>{}, sizeof(Entry)});
+    stats.bytes += sizeof(Entry);
+    stats.taken++;
+    while (stats.bytes > budgetBytes && ring.size() > 1) {
+        stats.bytes -= ring.front().bytes;
+        ring.pop_front();
+        stats.dropped++;
+    }
+    stats.snapshots = ring.size();
+    nextSnapshot = cycle + interval;
+}
+
+void m6502::Rewinder::runTo(uint64_t target) {
+    if (cycle < target) cycle += cpu.run(target - cycle, stopped);
+}
+
+uint64_t m6502::Rewinder::run(uint64_t cycles) {
+    const uint64_t start = cycle;
+    const uint64_t end = cycle + cycles;
+    while (cycle < end && !stopped) {
+        runTo(std::min(end, nextSnapshot));
+        if (cycle >= nextSnapshot) take();
+    }
+    return cycle - start;
+}
+
+bool m6502::Rewinder::rewindTo(uint64_t target) {
+    if (target < earliest() || target > cycle) return false;
+    const auto start = std::chrono::steady_clock::now();
+    //the last snapshot at or before target, everything after it belongs to the future we leave
+    while (ring.back().cycle > target) {
+        stats.bytes -= ring.back().bytes;
+        ring.pop_back();
+    }
+    Entry& from = ring.back();
+    stats.bytes -= from.bytes - sizeof(Entry);
+    from.bytes = sizeof(Entry);
+    cpu.restore(from.snapshot);
+    if (mapper) mapper->restore(from.banks);
+    cycle = from.cycle;
+    stopped = false;
+    runTo(target);
+    nextSnapshot = from.cycle + interval;
+    stats.snapshots = ring.size();
+    stats.rewinds++;
+    stats.replayedCycles = cycle - from.cycle;
+    stats.rewindSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
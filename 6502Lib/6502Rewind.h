@@ -0,0 +1,74 @@
+#ifndef INC_6502_EMULATION_6502REWIND_H
+#define INC_6502_EMULATION_6502REWIND_H
+
+#include "6502.h"
+#include <deque>
+#include <vector>
+
+namespace m6502 {
+    class Rewinder;
+    class Mapper;
+}
+
+/* Runs a CPU and lets it go back to any earlier cycle. Every interval cycles it takes a
+ * snapshot, which shares all pages with the CPU and only comes to own the pages the CPU
+ * writes until the next one, so a snapshot costs the pages dirtied in its interval. The
+ * snapshots sit in a ring that drops the oldest once they hold more than the budget.
+ * Going back restores the nearest snapshot at or before the cycle and runs forward from
+ * there, which never takes more than an interval of cycles.
+ *
+ * Cycles count from the construction of the rewinder. Execution only stops between
+ * instructions, so a rewind lands at the end of the instruction running at that cycle.
+ * A mapper with windows in the CPU's memory goes back to the banks selected then as well. */
+class m6502::Rewinder {
+public:
+    static constexpr uint64_t DEFAULT_INTERVAL = 100000;
+
+    struct Stats {
+        size_t snapshots;           //held now
+        size_t bytes;               //held by the snapshots beyond what the CPU holds itself
+        uint64_t taken;
+        uint64_t dropped;           //to stay within the budget
+        uint64_t rewinds;
+        uint64_t replayedCycles;    //run forward by the last rewind
+        double rewindSeconds;       //of the last rewind
+    };
+
+    //the CPU and mapper belong to the caller, the CPU has to be run through the rewinder from here on
+    Rewinder(CPU& cpu, size_t budgetBytes, uint64_t interval = DEFAULT_INTERVAL, Mapper* mapper = nullptr);
+
+    //runs for cycles more cycles, or until the CPU stops on an unhandled opcode, returns the cycles run
+    uint64_t run(uint64_t cycles);
+    //false when cycle is before earliest() or after now(), the CPU is left as it was then
+    bool rewindTo(uint64_t cycle);
+
+    uint64_t now() const { return cycle; }
+    //the earliest cycle a rewind can still reach
+    uint64_t earliest() const { return ring.front().cycle; }
+    bool isStopped() const { return stopped; }
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct Entry {
+        uint64_t cycle;
+        CPU::Snapshot snapshot;
+        std::vector<dword> banks;   //of the mapper
+        size_t bytes;               //pages the CPU wrote after it, the whole entry once the next is taken
+    };
+
+    void take();
+    //runs forward to target, at most one instruction past it
+    void runTo(uint64_t target);
+
+    CPU& cpu;
+    Mapper* mapper;
+    size_t budgetBytes;
+    uint64_t interval;
+    uint64_t cycle{0};
+    uint64_t nextSnapshot{0};
+    bool stopped{false};
+    std::deque<Entry> ring;
+    Stats stats{};
+};
+
+#endif //INC_6502_EMULATION_6502REWIND_H
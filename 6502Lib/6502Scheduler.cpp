@@ -0,0 +1,97 @@
+#include "6502Scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <unordered_set>
+
+constexpr m6502::sdword m6502::Scheduler::MIN_QUANTUM;
+constexpr m6502::sdword m6502::Scheduler::MAX_QUANTUM;
+constexpr m6502::sdword m6502::Scheduler::CYCLES_PER_LINE;
+constexpr m6502::dword m6502::Scheduler::LINE_SIZE;
+
+m6502::Scheduler::Scheduler(size_t cacheBytes) : cacheBytes(cacheBytes) {}
+
+size_t m6502::Scheduler::detectCacheSize() {
+    std::ifstream file{"/sys/devices/system/cpu/cpu0/cache/index2/size"};
+    size_t size;
+    char unit{'K'};
+    if (!(file >> size)) return 1024 * 1024;
+    file >> unit;
+    return unit == 'M' ? size * 1024 * 1024 : unit == 'K' ? size * 1024 : size;
+}
+
+size_t m6502::Scheduler::add(CPU& cpu) {
+    instances.push_back({&cpu, 0, 0, 0, 0, MIN_QUANTUM, 0, 0, false});
+    return instances.size() - 1;
+}
+
+//footprints, quanta and the order of the next run
+void m6502::Scheduler::plan() {
+    size_t total{0};
+    std::unordered_set<size_t> groups;
+    for (Instance& instance : instances) {
+        const Memory& mem = instance.cpu->mem;
+        const Memory::PageSet shared = mem.sharedPages();
+        size_t group{0};
+        shared.forEach([&](dword page) {
+            group = group * 31 + std::hash<const void*>{}(mem.pageData(page));
+        });
+        instance.group = group;
+        instance.footprint = (mem.usedPages().count() - shared.count()) * Page::SIZE + sizeof(CPU);
+        total += instance.footprint;
+        //shared pages stay cached for the whole group, so they count once
+        if (groups.insert(group).second) total += shared.count() * Page::SIZE;
+    }
+    stats.footprintBytes = total;
+
+    const bool fits = total <= cacheBytes;
+    for (Instance& instance : instances) {
+        const auto lines = static_cast<sdword>(instance.footprint / LINE_SIZE);
+        instance.quantum = fits ? MIN_QUANTUM : std::max(MIN_QUANTUM, std::min(MAX_QUANTUM, lines * CYCLES_PER_LINE));
+    }
+
+    order.resize(instances.size());
+    for (size_t i{0}; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) { return instances[a].group < instances[b].group; });
+}
+
+void m6502::Scheduler::run(uint64_t cycles) {
+    plan();
+    const auto start = std::chrono::steady_clock::now();
+    stats.quanta = stats.instructions = stats.cycles = stats.maxWaitCycles = 0;
+    for (Instance& instance : instances) {
+        instance.owed += static_cast<int64_t>(cycles);
+        instance.runCycles = 0;
+        instance.lastSeen = 0;
+    }
+    for (bool any = true; any;) {
+        any = false;
+        for (size_t index : order) {
+            Instance& instance = instances[index];
+            if (instance.stopped || instance.owed <= 0) continue;
+            stats.maxWaitCycles = std::max(stats.maxWaitCycles, stats.cycles - instance.lastSeen);
+            const auto budget = static_cast<uint64_t>(std::min<int64_t>(instance.quantum, instance.owed));
+            const uint64_t used = instance.cpu->run(budget, instance.stopped);
+            instance.owed -= static_cast<int64_t>(used);
+            instance.cycles += used;
+            instance.runCycles += used;
+            stats.quanta++;
+            stats.cycles += used;
+            stats.instructions += instance.cpu->instructionsExecuted;
+            instance.lastSeen = stats.cycles;
+            any = true;
+        }
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double sum{0}, squares{0};
+    size_t running{0};
+    for (const Instance& instance : instances) {
+        if (instance.stopped) continue;
+        sum += static_cast<double>(instance.runCycles);
+        squares += static_cast<double>(instance.runCycles) * instance.runCycles;
+        running++;
+    }
+    stats.fairness = squares > 0 ? sum * sum / (running * squares) : 1;
+}
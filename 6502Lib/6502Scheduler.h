@@ -0,0 +1,79 @@
+#ifndef INC_6502_EMULATION_6502SCHEDULER_H
+#define INC_6502_EMULATION_6502SCHEDULER_H
+
+#include "6502.h"
+#include <vector>
+
+namespace m6502 {
+    class Scheduler;
+}
+
+/* Runs many CPUs on the calling thread, round robin, each for a quantum of cycles at a time.
+ * Short quanta are fair but every switch brings the next instance's pages back into cache,
+ * so the quantum of an instance grows with its cache footprint, measured as the pages its
+ * memory uses, once the footprints of all instances no longer fit into the cache together.
+ * Instances that share rom pages run one after the other so those pages stay cached.
+ *
+ * The CPUs belong to the caller and stay where they are; the scheduler only keeps pointers. */
+class m6502::Scheduler {
+public:
+    //below this there is no point in switching, above it instances wait too long
+    static constexpr sdword MIN_QUANTUM = 1000;
+    static constexpr sdword MAX_QUANTUM = 1 << 20;
+    /* cycles a quantum should last per cache line of footprint: refilling a line from memory
+     * costs about as much as 25 emulated cycles, and refills should stay below a tenth */
+    static constexpr sdword CYCLES_PER_LINE = 250;
+    static constexpr dword LINE_SIZE = 64;
+
+    struct Stats {
+        uint64_t quanta;
+        uint64_t instructions;
+        uint64_t cycles;
+        double seconds;
+        //Jain's index over the cycles every running instance got, 1 when they got the same
+        double fairness;
+        //most cycles other instances ran between two quanta of one instance
+        uint64_t maxWaitCycles;
+        size_t footprintBytes;      //of all instances together, as of the last run
+        double cyclesPerSecond() const { return seconds > 0 ? cycles / seconds : 0; }
+        double averageQuantum() const { return quanta ? static_cast<double>(cycles) / quanta : 0; }
+    };
+
+    //bytes of the cache instances should share, by default the L2 of the first host CPU
+    explicit Scheduler(size_t cacheBytes = detectCacheSize());
+    static size_t detectCacheSize();
+
+    size_t add(CPU& cpu);
+    size_t size() const { return instances.size(); }
+
+    //every instance runs for cycles more cycles, or until it stops on an unhandled opcode
+    void run(uint64_t cycles);
+    bool isStopped(size_t instance) const { return instances[instance].stopped; }
+    //cycles an instance ran over all runs
+    uint64_t getCycles(size_t instance) const { return instances[instance].cycles; }
+    sdword getQuantum(size_t instance) const { return instances[instance].quantum; }
+    //of the last run
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct Instance {
+        CPU* cpu;
+        int64_t owed;           //cycles still to run in this run, below 0 after an overshoot
+        uint64_t cycles;
+        uint64_t runCycles;     //in this run
+        uint64_t lastSeen;      //total cycles run by everyone when its last quantum ended
+        sdword quantum;
+        size_t footprint;
+        size_t group;           //fingerprint of the shared pages
+        bool stopped;
+    };
+
+    void plan();
+
+    size_t cacheBytes;
+    std::vector<Instance> instances;
+    std::vector<size_t> order;  //instances of a group next to each other
+    Stats stats{};
+};
+
+#endif //INC_6502_EMULATION_6502SCHEDULER_H
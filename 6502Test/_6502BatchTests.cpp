@@ -0,0 +1,107 @@
+#include "gtest/gtest.h"
+#include "6502Batch.h"
+
+class _6502BatchTests : public testing::Test {
+public:
+    virtual void SetUp() {}
+    virtual void TearDown() {}
+
+    //A = in[0] ^ in[1]; out[0] = A; out[1] = in[0]
+    static m6502::BatchJob MakeJob(m6502::byte first, m6502::byte second) {
+        m6502::BatchJob job{};
+        job.image.push_back({0x8000, {
+                m6502::CPU::INS_LDA_ZP, 0x10,
+                m6502::CPU::INS_EOR_ZP, 0x11,
+                m6502::CPU::INS_STA_ZP, 0x20,
+                m6502::CPU::INS_LDX_ZP, 0x10,
+                m6502::CPU::INS_STX_ZP, 0x21,
+                m6502::CPU::INS_JAM}});
+        job.image.push_back({0x0010, {first, second}});
+        job.start = 0x8000;
+        job.instructions = 100;     //stops on the JAM after the program
+        job.resultAddress = 0x0020;
+        job.resultLength = 2;
+        return job;
+    }
+};
+
+TEST_F(_6502BatchTests, BatchRunsEveryJob) {
+    std::vector<m6502::BatchJob> jobs;
+    for (int i{0}; i < 1000; ++i)
+        jobs.push_back(MakeJob(i & 0xFF, (i * 7) >> 2));
+    m6502::BatchRunner runner{4};
+    auto results = runner.run(jobs);
+
+    ASSERT_EQ(results.size(), jobs.size());
+    for (int i{0}; i < 1000; ++i) {
+        m6502::byte first = i & 0xFF, second = (i * 7) >> 2;
+        EXPECT_EQ(results[i].memory[0], static_cast<m6502::byte>(first ^ second));
+        EXPECT_EQ(results[i].memory[1], first);
+        EXPECT_EQ(results[i].instructions, 5u);
+        EXPECT_EQ(results[i].cycles, 16u);
+    }
+    EXPECT_EQ(runner.getStats().jobs, 1000u);
+    EXPECT_EQ(runner.getStats().instructions, 5000u);
+    EXPECT_EQ(runner.getStats().cycles, 16000u);
+}
+
+TEST_F(_6502BatchTests, ResultsDoNotDependOnThreadCount) {
+    std::vector<m6502::BatchJob> jobs;
+    for (int i{0}; i < 300; ++i)
+        jobs.push_back(MakeJob(i * 13, i * 29));
+    m6502::BatchRunner single{1}, many{8};
+    auto expected = single.run(jobs);
+    for (int run{0}; run < 3; ++run) {
+        auto results = many.run(jobs);
+        for (size_t i{0}; i < jobs.size(); ++i) {
+            EXPECT_EQ(results[i].memory, expected[i].memory);
+            EXPECT_EQ(results[i].A, expected[i].A);
+            EXPECT_EQ(results[i].X, expected[i].X);
+            EXPECT_EQ(results[i].PC, expected[i].PC);
+            EXPECT_EQ(results[i].PS, expected[i].PS);
+        }
+    }
+}
+
+TEST_F(_6502BatchTests, WorkersStartEachJobFromAResetCPU) {
+    //the first job leaves memory and registers dirty, the second must not see it
+    std::vector<m6502::BatchJob> jobs{MakeJob(0x42, 0x00), MakeJob(0x00, 0x00)};
+    m6502::BatchRunner runner{1};
+    auto results = runner.run(jobs);
+
+    EXPECT_EQ(results[1].memory[0], 0x00);
+    EXPECT_EQ(results[1].memory[1], 0x00);
+    EXPECT_TRUE(results[1].PS.test(m6502::CPU::StatusFlags::Z));
+}
+
+TEST_F(_6502BatchTests, EmptyBatchReturnsNoResults) {
+    m6502::BatchRunner runner{2};
+    EXPECT_TRUE(runner.run({}).empty());
+    EXPECT_EQ(runner.getStats().jobs, 0u);
+}
+
+TEST_F(_6502BatchTests, NumaAwareRunnerGivesTheSameResults) {
+    std::vector<m6502::BatchJob> jobs;
+    for (int i{0}; i < 200; ++i)
+        jobs.push_back(MakeJob(i & 0xFF, (i * 5) >> 1));
+    m6502::BatchRunner plain{3};
+    m6502::BatchRunner placed{3, true};
+    auto expected = plain.run(jobs);
+    auto results = placed.run(jobs);
+    ASSERT_EQ(results.size(), expected.size());
+    for (size_t i{0}; i < results.size(); ++i) {
+        EXPECT_EQ(results[i].memory, expected[i].memory);
+        EXPECT_EQ(results[i].cycles, expected[i].cycles);
+    }
+    EXPECT_EQ(plain.getStats().localPages + plain.getStats().remotePages, 0u);
+    const auto& stats = placed.getStats();
+    if (m6502::NumaTopology::detect().size() == 1) {
+        EXPECT_EQ(stats.remotePages, 0u);
+    }
+    //every worker's CPU at least, where the kernel tells
+    if (m6502::NumaTopology::nodesOf({&jobs})[0] >= 0) {
+        EXPECT_GE(stats.localPages + stats.remotePages, 3u);
+    }
+    EXPECT_GE(stats.localRatio(), 0.0);
+    EXPECT_LE(stats.localRatio(), 1.0);
+}
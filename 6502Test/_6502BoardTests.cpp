@@ -0,0 +1,166 @@
+#include "gtest/gtest.h"
+#include "6502Board.h"
+#include <memory>
+#include <vector>
+
+class _6502BoardTests : public testing::Test {
+public:
+    m6502::VirtualClock clock;
+    virtual void SetUp() {}
+    virtual void TearDown() {}
+
+    std::unique_ptr<m6502::CPU> MakeCPU(std::initializer_list<m6502::byte> program) {
+        std::unique_ptr<m6502::CPU> cpu{new m6502::CPU{clock}};
+        m6502::word address{0x8000};
+        for (m6502::byte value : program)
+            cpu->mem[address++] = value;
+        cpu->PC = 0x8000;
+        return cpu;
+    }
+
+    /* the first CPU posts a byte at $0202 and then points the vector at $0200 to $9000, which
+     * the second one jumps through until it leads there, to store what it finds at $10 */
+    void ExpectMailboxHandshake(m6502::Board& board) {
+        using CPU = m6502::CPU;
+        auto sender = MakeCPU({CPU::INS_LDA_IM, 0x42, CPU::INS_STA_ABS, 0x02, 0x02,
+                               CPU::INS_LDA_IM, 0x90, CPU::INS_STA_ABS, 0x01, 0x02, CPU::INS_JAM});
+        auto receiver = MakeCPU({CPU::INS_JMP_IND, 0x00, 0x02});
+        receiver->mem[0x9000] = CPU::INS_LDA_ABS;
+        receiver->mem[0x9001] = 0x02;
+        receiver->mem[0x9002] = 0x02;
+        receiver->mem[0x9003] = CPU::INS_STA_ZP;
+        receiver->mem[0x9004] = 0x10;
+        receiver->mem[0x9005] = CPU::INS_JAM;
+        board.share(0x0200, 0x100);
+        board.add(*sender);
+        board.add(*receiver);
+        receiver->mem.write(0x0201, 0x80);
+
+        board.run(10000);
+        EXPECT_TRUE(board.isStopped(0));
+        EXPECT_TRUE(board.isStopped(1));
+        EXPECT_EQ(receiver->mem[0x10], 0x42);
+        EXPECT_EQ(receiver->mem.read(0x0201), 0x90);
+        EXPECT_EQ(sender->mem.read(0x0202), 0x42);
+    }
+
+    /* the first CPU keeps storing its stack pointer at $0200 and pushing, the second keeps
+     * pushing what it reads there; returns the stack page of the second */
+    std::vector<m6502::byte> StrictReads(m6502::sdword quantum) {
+        using CPU = m6502::CPU;
+        auto writer = MakeCPU({CPU::INS_TSX_IMP, 0x00, CPU::INS_STX_ABS, 0x00, 0x02,
+                               CPU::INS_PHA_IMP, 0x00, CPU::INS_JMP_ABS, 0x00, 0x80});
+        auto reader = MakeCPU({CPU::INS_LDA_ABS, 0x00, 0x02, CPU::INS_PHA_IMP, 0x00, CPU::INS_JMP_ABS, 0x00, 0x80});
+        m6502::Board board{quantum, true};
+        board.share(0x0200, 1);
+        board.add(*writer);
+        board.add(*reader);
+        board.run(5000);
+        board.run(5000);
+        EXPECT_GT(board.getStats().sharedAccesses, 0u);
+        std::vector<m6502::byte> stack;
+        for (m6502::word address{0x0100}; address < 0x0200; ++address)
+            stack.push_back(reader->mem[address]);
+        stack.push_back(reader->SP);
+        return stack;
+    }
+};
+
+TEST_F(_6502BoardTests, CPUsHandOverDataThroughSharedRam) {
+    m6502::Board board{100};
+    ExpectMailboxHandshake(board);
+}
+
+TEST_F(_6502BoardTests, CPUsHandOverDataThroughSharedRamInStrictMode) {
+    m6502::Board board{100, true};
+    ExpectMailboxHandshake(board);
+    EXPECT_TRUE(board.isStrict());
+}
+
+TEST_F(_6502BoardTests, MemoryOutsideTheSharedRegionsStaysPrivate) {
+    auto first = MakeCPU({m6502::CPU::INS_LDA_IM, 0x01, m6502::CPU::INS_STA_ZP, 0x10,
+                          m6502::CPU::INS_STA_ABS, 0x00, 0x03, m6502::CPU::INS_JAM});
+    auto second = MakeCPU({m6502::CPU::INS_JAM});
+    m6502::Board board;
+    board.add(*first);
+    board.add(*second);
+    //shared after the CPUs were added
+    board.share(0x0300, 1);
+    board.run(1000);
+
+    EXPECT_EQ(first->mem[0x10], 0x01);
+    EXPECT_EQ(second->mem[0x10], 0x00);
+    EXPECT_EQ(second->mem[0x0300], 0x01);
+}
+
+TEST_F(_6502BoardTests, StrictModeGivesTheSameResultEveryRun) {
+    const std::vector<m6502::byte> expected = StrictReads(100);
+    for (int run{0}; run < 3; ++run)
+        EXPECT_EQ(StrictReads(100), expected);
+    //the reader saw the writer's stack pointer go down
+    EXPECT_NE(expected[0xFF], expected[0xFE]);
+}
+
+TEST_F(_6502BoardTests, CPUsRunOnAfterTheirStrictBoardIsGone) {
+    using CPU = m6502::CPU;
+    struct Device : m6502::Bus {
+        m6502::byte read(m6502::word) override { return 0xEE; }
+        void write(m6502::word, m6502::byte) override {}
+    } device;
+    auto cpu = MakeCPU({CPU::INS_LDA_IM, 0x42, CPU::INS_STA_ABS, 0x00, 0x02, CPU::INS_JAM});
+    cpu->mem.map(device, 0xD0, 1);
+    {
+        m6502::Board board{100, true};
+        board.share(0x0200, 1);
+        board.add(*cpu);
+        board.run(1000);
+        EXPECT_TRUE(board.isStopped(0));
+    }
+    EXPECT_EQ(cpu->mem.getBus(), &device);
+    EXPECT_FALSE(cpu->mem.isMapped(0x02));
+    //LDA $0200; STA $10; LDA $D000; STA $11; JAM
+    const m6502::byte program[] {CPU::INS_LDA_ABS, 0x00, 0x02, CPU::INS_STA_ZP, 0x10,
+                                 CPU::INS_LDA_ABS, 0x00, 0xD0, CPU::INS_STA_ZP, 0x11, CPU::INS_JAM};
+    for (size_t i{0}; i < sizeof program; ++i)
+        cpu->mem[0x9000 + i] = program[i];
+    cpu->PC = 0x9000;
+    cpu->execute(UINT64_MAX);
+    EXPECT_EQ(cpu->mem[0x10], 0x42);
+    EXPECT_EQ(cpu->mem[0x11], 0xEE);
+}
+
+TEST_F(_6502BoardTests, CPUsStayWithinAQuantumOfEachOther) {
+    //a JMP to itself is 3 cycles, so a CPU ends its run at most 2 cycles late
+    auto first = MakeCPU({m6502::CPU::INS_JMP_ABS, 0x00, 0x80});
+    auto second = MakeCPU({m6502::CPU::INS_JMP_ABS, 0x00, 0x80});
+    m6502::Board board{250};
+    board.add(*first);
+    board.add(*second);
+    board.run(1000);
+
+    EXPECT_EQ(board.getStats().quanta, 4u);
+    EXPECT_EQ(board.now(), 1000u);
+    for (size_t i{0}; i < board.size(); ++i) {
+        EXPECT_FALSE(board.isStopped(i));
+        EXPECT_GE(board.getCycles(i), 1000u);
+        EXPECT_LE(board.getCycles(i), 1002u);
+    }
+    EXPECT_EQ(board.getStats().cycles, board.getCycles(0) + board.getCycles(1));
+}
+
+TEST_F(_6502BoardTests, StoppedCPUsSitOutTheRestOfTheRun) {
+    auto stops = MakeCPU({m6502::CPU::INS_JAM});
+    auto runs = MakeCPU({m6502::CPU::INS_JMP_ABS, 0x00, 0x80});
+    m6502::Board board{100};
+    board.add(*stops);
+    board.add(*runs);
+    board.run(300);
+    board.run(300);
+
+    EXPECT_TRUE(board.isStopped(0));
+    EXPECT_EQ(board.getCycles(0), 1u);
+    EXPECT_FALSE(board.isStopped(1));
+    EXPECT_GE(board.getCycles(1), 600u);
+    //the second run only counts its own cycles
+    EXPECT_LE(board.getStats().cycles, 302u);
+}
@@ -0,0 +1,57 @@
+#include "gtest/gtest.h"
+#include "6502.h"
+
+//records how the CPU drives its clock instead of waiting
+struct CountingClock : m6502::Clock {
+    CountingClock() : Clock{true} {}
+    void start() override { starts++; }
+    void tick() override { ticks++; }
+    int starts{0}, ticks{0};
+};
+
+class _6502ClockTests : public testing::Test {
+public:
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    virtual void SetUp() {
+        cpu.reset();
+        cpu.PC = 0xFFFC;
+    }
+    virtual void TearDown() {}
+};
+
+TEST_F(_6502ClockTests, VirtualClockCountsEveryCycle) {
+    cpu.mem[0xFFFC] = m6502::CPU::INS_JSR;     //6 cycles
+    cpu.mem[0xFFFD] = 0x00;
+    cpu.mem[0xFFFE] = 0x80;
+    cpu.mem[0x8000] = m6502::CPU::INS_LDA_ABSX;  //5 cycles, crosses a page
+    cpu.mem[0x8001] = 0xFF;
+    cpu.mem[0x8002] = 0x20;
+    cpu.mem[0x8003] = m6502::CPU::INS_RTS;     //6 cycles
+    cpu.X = 1;
+    constexpr m6502::dword EXPECTED_CYCLES = 17;
+    m6502::dword cyclesUsed = cpu.execute(3);
+
+    EXPECT_EQ(cyclesUsed, EXPECTED_CYCLES);
+    EXPECT_FALSE(clock.isPaced());
+}
+
+TEST_F(_6502ClockTests, PacedClockIsTickedOncePerCycle) {
+    CountingClock counting;
+    cpu.cycles.setClock(counting);
+    cpu.mem[0xFFFC] = m6502::CPU::INS_LDA_ZPX; //4 cycles
+    cpu.mem[0xFFFD] = 0x42;
+    cpu.mem[0xFFFE] = m6502::CPU::INS_STA_ABS; //4 cycles
+    m6502::dword cyclesUsed = cpu.execute(2);
+
+    EXPECT_EQ(cyclesUsed, 8);
+    EXPECT_EQ(counting.ticks, 8);
+    EXPECT_EQ(counting.starts, 1);
+}
+
+TEST_F(_6502ClockTests, ZeroFrequencyRunsOnAVirtualClock) {
+    m6502::CPU unthrottled{0};
+    EXPECT_FALSE(unthrottled.cycles.getClock().isPaced());
+    m6502::CPU paced{1};
+    EXPECT_TRUE(paced.cycles.getClock().isPaced());
+}
@@ -0,0 +1,191 @@
+#include "gtest/gtest.h"
+#include "6502Cycle.h"
+#include <vector>
+
+class _6502CycleTests : public testing::Test {
+public:
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    virtual void SetUp() {
+        cpu.reset();
+        cpu.PC = 0x8000;
+    }
+    virtual void TearDown() {}
+
+    void LoadProgram(m6502::word address, std::initializer_list<m6502::byte> program) {
+        for (m6502::byte value : program)
+            cpu.mem[address++] = value;
+    }
+
+    //runs a copy of cpu with execute() and cpu itself stepped, until both stop
+    void ExpectSameAsExecute() {
+        m6502::CPU reference = cpu;
+        const m6502::dword cycles = reference.execute(UINT64_MAX);
+        m6502::CycleCPU stepped{cpu};
+        EXPECT_EQ(stepped.run(UINT64_MAX), cycles);
+        EXPECT_TRUE(stepped.isStopped());
+        EXPECT_EQ(stepped.getInstructions(), reference.instructionsExecuted);
+        EXPECT_EQ(cpu.PC, reference.PC);
+        EXPECT_EQ(cpu.SP, reference.SP);
+        EXPECT_EQ(cpu.A, reference.A);
+        EXPECT_EQ(cpu.X, reference.X);
+        EXPECT_EQ(cpu.Y, reference.Y);
+        EXPECT_EQ(cpu.PS, reference.PS);
+        EXPECT_EQ(cpu.interrupts, reference.interrupts);
+        EXPECT_EQ(cpu.hash(), reference.hash());
+    }
+};
+
+TEST_F(_6502CycleTests, RunsEveryInstructionLikeExecute) {
+    using CPU = m6502::CPU;
+    LoadProgram(0x8000, {
+            CPU::INS_LDX_IM, 0x10, CPU::INS_LDY_IM, 0xF0, CPU::INS_LDA_IM, 0x55,
+            CPU::INS_STA_ZP, 0x20, CPU::INS_STA_ZPX, 0x21, CPU::INS_STA_ABSX, 0x00, 0x20,
+            CPU::INS_STA_ABSY, 0xF0, 0x20,                                  //crosses a page
+            CPU::INS_LDA_ABSX, 0x00, 0x20, CPU::INS_ORA_ABSY, 0xF0, 0x20,
+            CPU::INS_LDA_XIND, 0x30, CPU::INS_AND_INDY, 0x50,              //crosses a page
+            CPU::INS_STA_XIND, 0x40, CPU::INS_STA_INDY, 0x40,
+            CPU::INS_BIT_ABS, 0x05, 0x20, CPU::INS_BIT_ZP, 0x20,
+            CPU::INS_LDX_ABSY, 0x01, 0x20, CPU::INS_LDY_ABSX, 0x02, 0x20,
+            CPU::INS_LDX_ZPY, 0x30, CPU::INS_LDY_ZPX, 0x30,
+            CPU::INS_STX_ZPY, 0x60, CPU::INS_STY_ZPX, 0x61, CPU::INS_STX_ABS, 0x00, 0x21, CPU::INS_STY_ABS, 0x01, 0x21,
+            CPU::INS_LDA_ABS, 0x03, 0x20, CPU::INS_AND_IM, 0xF0, CPU::INS_EOR_ZP, 0x22, CPU::INS_ORA_ZPX, 0x23,
+            CPU::INS_EOR_ABSX, 0x04, 0x20, CPU::INS_EOR_XIND, 0x30, CPU::INS_ORA_INDY, 0x50,
+            CPU::INS_LDX_ZP, 0x24, CPU::INS_LDY_ABS, 0x05, 0x20,
+            CPU::INS_JSR, 0x00, 0x90,
+            CPU::INS_PHA_IMP, 0x00, CPU::INS_PHP_IMP, 0x00, CPU::INS_PLA_IMP, 0x00, CPU::INS_PLP_IMP, 0x00,
+            CPU::INS_TSX_IMP, 0x00, CPU::INS_TXS_IMP, 0x00,
+            CPU::INS_BRK, 0xEA,
+            CPU::INS_JMP_IND, 0xFF, 0x30});
+    //subroutine, BRK handler and the target of JMP ($30FF), which takes its high byte from $3000
+    LoadProgram(0x9000, {CPU::INS_LDA_IM, 0x01, CPU::INS_RTS});
+    LoadProgram(0x9100, {CPU::INS_RTI});
+    cpu.mem[0x30FF] = 0x00;
+    cpu.mem[0x3000] = 0xA0;
+    LoadProgram(0xA000, {CPU::INS_JMP_ABS, 0x00, 0xB0});
+    cpu.mem[0xB000] = CPU::INS_JAM;
+    cpu.mem[CPU::IRQ_VECTOR] = 0x00;
+    cpu.mem[CPU::IRQ_VECTOR + 1] = 0x91;
+    //pointers and data
+    cpu.mem[0x40] = 0x80; cpu.mem[0x41] = 0x20;
+    cpu.mem[0x50] = 0xF0; cpu.mem[0x51] = 0x20;
+    for (m6502::word address{0x2000}; address < 0x2200; ++address)
+        cpu.mem[address] = static_cast<m6502::byte>(address * 37 + 11);
+
+    ExpectSameAsExecute();
+    EXPECT_EQ(cpu.PC, 0xB001);
+}
+
+TEST_F(_6502CycleTests, TakesPendingInterruptsLikeExecute) {
+    LoadProgram(0x8000, {m6502::CPU::INS_LDA_IM, 0x01, m6502::CPU::INS_JAM});
+    LoadProgram(0x9000, {m6502::CPU::INS_LDX_IM, 0x02, m6502::CPU::INS_RTI});
+    cpu.mem[m6502::CPU::NMI_VECTOR] = 0x00;
+    cpu.mem[m6502::CPU::NMI_VECTOR + 1] = 0x90;
+    cpu.nmi();
+
+    ExpectSameAsExecute();
+    EXPECT_EQ(cpu.X, 0x02);
+}
+
+TEST_F(_6502CycleTests, WritesLandInTheCycleOfTheirBusAccess) {
+    //STA $10; STA $2000,X; JAM
+    LoadProgram(0x8000, {m6502::CPU::INS_STA_ZP, 0x10, m6502::CPU::INS_STA_ABSX, 0x00, 0x20, m6502::CPU::INS_JAM});
+    cpu.A = 0x42;
+    cpu.X = 0x01;
+    m6502::CycleCPU stepped{cpu};
+    std::vector<uint64_t> seen;
+    stepped.run(UINT64_MAX, [&](uint64_t cycle) {
+        if (cpu.mem[0x10] == 0x42 && seen.empty()) seen.push_back(cycle);
+        if (cpu.mem[0x2001] == 0x42 && seen.size() == 1) seen.push_back(cycle);
+    });
+
+    //opcode, operand, write; then opcode, two operands, the index cycle and the write
+    EXPECT_EQ(seen, (std::vector<uint64_t>{3, 8}));
+    EXPECT_EQ(stepped.getCycles(), 9u);
+    EXPECT_EQ(stepped.getInstructions(), 2u);
+}
+
+TEST_F(_6502CycleTests, ReportsEveryBusAccess) {
+    //LDA $1234, JAM
+    LoadProgram(0x8000, {m6502::CPU::INS_LDA_ABS, 0x34, 0x12, m6502::CPU::INS_JAM});
+    cpu.mem[0x1234] = 0x99;
+    m6502::CycleCPU stepped{cpu};
+    std::vector<m6502::CycleCPU::Access> accesses;
+    stepped.run(UINT64_MAX, [&](uint64_t) { accesses.push_back(stepped.lastAccess()); });
+
+    ASSERT_EQ(accesses.size(), 5u);
+    const m6502::word addresses[] {0x8000, 0x8001, 0x8002, 0x1234, 0x8003};
+    const m6502::CycleCPU::Access::Kind kinds[] {m6502::CycleCPU::Access::FETCH, m6502::CycleCPU::Access::FETCH,
+                                                 m6502::CycleCPU::Access::FETCH, m6502::CycleCPU::Access::READ,
+                                                 m6502::CycleCPU::Access::FETCH};
+    for (size_t i{0}; i < accesses.size(); ++i) {
+        EXPECT_EQ(accesses[i].address, addresses[i]);
+        EXPECT_EQ(accesses[i].kind, kinds[i]);
+    }
+    EXPECT_EQ(accesses[3].data, 0x99);
+    EXPECT_EQ(cpu.A, 0x99);
+}
+
+TEST_F(_6502CycleTests, IRQRaisedMidInstructionIsTakenAtTheNextBoundary) {
+    //LDA $1234; JAM
+    LoadProgram(0x8000, {m6502::CPU::INS_LDA_ABS, 0x34, 0x12, m6502::CPU::INS_JAM});
+    cpu.mem[m6502::CPU::IRQ_VECTOR] = 0x00;
+    cpu.mem[m6502::CPU::IRQ_VECTOR + 1] = 0x90;
+    m6502::CycleCPU stepped{cpu};
+    stepped.run(2, [&](uint64_t cycle) {
+        if (cycle == 2) cpu.irq(true);
+    });
+
+    //the load finishes, then two dummy reads, three pushes and the vector
+    EXPECT_EQ(stepped.run(2), 2u);
+    EXPECT_EQ(cpu.PC, 0x8003);
+    EXPECT_EQ(stepped.run(7), 7u);
+    EXPECT_EQ(cpu.PC, 0x9000);
+    EXPECT_EQ(cpu.mem[0x01FF], 0x80);
+    EXPECT_EQ(cpu.mem[0x01FE], 0x03);
+    EXPECT_TRUE(cpu.PS.test(m6502::CPU::StatusFlags::I));
+}
+
+TEST_F(_6502CycleTests, StopsAfterFetchingAnUnhandledOpcode) {
+    cpu.mem[0x8000] = m6502::CPU::INS_JAM;
+    m6502::CycleCPU stepped{cpu};
+
+    EXPECT_TRUE(stepped.step());
+    EXPECT_FALSE(stepped.step());
+    EXPECT_TRUE(stepped.isStopped());
+    EXPECT_EQ(stepped.getCycles(), 1u);
+    EXPECT_EQ(stepped.getInstructions(), 0u);
+    EXPECT_EQ(stepped.run(100), 0u);
+}
+
+TEST_F(_6502CycleTests, StopsOnAnOpcodeFromADevicePage) {
+    struct Silent : m6502::Bus {
+        m6502::byte read(m6502::word) override { return 0xEA; }
+        void write(m6502::word, m6502::byte) override {}
+    } bus;
+    cpu.mem.map(bus, 0xD0, 1);
+    //LDA #$01; JMP $D000, where the page reads as 0, BRK, for fetches
+    LoadProgram(0x8000, {m6502::CPU::INS_LDA_IM, 0x01, m6502::CPU::INS_JMP_ABS, 0x00, 0xD0});
+    ExpectSameAsExecute();
+    EXPECT_EQ(cpu.PC, 0xD001);
+    EXPECT_EQ(cpu.SP, 0xFF);
+    EXPECT_EQ(cpu.A, 0x01);
+}
+
+TEST_F(_6502CycleTests, RegistersCanBeChangedBetweenInstructions) {
+    //LDA #$01 at 0x8000, LDA #$02 at 0x9000
+    LoadProgram(0x8000, {m6502::CPU::INS_LDA_IM, 0x01});
+    LoadProgram(0x9000, {m6502::CPU::INS_LDA_IM, 0x02});
+    m6502::CycleCPU stepped{cpu};
+    EXPECT_TRUE(stepped.atInstructionBoundary());
+    stepped.step();
+    EXPECT_FALSE(stepped.atInstructionBoundary());
+    stepped.step();
+    EXPECT_TRUE(stepped.atInstructionBoundary());
+    EXPECT_EQ(cpu.A, 0x01);
+
+    cpu.PC = 0x9000;
+    stepped.run(2);
+    EXPECT_EQ(cpu.A, 0x02);
+    EXPECT_EQ(cpu.PC, 0x9002);
+}
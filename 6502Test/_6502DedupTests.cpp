@@ -0,0 +1,71 @@
+#include "gtest/gtest.h"
+#include "6502Dedup.h"
+#include <vector>
+
+class _6502DedupTests : public testing::Test {
+public:
+    virtual void SetUp() {}
+    virtual void TearDown() {}
+};
+
+TEST_F(_6502DedupTests, EqualPagesAreMergedAndZeroPagesDropped) {
+    std::vector<m6502::Memory> memories(3);
+    m6502::Deduplicator deduplicator;
+    for (size_t i{0}; i < memories.size(); ++i) {
+        m6502::Memory& mem = memories[i];
+        for (m6502::word j{0}; j < 0x100; ++j)
+            mem.write(static_cast<m6502::word>(0x0500 + j), static_cast<m6502::byte>(j * 3));
+        mem.write(0x0600, 1);       //written, then back to zero
+        mem.write(0x0600, 0);
+        mem.write(0x0700, static_cast<m6502::byte>(i + 1)); //differs
+        deduplicator.add(mem);
+    }
+    const auto& stats = deduplicator.run();
+    EXPECT_EQ(stats.memories, 3u);
+    EXPECT_EQ(stats.pagesScanned, 9u);
+    EXPECT_EQ(stats.zeroPages, 3u);
+    EXPECT_EQ(stats.mergedPages, 2u);
+    EXPECT_EQ(stats.bytesReclaimed, 5u * m6502::Page::SIZE);
+
+    for (size_t i{0}; i < memories.size(); ++i) {
+        EXPECT_EQ(memories[i].ownPages(), 1u);
+        EXPECT_EQ(memories[i].usedPages().count(), 2u);
+        EXPECT_EQ(memories[i].read(0x0510), 0x30);
+        EXPECT_EQ(memories[i].read(0x0600), 0);
+        EXPECT_EQ(memories[i].read(0x0700), i + 1);
+    }
+    EXPECT_EQ(memories[0].pageData(0x05), memories[2].pageData(0x05));
+}
+
+TEST_F(_6502DedupTests, MergedPagesAreCopiedOnWrite) {
+    m6502::Memory first, second;
+    first.write(0x1234, 0x42);
+    second.write(0x1234, 0x42);
+    m6502::Deduplicator deduplicator;
+    deduplicator.add(first);
+    deduplicator.add(second);
+    deduplicator.run();
+    ASSERT_EQ(first.pageData(0x12), second.pageData(0x12));
+
+    first.write(0x1234, 0x43);
+    EXPECT_EQ(first.read(0x1234), 0x43);
+    EXPECT_EQ(second.read(0x1234), 0x42);
+    second.write(0x1235, 0x44);
+    EXPECT_EQ(first.read(0x1235), 0);
+    EXPECT_EQ(second.ownPages(), 1u);
+}
+
+TEST_F(_6502DedupTests, AlreadySharedPagesReclaimNothing) {
+    const m6502::byte bytes[] {1, 2, 3};
+    m6502::Rom rom{0x9000, bytes, sizeof bytes};
+    m6502::Memory first, second;
+    first.map(rom);
+    second.map(rom);
+    m6502::Deduplicator deduplicator;
+    deduplicator.add(first);
+    deduplicator.add(second);
+    const auto& stats = deduplicator.run();
+    EXPECT_EQ(stats.mergedPages, 0u);
+    EXPECT_EQ(stats.bytesReclaimed, 0u);
+    EXPECT_EQ(first.read(0x9001), 2);
+}
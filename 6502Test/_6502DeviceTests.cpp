@@ -0,0 +1,114 @@
+#include "gtest/gtest.h"
+#include "6502Devices.h"
+#include "6502Dedup.h"
+
+class _6502DeviceTests : public testing::Test {
+public:
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    m6502::EventQueue queue;
+    m6502::Devices devices{queue};
+
+    //counts down once a cycle, offset 0 reads and sets the count, offset 1 counts the advances
+    struct Countdown : m6502::Device {
+        m6502::byte counter{0xFF};
+        m6502::byte advances{0};
+        void advance(uint64_t from, uint64_t to) override {
+            counter = static_cast<m6502::byte>(counter - (to - from));
+            advances++;
+        }
+        m6502::byte read(m6502::word offset) override { return offset ? advances : counter; }
+        void write(m6502::word offset, m6502::byte data) override {
+            if (!offset) counter = data;
+        }
+    } countdown;
+
+    virtual void SetUp() {
+        cpu.reset();
+        devices.add(countdown, 0xD000, 2);
+        devices.attach(cpu.mem);
+        cpu.PC = 0x8000;
+    }
+    virtual void TearDown() {}
+
+    void LoadProgram(std::initializer_list<m6502::byte> program) {
+        m6502::word address{0x8000};
+        for (m6502::byte value : program)
+            cpu.mem[address++] = value;
+    }
+};
+
+TEST_F(_6502DeviceTests, ReadsSeeTheDeviceAtTheCycleOfTheAccess) {
+    //LDA $D000; STA $10; LDA $D000; STA $11; JAM
+    LoadProgram({m6502::CPU::INS_LDA_ABS, 0x00, 0xD0,
+                 m6502::CPU::INS_STA_ZP, 0x10,
+                 m6502::CPU::INS_LDA_ABS, 0x00, 0xD0,
+                 m6502::CPU::INS_STA_ZP, 0x11,
+                 m6502::CPU::INS_JAM});
+    //and a cycle for the JAM
+    EXPECT_EQ(queue.run(cpu, 1000), 15u);
+    //the operand is read after 3 cycles of the first and 10 cycles of the second load
+    EXPECT_EQ(cpu.mem.read(0x10), 0xFF - 3);
+    EXPECT_EQ(cpu.mem.read(0x11), 0xFF - 10);
+    EXPECT_EQ(countdown.advances, 2);
+    EXPECT_EQ(countdown.synchronizedTo(), 10u);
+    EXPECT_EQ(devices.getStats().accesses, 2u);
+    EXPECT_EQ(devices.getStats().advancedCycles, 10u);
+
+    devices.synchronize();
+    EXPECT_EQ(countdown.synchronizedTo(), queue.now());
+    EXPECT_EQ(countdown.counter, static_cast<m6502::byte>(0xFF - queue.now()));
+}
+
+TEST_F(_6502DeviceTests, UntouchedDevicesCostNothing) {
+    //STA $D000; then JMP to itself for a million cycles; LDA $D000
+    LoadProgram({m6502::CPU::INS_STA_ABS, 0x00, 0xD0,
+                 m6502::CPU::INS_JMP_ABS, 0x03, 0x80});
+    cpu.A = 0x80;
+    queue.run(cpu, 1000000);
+    EXPECT_EQ(countdown.advances, 1);
+    EXPECT_EQ(countdown.synchronizedTo(), 3u);
+
+    cpu.PC = 0x9000;
+    cpu.mem[0x9000] = m6502::CPU::INS_LDA_ABS;
+    cpu.mem[0x9001] = 0x00;
+    cpu.mem[0x9002] = 0xD0;
+    const uint64_t start = queue.now();
+    queue.run(cpu, 4);
+    EXPECT_EQ(countdown.advances, 2);
+    //set to 0x80 at cycle 3, read at cycle start + 3
+    EXPECT_EQ(cpu.A, static_cast<m6502::byte>(0x80 - start));
+}
+
+TEST_F(_6502DeviceTests, BytesNoDeviceAnswersForReadZero) {
+    cpu.mem.write(0xD010, 0x42);
+    EXPECT_EQ(cpu.mem.read(0xD010), 0);
+    EXPECT_EQ(cpu.mem.read(0xD001), 0);     //no advances yet
+    EXPECT_EQ(devices.getStats().accesses, 3u);
+    EXPECT_EQ(countdown.counter, 0xFF);
+}
+
+TEST_F(_6502DeviceTests, MappingSurvivesCopiesAndInitialize) {
+    EXPECT_TRUE(cpu.mem.isMapped(0xD0));
+    m6502::Memory copy{cpu.mem};
+    EXPECT_TRUE(copy.isMapped(0xD0));
+    copy.write(0xD000, 0x10);
+    EXPECT_EQ(countdown.counter, 0x10);
+
+    cpu.mem.initialize();
+    EXPECT_TRUE(cpu.mem.isMapped(0xD0));
+    EXPECT_EQ(cpu.mem.ownPages(), 0u);
+
+    m6502::Deduplicator dedup;
+    dedup.add(cpu.mem);
+    dedup.add(copy);
+    dedup.run();
+    EXPECT_TRUE(cpu.mem.isMapped(0xD0));
+    EXPECT_TRUE(copy.isMapped(0xD0));
+
+    //setting the page up as memory takes it off the bus
+    cpu.mem[0xD000] = 0x33;
+    EXPECT_FALSE(cpu.mem.isMapped(0xD0));
+    EXPECT_EQ(cpu.mem.read(0xD000), 0x33);
+    EXPECT_EQ(countdown.counter, 0x10);
+}
@@ -0,0 +1,128 @@
+#include "gtest/gtest.h"
+#include "6502Events.h"
+#include <memory>
+
+class _6502EventTests : public testing::Test {
+public:
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+
+    //fires every period cycles and remembers when
+    struct Timer : m6502::EventQueue::Handler {
+        uint64_t period;
+        std::vector<uint64_t> due, fired;
+        explicit Timer(uint64_t period) : period(period) {}
+        void onEvent(m6502::EventQueue& queue, uint64_t cycle) override {
+            due.push_back(cycle);
+            fired.push_back(queue.now());
+            queue.schedule(*this, cycle + period);
+        }
+    };
+
+    virtual void SetUp() {
+        cpu.reset();
+        //loop: LDA $1234; STA ($20),Y; JMP loop, 4 + 6 + 3 cycles
+        const m6502::byte program[] {
+                m6502::CPU::INS_LDA_ABS, 0x34, 0x12,
+                m6502::CPU::INS_STA_INDY, 0x20,
+                m6502::CPU::INS_JMP_ABS, 0x00, 0x80};
+        for (size_t i{0}; i < sizeof program; ++i)
+            cpu.mem[0x8000 + i] = program[i];
+        cpu.mem[0x21] = 0x40;
+        cpu.PC = 0x8000;
+    }
+    virtual void TearDown() {}
+};
+
+TEST_F(_6502EventTests, EventsFireAtTheEndOfTheInstructionThatReachesThem) {
+    m6502::EventQueue queue;
+    Timer timer{1000};
+    queue.schedule(timer, 1000);
+    const uint64_t ran = queue.run(cpu, 100000);
+    EXPECT_GE(ran, 100000u);
+    EXPECT_EQ(queue.now(), ran);
+
+    ASSERT_EQ(timer.due.size(), 100u);
+    for (size_t i{0}; i < timer.due.size(); ++i) {
+        EXPECT_EQ(timer.due[i], 1000 * (i + 1));
+        EXPECT_GE(timer.fired[i], timer.due[i]);
+        EXPECT_LT(timer.fired[i], timer.due[i] + 6);
+    }
+    //one slice up to every event and one to the end
+    EXPECT_EQ(queue.getStats().events, 100u);
+    EXPECT_EQ(queue.getStats().slices, 100u);
+    EXPECT_LT(queue.getStats().maxLateCycles, 6u);
+}
+
+TEST_F(_6502EventTests, RescheduleAndCancelReplaceThePendingEvent) {
+    m6502::EventQueue queue;
+    Timer first{1000000}, second{1000000};
+    queue.schedule(first, 500);
+    queue.schedule(first, 300);
+    queue.schedule(second, 200);
+    queue.schedule(second, 700);
+    EXPECT_TRUE(queue.isScheduled(second));
+    queue.cancel(second);
+    EXPECT_FALSE(queue.isScheduled(second));
+    queue.run(cpu, 1000);
+
+    ASSERT_EQ(first.due.size(), 1u);
+    EXPECT_EQ(first.due[0], 300u);
+    EXPECT_TRUE(second.due.empty());
+    EXPECT_EQ(queue.getStats().events, 1u);
+}
+
+TEST_F(_6502EventTests, HandlersMayGoAwayOnceCancelledOrFired) {
+    m6502::EventQueue queue;
+    Timer stays{1000000};
+    queue.schedule(stays, 900);
+    //rescheduled, then cancelled: two events left behind in the queue
+    std::unique_ptr<Timer> cancelled{new Timer{1000000}};
+    queue.schedule(*cancelled, 200);
+    queue.schedule(*cancelled, 400);
+    queue.cancel(*cancelled);
+    cancelled.reset();
+    //fires at 100 and is gone before its earlier event at 600 comes up
+    struct Once : m6502::EventQueue::Handler {
+        bool fired{false};
+        void onEvent(m6502::EventQueue&, uint64_t) override { fired = true; }
+    };
+    std::unique_ptr<Once> once{new Once};
+    queue.schedule(*once, 600);
+    queue.schedule(*once, 100);
+    queue.run(cpu, 300);
+    EXPECT_TRUE(once->fired);
+    once.reset();
+    queue.run(cpu, 1000);
+
+    ASSERT_EQ(stays.due.size(), 1u);
+    EXPECT_EQ(stays.due[0], 900u);
+    EXPECT_EQ(queue.getStats().events, 2u);
+}
+
+TEST_F(_6502EventTests, EventsAtOneCycleFireInTheOrderTheyWereScheduled) {
+    struct Recorder : m6502::EventQueue::Handler {
+        std::vector<int>& order;
+        int id;
+        Recorder(std::vector<int>& order, int id) : order(order), id(id) {}
+        void onEvent(m6502::EventQueue&, uint64_t) override { order.push_back(id); }
+    };
+    std::vector<int> order;
+    Recorder a{order, 1}, b{order, 2}, c{order, 3};
+    m6502::EventQueue queue;
+    queue.schedule(b, 100);
+    queue.schedule(c, 50);
+    queue.schedule(a, 100);
+    queue.run(cpu, 200);
+    EXPECT_EQ(order, (std::vector<int>{3, 2, 1}));
+}
+
+TEST_F(_6502EventTests, RunStopsOnAnUnhandledOpcode) {
+    cpu.mem[0x8005] = 0x02;
+    m6502::EventQueue queue;
+    Timer timer{5};
+    queue.schedule(timer, 5);
+    EXPECT_EQ(queue.run(cpu, 1000), 11u);
+    EXPECT_TRUE(queue.isStopped());
+    EXPECT_EQ(timer.due, (std::vector<uint64_t>{5, 10}));
+}
@@ -0,0 +1,98 @@
+#include "gtest/gtest.h"
+#include "6502Batch.h"
+
+class _6502ForkTests : public testing::Test {
+public:
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+
+    virtual void SetUp() {
+        cpu.reset();
+    }
+    virtual void TearDown() {}
+
+    //LDA $10; EOR $11; STA $0300; JAM, with 64 pages of data around it
+    void LoadProgram() {
+        const m6502::byte program[] {
+                m6502::CPU::INS_LDA_ZP, 0x10,
+                m6502::CPU::INS_EOR_ZP, 0x11,
+                m6502::CPU::INS_STA_ABS, 0x00, 0x03,
+                m6502::CPU::INS_JAM};
+        for (m6502::dword page{0x40}; page < 0x80; ++page)
+            cpu.mem[page * 0x100] = static_cast<m6502::byte>(page);
+        for (size_t i{0}; i < sizeof program; ++i)
+            cpu.mem[0x8000 + i] = program[i];
+        cpu.mem[0x11] = 0x0F;
+        cpu.PC = 0x8000;
+    }
+};
+
+TEST_F(_6502ForkTests, ChildrenDivergeFromTheParent) {
+    LoadProgram();
+    const m6502::Memory before{cpu.mem};
+    std::vector<m6502::CPU> children = cpu.fork(3);
+    ASSERT_EQ(children.size(), 3u);
+
+    for (size_t i{0}; i < children.size(); ++i) {
+        EXPECT_EQ(children[i].PC, 0x8000);
+        EXPECT_TRUE(children[i].mem == before);
+        children[i].mem.write(0x10, static_cast<m6502::byte>(0x10 * i));
+        children[i].execute(3);
+    }
+    for (size_t i{0}; i < children.size(); ++i) {
+        EXPECT_EQ(children[i].A, static_cast<m6502::byte>(0x10 * i ^ 0x0F));
+        EXPECT_EQ(children[i].mem.read(0x0300), static_cast<m6502::byte>(0x10 * i ^ 0x0F));
+        EXPECT_EQ(children[i].PC, 0x8007);
+    }
+    EXPECT_EQ(cpu.PC, 0x8000);
+    EXPECT_EQ(cpu.A, 0);
+    EXPECT_TRUE(cpu.mem == before);
+
+    //and the parent goes on by itself
+    cpu.execute(3);
+    EXPECT_EQ(cpu.mem.read(0x0300), 0x0F);
+    EXPECT_EQ(children[1].mem.read(0x0300), 0x1F);
+}
+
+TEST_F(_6502ForkTests, ChildrenOnlyOwnThePagesTheyWrite) {
+    LoadProgram();
+    std::vector<m6502::CPU> children = cpu.fork(100);
+    for (const m6502::CPU& child : children) {
+        EXPECT_EQ(child.mem.ownPages(), 0u);
+        EXPECT_EQ(child.mem.sharedPages().count(), cpu.mem.usedPages().count());
+    }
+    children[0].mem.write(0x10, 0x01);
+    children[0].execute(3);
+    //page 0 for the input, page 3 for the result
+    EXPECT_EQ(children[0].mem.ownPages(), 2u);
+    EXPECT_EQ(children[1].mem.ownPages(), 0u);
+    EXPECT_EQ(cpu.mem.read(0x10), 0);
+}
+
+TEST_F(_6502ForkTests, BatchJobsStartFromASharedForkPoint) {
+    LoadProgram();
+    auto from = std::make_shared<const m6502::CPU::Snapshot>(cpu.snapshot());
+    std::vector<m6502::BatchJob> jobs(500);
+    for (size_t i{0}; i < jobs.size(); ++i) {
+        jobs[i].image.push_back({0x0010, {static_cast<m6502::byte>(i)}});
+        jobs[i].instructions = 100;     //stops on the JAM after the program
+        jobs[i].resultAddress = 0x0300;
+        jobs[i].resultLength = 1;
+        jobs[i].from = from;
+    }
+    m6502::BatchRunner runner{4};
+    auto results = runner.run(jobs);
+
+    ASSERT_EQ(results.size(), jobs.size());
+    for (size_t i{0}; i < jobs.size(); ++i) {
+        EXPECT_EQ(results[i].memory[0], static_cast<m6502::byte>(i ^ 0x0F));
+        EXPECT_EQ(results[i].A, static_cast<m6502::byte>(i ^ 0x0F));
+        EXPECT_EQ(results[i].instructions, 3u);
+    }
+    //the fork point is still what it was
+    m6502::CPU check{clock};
+    check.restore(*from);
+    EXPECT_EQ(check.mem.read(0x0300), 0);
+    EXPECT_EQ(check.mem.read(0x10), 0);
+    EXPECT_EQ(check.PC, 0x8000);
+}
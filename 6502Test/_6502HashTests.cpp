@@ -0,0 +1,160 @@
+#include "gtest/gtest.h"
+#include "6502Diff.h"
+#include <random>
+#include <sstream>
+
+class _6502HashTests : public testing::Test {
+public:
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+
+    virtual void SetUp() {
+        cpu.reset();
+        for (m6502::dword page{0x10}; page < 0x20; ++page)
+            cpu.mem[page * 0x100 + 0x33] = static_cast<m6502::byte>(page);
+    }
+    virtual void TearDown() {}
+};
+
+TEST_F(_6502HashTests, EqualContentsHashEqual) {
+    m6502::CPU other{clock};
+    EXPECT_EQ(other.mem.hash(), m6502::Memory{}.hash());
+    EXPECT_NE(cpu.mem.hash(), other.mem.hash());
+    for (m6502::dword page{0x10}; page < 0x20; ++page)
+        other.mem.write(static_cast<m6502::word>(page * 0x100 + 0x33), static_cast<m6502::byte>(page));
+    EXPECT_EQ(cpu.mem.hash(), other.mem.hash());
+    EXPECT_EQ(cpu.hash(), other.hash());
+
+    //a page written back to zero is still used but hashes like the zero page
+    other.mem.write(0x1033, 0);
+    cpu.mem.write(0x1033, 0);
+    m6502::Memory fresh;
+    for (m6502::dword page{0x11}; page < 0x20; ++page)
+        fresh.write(static_cast<m6502::word>(page * 0x100 + 0x33), static_cast<m6502::byte>(page));
+    EXPECT_EQ(cpu.mem.hash(), fresh.hash());
+    EXPECT_EQ(other.mem.hash(), fresh.hash());
+}
+
+TEST_F(_6502HashTests, EveryByteAndRegisterCounts) {
+    const uint64_t before = cpu.hash();
+    for (m6502::word address : {0x0000, 0x1033, 0x1034, 0xFFFF}) {
+        const m6502::byte old = cpu.mem.read(address);
+        cpu.mem.write(address, old ^ 0x01);
+        EXPECT_NE(cpu.hash(), before) << address;
+        cpu.mem.write(address, old);
+        EXPECT_EQ(cpu.hash(), before) << address;
+    }
+    cpu.X = 1;
+    EXPECT_NE(cpu.hash(), before);
+    cpu.X = 0;
+    cpu.PS.set(m6502::CPU::StatusFlags::C);
+    EXPECT_NE(cpu.hash(), before);
+    cpu.PS.reset();
+    EXPECT_EQ(cpu.hash(), before);
+}
+
+TEST_F(_6502HashTests, KeptHashesFollowWrites) {
+    m6502::CPU copy = cpu.fork(1)[0];
+    cpu.mem.clearDirty();
+    const uint64_t shared = cpu.mem.hash();
+    EXPECT_EQ(copy.mem.hash(), shared);
+
+    //writing a shared page copies it, the copy's hash is worked out anew
+    copy.mem.write(0x1234, 0x56);
+    EXPECT_NE(copy.mem.hash(), shared);
+    EXPECT_EQ(cpu.mem.hash(), shared);
+
+    //once nothing else refers to the page the next write goes into it in place
+    const uint64_t written = copy.mem.hash();
+    copy.mem.clearDirty();
+    EXPECT_EQ(copy.mem.hash(), written);
+    copy.mem.write(0x1235, 0x78);
+    EXPECT_NE(copy.mem.hash(), written);
+    copy.mem.write(0x1235, 0x00);
+    EXPECT_EQ(copy.mem.hash(), written);
+
+    //reverting copies the old contents back into the page
+    m6502::Memory checkpoint = copy.mem.checkpoint();
+    EXPECT_EQ(copy.mem.hash(), written);
+    copy.mem.write(0x1236, 0x9A);
+    copy.mem.revert(checkpoint);
+    EXPECT_EQ(copy.mem.hash(), written);
+    EXPECT_EQ(copy.mem.hash(), checkpoint.hash());
+}
+
+TEST_F(_6502HashTests, KeptRootMatchesOneWorkedOutAfresh) {
+    struct Silent : m6502::Bus {
+        m6502::byte read(m6502::word) override { return 0xEE; }
+        void write(m6502::word, m6502::byte) override {}
+    } bus;
+    const m6502::byte bytes[] {1, 2, 3};
+    m6502::Rom rom{0xE000, bytes, sizeof bytes};
+    m6502::SharedRam ram{0x4000, 0x200};
+    m6502::Memory other;
+    other.map(ram);
+    cpu.mem.map(ram);
+    std::vector<m6502::Memory> checkpoints;
+    checkpoints.push_back(cpu.mem.checkpoint());
+    std::mt19937 random{7};
+    for (int step{0}; step < 3000; ++step) {
+        const auto value = static_cast<m6502::byte>(random());
+        switch (random() % 8) {
+            case 0:
+            case 1:
+                cpu.mem.write(static_cast<m6502::word>(random()), value);
+                break;
+            case 2:
+                //into a page written a moment ago, in place
+                cpu.mem.write(static_cast<m6502::word>(0x1000 + random() % 0x200), value);
+                break;
+            case 3:
+                //the shared ram, behind the memory's back
+                other.write(static_cast<m6502::word>(0x4000 + random() % 0x200), value);
+                break;
+            case 4:
+                cpu.mem.clearDirty();
+                break;
+            case 5:
+                if (random() % 4) cpu.mem.revert(checkpoints.back());
+                else checkpoints.push_back(cpu.mem.checkpoint());
+                break;
+            case 6:
+                if (random() % 2) cpu.mem.map(rom);
+                else if (random() % 2) cpu.mem.map(bus, 0xD0, 1);
+                else cpu.mem.unmap(0xD0, 1);
+                break;
+            default:
+                if (random() % 16 == 0) cpu.mem.initialize();
+        }
+        if (step % 3 == 0) {
+            ASSERT_EQ(cpu.mem.hash(), m6502::Memory{cpu.mem}.hash()) << step;
+            for (m6502::dword group{0}; group < m6502::Memory::HASH_GROUPS; ++group)
+                ASSERT_EQ(cpu.mem.groupHash(group), m6502::Memory{cpu.mem}.groupHash(group)) << step;
+        }
+    }
+}
+
+TEST_F(_6502HashTests, DiffFindsTheFirstDifferingByte) {
+    m6502::CPU other = cpu.fork(1)[0];
+    m6502::StateDiff same = m6502::diff(cpu, other);
+    EXPECT_TRUE(same.same());
+    EXPECT_EQ(same.pagesCompared, 0u);
+
+    other.mem.write(0x8011, 0x22);
+    other.mem.write(0x1840, 0x11);
+    other.mem.write(0x1850, 0x11);
+    other.A = 0x42;
+    const m6502::StateDiff diff = m6502::diff(cpu, other);
+    EXPECT_FALSE(diff.same());
+    EXPECT_TRUE(diff.registersDiffer());
+    EXPECT_EQ(diff.page, 0x18);
+    EXPECT_EQ(diff.address, 0x1840);
+    EXPECT_EQ(diff.byteA, 0x00);
+    EXPECT_EQ(diff.byteB, 0x11);
+    EXPECT_EQ(diff.pages, 2u);
+    EXPECT_EQ(diff.pagesCompared, 2u);
+
+    std::stringstream out;
+    out << diff;
+    EXPECT_EQ(out.str(), "A 00 vs 42\nmemory from $1840: 00 vs 11\n2 pages differ\n");
+}
@@ -0,0 +1,139 @@
+#include "gtest/gtest.h"
+#include "6502Image.h"
+#include "6502Mapper.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class _6502ImageTests : public testing::Test {
+public:
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    virtual void SetUp() {}
+    virtual void TearDown() {
+        for (const std::string& path : files) std::remove(path.c_str());
+    }
+
+    std::string WriteFile(const std::string& name, const std::vector<m6502::byte>& bytes) {
+        const std::string path = testing::TempDir() + "_6502ImageTests_" + name;
+        std::ofstream file{path, std::ios::binary};
+        file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        files.push_back(path);
+        return path;
+    }
+
+    static bool ParseHex(m6502::Image& image, const std::string& text) {
+        return image.parse(m6502::Image::INTEL_HEX, reinterpret_cast<const m6502::byte*>(text.data()), text.size());
+    }
+
+private:
+    std::vector<std::string> files;
+};
+
+TEST_F(_6502ImageTests, RawBytesGoToTheAddressGivenWithoutBeingCopied) {
+    const m6502::byte bytes[] {0xA9, 0x42, 0x02};
+    m6502::Image image;
+    ASSERT_TRUE(image.parse(m6502::Image::RAW, bytes, sizeof bytes, 0x80FF));
+    ASSERT_EQ(image.getSegments().size(), 1u);
+    EXPECT_EQ(image.getSegments()[0].bytes, bytes);
+
+    //across a page boundary
+    EXPECT_EQ(image.loadInto(cpu.mem), 3u);
+    EXPECT_EQ(cpu.mem[0x80FF], 0xA9);
+    EXPECT_EQ(cpu.mem[0x8100], 0x42);
+    EXPECT_EQ(cpu.mem[0x8101], 0x02);
+    EXPECT_EQ(cpu.mem[0x8102], 0x00);
+}
+
+TEST_F(_6502ImageTests, PrgStartsWithItsLoadAddress) {
+    const m6502::byte bytes[] {0x01, 0x08, 0x0B, 0x08, 0x0A};
+    m6502::Image image;
+    ASSERT_TRUE(image.parse(m6502::Image::PRG, bytes, sizeof bytes));
+    ASSERT_EQ(image.getSegments().size(), 1u);
+    EXPECT_EQ(image.getSegments()[0].address, 0x0801u);
+    EXPECT_EQ(image.size(), 3u);
+    image.loadInto(cpu.mem);
+    EXPECT_EQ(cpu.mem[0x0801], 0x0B);
+    EXPECT_EQ(cpu.mem[0x0803], 0x0A);
+
+    EXPECT_FALSE(image.parse(m6502::Image::PRG, bytes, 1));
+    EXPECT_TRUE(image.isEmpty());
+}
+
+TEST_F(_6502ImageTests, IntelHexRecordsGoToTheirAddresses) {
+    m6502::Image image;
+    //two records in a row, one elsewhere, one past 64 KB through an extended linear address, the end
+    ASSERT_TRUE(ParseHex(image, ":03C00000A9420250\r\n"
+                                ":02C003008510A6\n"
+                                ":01FFFC000004\n"
+                                ":020000040001F9\n"
+                                ":0100000055AA\n"
+                                ":00000001FF\n"));
+    const std::vector<m6502::Image::Segment>& segments = image.getSegments();
+    ASSERT_EQ(segments.size(), 3u);
+    EXPECT_EQ(segments[0].address, 0xC000u);
+    EXPECT_EQ(segments[0].length, 5u);
+    EXPECT_EQ(segments[1].address, 0xFFFCu);
+    EXPECT_EQ(segments[2].address, 0x10000u);
+
+    EXPECT_EQ(image.loadInto(cpu.mem), 6u);
+    EXPECT_EQ(cpu.mem[0xC000], 0xA9);
+    EXPECT_EQ(cpu.mem[0xC004], 0x10);
+    EXPECT_EQ(cpu.mem[0x0000], 0x00);
+}
+
+TEST_F(_6502ImageTests, MalformedIntelHexIsRejected) {
+    m6502::Image image;
+    //checksum off by one
+    EXPECT_FALSE(ParseHex(image, ":03C00000A9420251\n:00000001FF\n"));
+    EXPECT_TRUE(image.isEmpty());
+    //no end of file record
+    EXPECT_FALSE(ParseHex(image, ":03C00000A9420250\n"));
+    //short record
+    EXPECT_FALSE(ParseHex(image, ":03C00000A942\n:00000001FF\n"));
+    EXPECT_FALSE(ParseHex(image, "03C00000A9420250\n"));
+    EXPECT_TRUE(ParseHex(image, ":00000001FF"));
+}
+
+TEST_F(_6502ImageTests, FilesAreMappedNotRead) {
+    const std::string path = WriteFile("program.prg", {0x00, 0xC0, 0xA9, 0x07, 0x85, 0x10, 0x02});
+    m6502::Image image;
+    ASSERT_TRUE(image.open(path, m6502::Image::PRG));
+    image.loadInto(cpu.mem);
+    cpu.PC = 0xC000;
+    cpu.execute(UINT64_MAX);
+    EXPECT_EQ(cpu.mem[0x10], 0x07);
+
+    m6502::MappedFile file{path};
+    ASSERT_TRUE(file.isOpen());
+    EXPECT_EQ(file.size(), 7u);
+    EXPECT_EQ(file.data()[2], 0xA9);
+
+    EXPECT_FALSE(image.open(path + ".missing", m6502::Image::RAW));
+    EXPECT_FALSE(m6502::MappedFile{path + ".missing"}.isOpen());
+    EXPECT_TRUE(image.isEmpty());
+}
+
+TEST_F(_6502ImageTests, MappedRomBanksAreOnlyCopiedWhenSelected) {
+    //8 banks of 8 KB, each filled with its number
+    std::vector<m6502::byte> bytes;
+    for (m6502::dword i{0}; i < 8 * 0x2000; ++i)
+        bytes.push_back(static_cast<m6502::byte>(i / 0x2000));
+    const m6502::MappedFile file{WriteFile("banked.rom", bytes)};
+    ASSERT_TRUE(file.isOpen());
+    m6502::Mapper mapper{0x2000};
+    m6502::CPU banked{clock};
+    EXPECT_EQ(mapper.mapRom(file.data(), file.size()), 0u);
+    EXPECT_EQ(mapper.getBanks(), 8u);
+    EXPECT_EQ(mapper.getStats().pagesLoaded, 0u);
+
+    const size_t window = mapper.addWindow(banked.mem, 0x8000, 5);
+    EXPECT_EQ(banked.mem[0x8000], 5);
+    EXPECT_EQ(banked.mem[0x9FFF], 5);
+    EXPECT_EQ(mapper.getStats().pagesLoaded, 0x20u);
+    mapper.select(window, 6);
+    mapper.select(window, 5);
+    EXPECT_EQ(banked.mem[0x8000], 5);
+    EXPECT_EQ(mapper.getStats().pagesLoaded, 0x40u);
+}
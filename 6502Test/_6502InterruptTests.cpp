@@ -0,0 +1,193 @@
+#include "gtest/gtest.h"
+#include "6502Devices.h"
+
+class _6502InterruptTests : public testing::Test {
+public:
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    virtual void SetUp() {
+        cpu.reset();
+        cpu.PC = 0x8000;
+        cpu.mem[0xFFFA] = 0x00;     //NMI handler at 0x9100
+        cpu.mem[0xFFFB] = 0x91;
+        cpu.mem[0xFFFE] = 0x00;     //IRQ and BRK handler at 0x9000
+        cpu.mem[0xFFFF] = 0x90;
+        cpu.mem[0x9000] = m6502::CPU::INS_RTI;
+        cpu.mem[0x9100] = m6502::CPU::INS_RTI;
+    }
+    virtual void TearDown() {}
+
+    void LoadProgram(std::initializer_list<m6502::byte> program) {
+        m6502::word address{0x8000};
+        for (m6502::byte value : program)
+            cpu.mem[address++] = value;
+    }
+};
+
+TEST_F(_6502InterruptTests, IRQPushesPCAndStatusAndJumpsThroughItsVector) {
+    cpu.mem[0x9000] = m6502::CPU::INS_LDA_IM;
+    cpu.mem[0x9001] = 0x42;
+    cpu.PS.set(m6502::CPU::StatusFlags::C);
+    cpu.irq(true);
+
+    //7 cycles to enter the handler and 2 for its first instruction
+    EXPECT_EQ(cpu.execute(), 9u);
+    EXPECT_EQ(cpu.A, 0x42);
+    EXPECT_EQ(cpu.PC, 0x9002);
+    EXPECT_EQ(cpu.SP, 0xFF - 3);
+    EXPECT_EQ(cpu.mem[0x01FF], 0x80);
+    EXPECT_EQ(cpu.mem[0x01FE], 0x00);
+    //B clear for an interrupt, U always set
+    EXPECT_EQ(cpu.mem[0x01FD], 0x21);
+    EXPECT_TRUE(cpu.PS.test(m6502::CPU::StatusFlags::I));
+    EXPECT_EQ(cpu.instructionsExecuted, 1u);
+}
+
+TEST_F(_6502InterruptTests, IRQWaitsWhileInterruptsAreDisabled) {
+    LoadProgram({m6502::CPU::INS_LDA_IM, 0x01});
+    cpu.PS.set(m6502::CPU::StatusFlags::I);
+    cpu.irq(true);
+
+    EXPECT_EQ(cpu.execute(), 2u);
+    EXPECT_EQ(cpu.PC, 0x8002);
+    EXPECT_EQ(cpu.SP, 0xFF);
+
+    //a level, so it is taken as soon as I is clear
+    cpu.PS.reset(m6502::CPU::StatusFlags::I);
+    cpu.execute();
+    EXPECT_EQ(cpu.SP, 0xFF);
+    EXPECT_EQ(cpu.PC, 0x8002);
+    //and taken again after RTI as long as it stays asserted
+    EXPECT_EQ(cpu.interrupts, m6502::CPU::IRQ);
+}
+
+TEST_F(_6502InterruptTests, ReleasedIRQIsNotTaken) {
+    LoadProgram({m6502::CPU::INS_LDA_IM, 0x01});
+    cpu.irq(true);
+    cpu.irq(false);
+
+    EXPECT_EQ(cpu.execute(), 2u);
+    EXPECT_EQ(cpu.PC, 0x8002);
+}
+
+TEST_F(_6502InterruptTests, ResetDropsPendingInterrupts) {
+    LoadProgram({m6502::CPU::INS_LDA_IM, 0x01});
+    cpu.irq(true);
+    cpu.nmi();
+    cpu.reset();
+    cpu.PC = 0x8000;
+
+    EXPECT_EQ(cpu.interrupts, 0);
+    EXPECT_EQ(cpu.execute(), 2u);
+    EXPECT_EQ(cpu.PC, 0x8002);
+}
+
+TEST_F(_6502InterruptTests, NMIIsTakenOnceEvenWithInterruptsDisabled) {
+    LoadProgram({m6502::CPU::INS_LDA_IM, 0x01});
+    cpu.PS.set(m6502::CPU::StatusFlags::I);
+    cpu.nmi();
+
+    //enter, RTI, LDA
+    EXPECT_EQ(cpu.execute(2), 7u + 6u + 2u);
+    EXPECT_EQ(cpu.PC, 0x8002);
+    EXPECT_EQ(cpu.SP, 0xFF);
+    EXPECT_EQ(cpu.interrupts, 0);
+    EXPECT_TRUE(cpu.PS.test(m6502::CPU::StatusFlags::I));
+}
+
+TEST_F(_6502InterruptTests, NMIGoesBeforeIRQ) {
+    cpu.irq(true);
+    cpu.nmi();
+
+    cpu.execute();
+    //the NMI handler's RTI ran with I set from entering it, the IRQ went in right after
+    EXPECT_EQ(cpu.interrupts, m6502::CPU::IRQ);
+    EXPECT_EQ(cpu.PC, 0x8000);
+    cpu.execute();
+    EXPECT_EQ(cpu.PC, 0x8000);
+    EXPECT_EQ(cpu.SP, 0xFF);
+}
+
+TEST_F(_6502InterruptTests, BRKPushesTheAddressAfterItsPaddingByteWithBSet) {
+    LoadProgram({m6502::CPU::INS_BRK, 0xEA});
+
+    EXPECT_EQ(cpu.execute(), 7u);
+    EXPECT_EQ(cpu.PC, 0x9000);
+    EXPECT_EQ(cpu.mem[0x01FF], 0x80);
+    EXPECT_EQ(cpu.mem[0x01FE], 0x02);
+    EXPECT_EQ(cpu.mem[0x01FD], 0x30);
+    EXPECT_TRUE(cpu.PS.test(m6502::CPU::StatusFlags::I));
+}
+
+TEST_F(_6502InterruptTests, RTIRestoresStatusAndPC) {
+    LoadProgram({m6502::CPU::INS_BRK, 0xEA});
+    cpu.PS.set(m6502::CPU::StatusFlags::N);
+    cpu.PS.set(m6502::CPU::StatusFlags::C);
+    cpu.execute();
+
+    EXPECT_EQ(cpu.execute(), 6u);
+    EXPECT_EQ(cpu.PC, 0x8002);
+    EXPECT_EQ(cpu.SP, 0xFF);
+    EXPECT_TRUE(cpu.PS.test(m6502::CPU::StatusFlags::N));
+    EXPECT_TRUE(cpu.PS.test(m6502::CPU::StatusFlags::C));
+    EXPECT_FALSE(cpu.PS.test(m6502::CPU::StatusFlags::I));
+}
+
+TEST_F(_6502InterruptTests, CycleBudgetIsCheckedBeforeTakingAnInterrupt) {
+    cpu.nmi();
+
+    EXPECT_EQ(cpu.execute(UINT64_MAX, 0), 0u);
+    EXPECT_EQ(cpu.interrupts, m6502::CPU::NMI);
+    EXPECT_EQ(cpu.PC, 0x8000);
+}
+
+TEST_F(_6502InterruptTests, SnapshotsKeepPendingInterrupts) {
+    cpu.nmi();
+    const m6502::CPU::Snapshot pending = cpu.snapshot();
+    cpu.execute();
+    EXPECT_EQ(cpu.interrupts, 0);
+
+    cpu.restore(pending);
+    EXPECT_EQ(cpu.interrupts, m6502::CPU::NMI);
+    EXPECT_EQ(cpu.PC, 0x8000);
+}
+
+TEST_F(_6502InterruptTests, DeviceRaisesIRQFromAnEventAndReleasesItOnRead) {
+    //a timer that asserts IRQ every 100 cycles until its status is read
+    struct Timer : m6502::Device, m6502::EventQueue::Handler {
+        m6502::CPU& cpu;
+        m6502::byte expiries{0};
+        explicit Timer(m6502::CPU& cpu) : cpu(cpu) {}
+        void advance(uint64_t, uint64_t) override {}
+        m6502::byte read(m6502::word) override {
+            cpu.irq(false);
+            return expiries;
+        }
+        void write(m6502::word, m6502::byte) override {}
+        void onEvent(m6502::EventQueue& queue, uint64_t cycle) override {
+            expiries++;
+            cpu.irq(true);
+            queue.schedule(*this, cycle + 100);
+        }
+    } timer{cpu};
+    m6502::EventQueue queue;
+    m6502::Devices devices{queue};
+    devices.add(timer, 0xD000, 1);
+    devices.attach(cpu.mem);
+    queue.schedule(timer, 100);
+
+    //loop: JMP loop; handler: LDA $D000; STA $10; RTI
+    LoadProgram({m6502::CPU::INS_JMP_ABS, 0x00, 0x80});
+    cpu.mem[0x9000] = m6502::CPU::INS_LDA_ABS;
+    cpu.mem[0x9001] = 0x00;
+    cpu.mem[0x9002] = 0xD0;
+    cpu.mem[0x9003] = m6502::CPU::INS_STA_ZP;
+    cpu.mem[0x9004] = 0x10;
+    cpu.mem[0x9005] = m6502::CPU::INS_RTI;
+
+    queue.run(cpu, 1000);
+    EXPECT_EQ(timer.expiries, 10);
+    //every expiry was handled once, the last one may still be in its handler
+    EXPECT_GE(cpu.mem[0x10], 9);
+    EXPECT_LE(cpu.mem[0x10], 10);
+}
@@ -3,7 +3,8 @@
 
 class _6502LoadRegisterTests : public testing::Test {
 public:
-    m6502::CPU cpu{.01};
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
     virtual void SetUp() {
         cpu.reset();
         cpu.PC = 0xFFFC;
@@ -30,7 +31,7 @@ static void VerifyUnmodifiedCPUFlagsFromLoadRegister(const std::bitset<m6502::CP
 }
 
 TEST_F(_6502LoadRegisterTests, CPUTerminatesIfInstructionInvalid) {
-    cpu.mem[0xFFFC] = 0x00;
+    cpu.mem[0xFFFC] = m6502::CPU::INS_JAM;
     cpu.mem[0xFFFD] = 0x00;
     constexpr m6502::dword EXPECTED_CYCLES = 1;
     m6502::dword cyclesUsed = cpu.execute();
@@ -0,0 +1,248 @@
+#include "gtest/gtest.h"
+#include "6502Lockstep.h"
+#include <memory>
+#include <random>
+
+class _6502LockstepTests : public testing::Test {
+public:
+    m6502::VirtualClock clock;
+    std::mt19937 random{6502};
+    virtual void SetUp() {}
+    virtual void TearDown() {}
+
+    /*every instance runs the same random program at 0x8000 over its own random data. JMP ($9000,k)
+     * goes through a per instance table of instruction starts, so instances split up and meet again.*/
+    std::vector<std::unique_ptr<m6502::CPU>> MakeInstances(size_t count) {
+        struct Instruction { m6502::byte opcode, length; };
+        //implied instructions fetch a second byte in this emulator
+        static const Instruction instructions[] {
+            {m6502::CPU::INS_LDA_IM, 2}, {m6502::CPU::INS_LDA_ZP, 2}, {m6502::CPU::INS_LDA_ZPX, 2}, {m6502::CPU::INS_LDA_ABS, 3},
+            {m6502::CPU::INS_LDA_ABSX, 3}, {m6502::CPU::INS_LDA_ABSY, 3}, {m6502::CPU::INS_LDA_XIND, 2}, {m6502::CPU::INS_LDA_INDY, 2},
+            {m6502::CPU::INS_LDX_IM, 2}, {m6502::CPU::INS_LDX_ZPY, 2}, {m6502::CPU::INS_LDY_ABSX, 3}, {m6502::CPU::INS_LDY_IM, 2},
+            {m6502::CPU::INS_STA_ZP, 2}, {m6502::CPU::INS_STA_ABSX, 3}, {m6502::CPU::INS_STA_ABSY, 3}, {m6502::CPU::INS_STA_INDY, 2},
+            {m6502::CPU::INS_STA_XIND, 2}, {m6502::CPU::INS_STX_ZPY, 2}, {m6502::CPU::INS_STY_ZPX, 2}, {m6502::CPU::INS_STY_ABS, 3},
+            {m6502::CPU::INS_AND_INDY, 2}, {m6502::CPU::INS_ORA_ABSY, 3}, {m6502::CPU::INS_EOR_XIND, 2}, {m6502::CPU::INS_EOR_IM, 2},
+            {m6502::CPU::INS_BIT_ZP, 2}, {m6502::CPU::INS_BIT_ABS, 3}, {m6502::CPU::INS_PHA_IMP, 2}, {m6502::CPU::INS_PHP_IMP, 2},
+            {m6502::CPU::INS_PLA_IMP, 2}, {m6502::CPU::INS_PLP_IMP, 2}, {m6502::CPU::INS_TSX_IMP, 2}, {m6502::CPU::INS_TXS_IMP, 2},
+            {m6502::CPU::INS_JSR, 3}, {m6502::CPU::INS_RTS, 1}, {m6502::CPU::INS_JMP_IND, 3}, {m6502::CPU::INS_JMP_IND, 3}};
+        std::vector<m6502::byte> program;
+        std::vector<m6502::word> starts;
+        std::vector<size_t> targets;   //operands that need an instruction start
+        while (program.size() < 0x200) {
+            const Instruction& instruction = instructions[random() % (sizeof instructions / sizeof instructions[0])];
+            starts.push_back(static_cast<m6502::word>(0x8000 + program.size()));
+            program.push_back(instruction.opcode);
+            if (instruction.opcode == m6502::CPU::INS_JMP_IND) {
+                program.insert(program.end(), {static_cast<m6502::byte>(2 * (random() % 16)), 0x90});
+            } else if (instruction.opcode == m6502::CPU::INS_JSR) {
+                targets.push_back(program.size());
+                program.insert(program.end(), {0, 0});
+            } else if (instruction.length == 3) {
+                program.insert(program.end(), {static_cast<m6502::byte>(random()), static_cast<m6502::byte>(0x02 + random() % 0x70)});
+            } else if (instruction.length == 2) {
+                program.push_back(random());
+            }
+        }
+        program.insert(program.end(), {m6502::CPU::INS_JMP_ABS, 0x00, 0x80});
+        for (size_t operand : targets) {
+            m6502::word target = starts[random() % starts.size()];
+            program[operand] = target & 0xFF;
+            program[operand + 1] = target >> 8;
+        }
+
+        std::vector<std::unique_ptr<m6502::CPU>> cpus;
+        for (size_t i{0}; i < count; ++i) {
+            std::unique_ptr<m6502::CPU> cpu{new m6502::CPU{clock}};
+            for (m6502::dword address{0}; address < m6502::CPU::Mem::MAX_MEM; ++address)
+                cpu->mem[address] = random();
+            for (size_t j{0}; j < program.size(); ++j)
+                cpu->mem[0x8000 + j] = program[j];
+            for (m6502::word entry{0x9000}; entry < 0x9020; entry += 2) {
+                m6502::word target = starts[random() % starts.size()];
+                cpu->mem[entry] = target & 0xFF;
+                cpu->mem[entry + 1] = target >> 8;
+            }
+            cpu->PC = 0x8000;
+            cpu->SP = random();
+            cpu->A = random();
+            cpu->X = random();
+            cpu->Y = random();
+            cpu->PS = random() & 0xFF;
+            cpus.push_back(std::move(cpu));
+        }
+        return cpus;
+    }
+
+    void TestMatchesScalarCPU(bool avx2, size_t count, uint64_t instructions) {
+        auto cpus = MakeInstances(count);
+        m6502::LockstepCPU lockstep{count};
+        lockstep.useAVX2(avx2);
+        for (size_t i{0}; i < count; ++i)
+            lockstep.load(i, *cpus[i]);
+        lockstep.execute(instructions);
+
+        m6502::CPU result{clock};
+        for (size_t i{0}; i < count; ++i) {
+            m6502::dword cyclesUsed = cpus[i]->execute(instructions);
+            lockstep.store(i, result);
+            EXPECT_EQ(lockstep.getCycles(i), cyclesUsed) << "instance " << i;
+            EXPECT_EQ(lockstep.getInstructionsExecuted(i), cpus[i]->instructionsExecuted) << "instance " << i;
+            EXPECT_EQ(result.PC, cpus[i]->PC) << "instance " << i;
+            EXPECT_EQ(result.SP, cpus[i]->SP) << "instance " << i;
+            EXPECT_EQ(result.A, cpus[i]->A) << "instance " << i;
+            EXPECT_EQ(result.X, cpus[i]->X) << "instance " << i;
+            EXPECT_EQ(result.Y, cpus[i]->Y) << "instance " << i;
+            EXPECT_EQ(result.PS, cpus[i]->PS) << "instance " << i;
+            EXPECT_TRUE(result.mem == cpus[i]->mem) << "instance " << i;
+        }
+    }
+};
+
+TEST_F(_6502LockstepTests, ScalarLanesMatchTheCPU) {
+    TestMatchesScalarCPU(false, 37, 200);
+}
+
+TEST_F(_6502LockstepTests, AVX2LanesMatchTheCPU) {
+    if (!m6502::LockstepCPU::hasAVX2()) GTEST_SKIP() << "host has no AVX2";
+    TestMatchesScalarCPU(true, 67, 200);
+}
+
+TEST_F(_6502LockstepTests, IdenticalInstancesStayInOneGroup) {
+    constexpr size_t INSTANCES = 64;
+    m6502::LockstepCPU lockstep{INSTANCES};
+    m6502::CPU cpu{clock};
+    cpu.PC = 0x8000;
+    const m6502::byte program[] {
+            m6502::CPU::INS_LDA_ZP, 0x10,
+            m6502::CPU::INS_EOR_IM, 0x5A,
+            m6502::CPU::INS_STA_ABS, 0x00, 0x02,
+            m6502::CPU::INS_JMP_ABS, 0x00, 0x80};
+    for (size_t i{0}; i < sizeof program; ++i)
+        cpu.mem[0x8000 + i] = program[i];
+    for (size_t i{0}; i < INSTANCES; ++i) {
+        cpu.mem[0x10] = static_cast<m6502::byte>(i);
+        lockstep.load(i, cpu);
+    }
+    constexpr uint64_t INSTRUCTIONS = 400;
+    lockstep.execute(INSTRUCTIONS);
+
+    EXPECT_EQ(lockstep.getStats().regroups, 1u);
+    if (m6502::LockstepCPU::hasAVX2()) {
+        EXPECT_EQ(lockstep.getStats().vectorSteps, INSTANCES / 8 * INSTRUCTIONS);
+        EXPECT_EQ(lockstep.getStats().vectorLanes, INSTANCES * INSTRUCTIONS);
+    } else {
+        EXPECT_EQ(lockstep.getStats().scalarLanes, INSTANCES * INSTRUCTIONS);
+    }
+    for (size_t i{0}; i < INSTANCES; ++i) {
+        EXPECT_EQ(lockstep.memory(i)[0x0200], static_cast<m6502::byte>(i ^ 0x5A));
+        EXPECT_EQ(lockstep.getCycles(i), 100u * (3 + 2 + 4 + 3));
+    }
+}
+
+TEST_F(_6502LockstepTests, InstancesStopOnUnhandledOpcodes) {
+    m6502::LockstepCPU lockstep{3};
+    m6502::CPU cpu{clock};
+    cpu.PC = 0x8000;
+    cpu.mem[0x8000] = m6502::CPU::INS_LDA_IM;
+    cpu.mem[0x8001] = 0x42;
+    cpu.mem[0x8002] = m6502::CPU::INS_JAM;
+    lockstep.load(0, cpu);
+    cpu.mem[0x8000] = m6502::CPU::INS_JAM;
+    lockstep.load(1, cpu);
+    cpu.mem[0x8002] = m6502::CPU::INS_LDX_IM;
+    cpu.mem[0x8004] = m6502::CPU::INS_JAM;
+    cpu.mem[0x8000] = m6502::CPU::INS_LDA_IM;
+    lockstep.load(2, cpu);
+    lockstep.execute(10);
+
+    EXPECT_EQ(lockstep.getInstructionsExecuted(0), 1u);
+    EXPECT_EQ(lockstep.getCycles(0), 3u);
+    EXPECT_EQ(lockstep.getInstructionsExecuted(1), 0u);
+    EXPECT_EQ(lockstep.getCycles(1), 1u);
+    EXPECT_EQ(lockstep.getInstructionsExecuted(2), 2u);
+    EXPECT_EQ(lockstep.getCycles(2), 5u);
+}
+
+TEST_F(_6502LockstepTests, DevicesStayWithTheCPUAndUnchangedPagesStayShared) {
+    struct Device : m6502::Bus {
+        m6502::byte read(m6502::word) override { return 0xEE; }
+        void write(m6502::word, m6502::byte) override {}
+    } device;
+    m6502::LockstepCPU lockstep{1};
+    m6502::CPU cpu{clock};
+    cpu.PC = 0x8000;
+    //LDA #$42; STA $0200; JAM
+    const m6502::byte program[] {m6502::CPU::INS_LDA_IM, 0x42, m6502::CPU::INS_STA_ABS, 0x00, 0x02, m6502::CPU::INS_JAM};
+    for (size_t i{0}; i < sizeof program; ++i)
+        cpu.mem[0x8000 + i] = program[i];
+    m6502::CPU withDevice = cpu;
+    withDevice.mem.map(device, 0xD0, 1);
+    EXPECT_FALSE(lockstep.load(0, withDevice));
+    ASSERT_TRUE(lockstep.load(0, cpu));
+    lockstep.execute(10);
+
+    lockstep.store(0, withDevice);
+    EXPECT_EQ(withDevice.PC, 0x8006);
+    EXPECT_EQ(withDevice.mem[0x0200], 0x42);
+    EXPECT_TRUE(withDevice.mem.isMapped(0xD0));
+    EXPECT_EQ(withDevice.mem.read(0xD000), 0xEE);
+    //the program's page is still the one cpu holds
+    EXPECT_EQ(withDevice.mem.pageData(0x80), cpu.mem.pageData(0x80));
+    EXPECT_EQ(withDevice.mem.ownPages(), 1u);
+}
+
+TEST_F(_6502LockstepTests, PendingInterruptsAreTakenLikeTheCPUTakesThem) {
+    using CPU = m6502::CPU;
+    constexpr size_t INSTANCES = 16;
+    CPU cpu{clock};
+    cpu.PC = 0x8000;
+    //LDA #$01; STA $11; JMP $8000, IRQ: PHA; LDA #$33; STA $12; PLA; RTI, NMI: PHA; LDA #$77; STA $10; PLA; RTI
+    const m6502::byte program[] {CPU::INS_LDA_IM, 0x01, CPU::INS_STA_ZP, 0x11, CPU::INS_JMP_ABS, 0x00, 0x80};
+    const m6502::byte irq[] {CPU::INS_PHA_IMP, 0x00, CPU::INS_LDA_IM, 0x33, CPU::INS_STA_ZP, 0x12,
+                             CPU::INS_PLA_IMP, 0x00, CPU::INS_RTI};
+    const m6502::byte nmi[] {CPU::INS_PHA_IMP, 0x00, CPU::INS_LDA_IM, 0x77, CPU::INS_STA_ZP, 0x10,
+                             CPU::INS_PLA_IMP, 0x00, CPU::INS_RTI};
+    for (size_t i{0}; i < sizeof program; ++i)
+        cpu.mem[0x8000 + i] = program[i];
+    for (size_t i{0}; i < sizeof irq; ++i)
+        cpu.mem[0x9000 + i] = irq[i];
+    for (size_t i{0}; i < sizeof nmi; ++i)
+        cpu.mem[0x9100 + i] = nmi[i];
+    cpu.mem[0xFFFA] = 0x00;
+    cpu.mem[0xFFFB] = 0x91;
+    cpu.mem[0xFFFE] = 0x00;
+    cpu.mem[0xFFFF] = 0x90;
+    //none, an IRQ, an IRQ masked by I, an NMI with I set
+    std::vector<CPU> cpus(INSTANCES, cpu);
+    for (size_t i{0}; i < INSTANCES; ++i) {
+        cpus[i].PS.set(CPU::StatusFlags::I, i % 4 >= 2);
+        if (i % 4 == 1 || i % 4 == 2) cpus[i].irq(true);
+        if (i % 4 == 3) cpus[i].nmi();
+    }
+
+    for (bool avx2 : {false, true}) {
+        if (avx2 && !m6502::LockstepCPU::hasAVX2()) continue;
+        m6502::LockstepCPU lockstep{INSTANCES};
+        lockstep.useAVX2(avx2);
+        for (size_t i{0}; i < INSTANCES; ++i)
+            ASSERT_TRUE(lockstep.load(i, cpus[i]));
+        lockstep.execute(20);
+        for (size_t i{0}; i < INSTANCES; ++i) {
+            CPU reference = cpus[i];
+            const m6502::dword cyclesUsed = reference.execute(20);
+            CPU result{clock};
+            lockstep.store(i, result);
+            EXPECT_EQ(lockstep.getCycles(i), cyclesUsed) << "instance " << i;
+            EXPECT_EQ(lockstep.getInstructionsExecuted(i), reference.instructionsExecuted) << "instance " << i;
+            EXPECT_EQ(result.PC, reference.PC) << "instance " << i;
+            EXPECT_EQ(result.SP, reference.SP) << "instance " << i;
+            EXPECT_EQ(result.A, reference.A) << "instance " << i;
+            EXPECT_EQ(result.PS, reference.PS) << "instance " << i;
+            EXPECT_EQ(result.interrupts, reference.interrupts) << "instance " << i;
+            EXPECT_TRUE(result.mem == reference.mem) << "instance " << i;
+        }
+        EXPECT_EQ(lockstep.memory(3)[0x10], 0x77);
+        EXPECT_EQ(lockstep.memory(1)[0x12], 0x33);
+        EXPECT_EQ(lockstep.memory(2)[0x12], 0x00);
+    }
+}
@@ -4,7 +4,8 @@
 
 class _6502LogicalOperationTests : public testing::Test {
 public:
-    m6502::CPU cpu{.01};
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
     virtual void SetUp() { setCPUState(); }
     virtual void TearDown() {}
 
@@ -0,0 +1,158 @@
+#include "gtest/gtest.h"
+#include "6502Mapper.h"
+#include "6502Rewind.h"
+#include <vector>
+
+class _6502MapperTests : public testing::Test {
+public:
+    static constexpr m6502::dword BANK = 0x4000;
+    m6502::Mapper mapper{BANK};
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    //8 banks of 16 KB, each filled with its number plus where in the bank it is
+    std::vector<m6502::byte> image;
+    virtual void SetUp() {
+        cpu.reset();
+        for (m6502::dword i{0}; i < 8 * BANK; ++i)
+            image.push_back(static_cast<m6502::byte>(i / BANK * 0x10 + i % BANK % 7));
+        mapper.addRom(image.data(), image.size());
+    }
+    virtual void TearDown() {}
+};
+
+constexpr m6502::dword _6502MapperTests::BANK;
+
+TEST_F(_6502MapperTests, WindowShowsTheSelectedBank) {
+    const size_t window = mapper.addWindow(cpu.mem, 0x8000, 3);
+    EXPECT_EQ(mapper.getBanks(), 8u);
+    EXPECT_EQ(cpu.mem[0x8000], 0x30);
+    EXPECT_EQ(cpu.mem[0xBFFF], 0x30 + (BANK - 1) % 7);
+    //outside the window nothing changed
+    EXPECT_EQ(cpu.mem[0x7FFF], 0x00);
+    EXPECT_EQ(cpu.mem[0xC000], 0x00);
+
+    mapper.select(window, 6);
+    EXPECT_EQ(cpu.mem[0x8000], 0x60);
+    EXPECT_EQ(mapper.selected(window), 6u);
+    EXPECT_TRUE(cpu.mem.dirtyPages().test(0x80));
+    EXPECT_TRUE(cpu.mem.dirtyPages().test(0xBF));
+}
+
+TEST_F(_6502MapperTests, BanksPastTheLastOneWrapAround) {
+    const size_t window = mapper.addWindow(cpu.mem, 0x4000, 0);
+    mapper.select(window, 8 + 5);
+    EXPECT_EQ(mapper.selected(window), 5u);
+    EXPECT_EQ(cpu.mem[0x4000], 0x50);
+}
+
+TEST_F(_6502MapperTests, CPUSwitchesBanksThroughTheRegisters) {
+    using CPU = m6502::CPU;
+    m6502::EventQueue queue;
+    m6502::Devices devices{queue};
+    devices.add(mapper, 0xD000, 2);
+    devices.attach(cpu.mem);
+    mapper.addWindow(cpu.mem, 0x8000, 0);
+    mapper.addWindow(cpu.mem, 0x4000, 1);
+    //LDA $8000; STA $10; LDA #$02; STA $D000; LDA $8000; STA $11; LDA $D001; STA $12; JAM
+    const m6502::byte program[] {CPU::INS_LDA_ABS, 0x00, 0x80, CPU::INS_STA_ZP, 0x10,
+                                 CPU::INS_LDA_IM, 0x02, CPU::INS_STA_ABS, 0x00, 0xD0,
+                                 CPU::INS_LDA_ABS, 0x00, 0x80, CPU::INS_STA_ZP, 0x11,
+                                 CPU::INS_LDA_ABS, 0x01, 0xD0, CPU::INS_STA_ZP, 0x12, CPU::INS_JAM};
+    for (size_t i{0}; i < sizeof program; ++i)
+        cpu.mem[0xC000 + i] = program[i];
+    cpu.PC = 0xC000;
+    queue.run(cpu, 1000);
+
+    EXPECT_TRUE(queue.isStopped());
+    EXPECT_EQ(cpu.mem[0x10], 0x00);
+    EXPECT_EQ(cpu.mem[0x11], 0x20);
+    EXPECT_EQ(cpu.mem[0x12], 0x01);
+    EXPECT_EQ(cpu.mem.read(0xD000), 0x02);
+    EXPECT_EQ(mapper.getStats().switches, 3u);
+}
+
+TEST_F(_6502MapperTests, RewindGoesBackToTheBanksSelectedThen) {
+    using CPU = m6502::CPU;
+    m6502::EventQueue queue;
+    m6502::Devices devices{queue};
+    devices.add(mapper, 0xD000, 1);
+    devices.attach(cpu.mem);
+    mapper.addWindow(cpu.mem, 0x8000, 0);
+    //LDA #$02; STA $D000; LDA $8000; STA $10; LDA #$05; STA $D000; LDA $8000; STA $11; LDA $D000; STA $12; JAM
+    const m6502::byte program[] {CPU::INS_LDA_IM, 0x02, CPU::INS_STA_ABS, 0x00, 0xD0,
+                                 CPU::INS_LDA_ABS, 0x00, 0x80, CPU::INS_STA_ZP, 0x10,
+                                 CPU::INS_LDA_IM, 0x05, CPU::INS_STA_ABS, 0x00, 0xD0,
+                                 CPU::INS_LDA_ABS, 0x00, 0x80, CPU::INS_STA_ZP, 0x11,
+                                 CPU::INS_LDA_ABS, 0x00, 0xD0, CPU::INS_STA_ZP, 0x12, CPU::INS_JAM};
+    for (size_t i{0}; i < sizeof program; ++i)
+        cpu.mem[0xC000 + i] = program[i];
+    cpu.PC = 0xC000;
+    m6502::Rewinder rewinder{cpu, 1 << 20, 1, &mapper};
+    rewinder.run(1000);
+    ASSERT_TRUE(rewinder.isStopped());
+    EXPECT_EQ(mapper.selected(0), 5u);
+
+    //between the two switches, 2 + 4 + 4 + 3 cycles in
+    ASSERT_TRUE(rewinder.rewindTo(13));
+    EXPECT_EQ(mapper.selected(0), 2u);
+    EXPECT_EQ(cpu.mem.read(0xD000), 0x02);
+    EXPECT_EQ(cpu.mem[0x8000], 0x20);
+    rewinder.run(1000);
+    EXPECT_EQ(cpu.mem[0x11], 0x50);
+    EXPECT_EQ(cpu.mem[0x12], 0x05);
+
+    //before the first
+    ASSERT_TRUE(rewinder.rewindTo(2));
+    EXPECT_EQ(mapper.selected(0), 0u);
+    EXPECT_EQ(cpu.mem[0x8000], 0x00);
+}
+
+TEST_F(_6502MapperTests, CodeRunsFromTheBankSwitchedIn) {
+    using CPU = m6502::CPU;
+    //bank 1 at $8000: LDA #$11; STA $10; JAM, bank 2 at $8000: LDA #$22; STA $10; JAM
+    image.assign(3 * BANK, 0);
+    const m6502::byte one[] {CPU::INS_LDA_IM, 0x11, CPU::INS_STA_ZP, 0x10, CPU::INS_JAM};
+    const m6502::byte two[] {CPU::INS_LDA_IM, 0x22, CPU::INS_STA_ZP, 0x10, CPU::INS_JAM};
+    std::copy(one, one + sizeof one, image.begin() + BANK);
+    std::copy(two, two + sizeof two, image.begin() + 2 * BANK);
+    const m6502::dword first = mapper.addRom(image.data(), image.size());
+    const size_t window = mapper.addWindow(cpu.mem, 0x8000, first + 1);
+
+    cpu.PC = 0x8000;
+    cpu.execute(UINT64_MAX);
+    EXPECT_EQ(cpu.mem[0x10], 0x11);
+    mapper.select(window, first + 2);
+    cpu.PC = 0x8000;
+    cpu.execute(UINT64_MAX);
+    EXPECT_EQ(cpu.mem[0x10], 0x22);
+}
+
+TEST_F(_6502MapperTests, RamBanksKeepTheirContentsWhileSwitchedOut) {
+    const m6502::dword ram = mapper.addRam(2);
+    EXPECT_EQ(ram, 8u);
+    const size_t window = mapper.addWindow(cpu.mem, 0x4000, ram);
+    cpu.mem.write(0x4123, 0xAA);
+    mapper.select(window, ram + 1);
+    EXPECT_EQ(cpu.mem[0x4123], 0x00);
+    cpu.mem.write(0x4123, 0xBB);
+
+    mapper.select(window, ram);
+    EXPECT_EQ(cpu.mem[0x4123], 0xAA);
+    mapper.select(window, ram + 1);
+    EXPECT_EQ(cpu.mem[0x4123], 0xBB);
+}
+
+TEST_F(_6502MapperTests, RomWritesAreLocalAndGoneAfterASwitch) {
+    const size_t window = mapper.addWindow(cpu.mem, 0x8000, 1);
+    m6502::Memory copy{cpu.mem};
+    cpu.mem.write(0x8000, 0xEE);
+    EXPECT_EQ(cpu.mem[0x8000], 0xEE);
+    EXPECT_EQ(copy[0x8000], 0x10);
+
+    mapper.select(window, 2);
+    mapper.select(window, 1);
+    EXPECT_EQ(cpu.mem[0x8000], 0x10);
+    //the banks stay shared with the copy
+    EXPECT_EQ(cpu.mem.pageData(0x81), copy.pageData(0x81));
+    EXPECT_EQ(cpu.mem.hash(), copy.hash());
+}
@@ -0,0 +1,148 @@
+#include "gtest/gtest.h"
+#include "6502.h"
+#include <vector>
+
+class _6502MemoryTests : public testing::Test {
+public:
+    m6502::VirtualClock clock;
+    virtual void SetUp() {}
+    virtual void TearDown() {}
+};
+
+TEST_F(_6502MemoryTests, NewMemoryIsZeroAndOwnsNoPages) {
+    m6502::Memory mem;
+    for (m6502::dword address{0}; address < m6502::Memory::MAX_MEM; address += 0x7F)
+        EXPECT_EQ(mem.read(static_cast<m6502::word>(address)), 0);
+    EXPECT_EQ(mem.ownPages(), 0u);
+    mem.write(0x1234, 0x42);
+    EXPECT_EQ(mem.read(0x1234), 0x42);
+    EXPECT_EQ(mem.ownPages(), 1u);
+    mem.initialize();
+    EXPECT_EQ(mem.read(0x1234), 0);
+    EXPECT_EQ(mem.ownPages(), 0u);
+}
+
+TEST_F(_6502MemoryTests, CopiesShareUntilWritten) {
+    m6502::Memory original;
+    original[0x0200] = 0x11;
+    original[0x0300] = 0x22;
+    m6502::Memory copy{original};
+    EXPECT_EQ(original.ownPages(), 0u);
+    EXPECT_EQ(copy.ownPages(), 0u);
+    EXPECT_TRUE(copy == original);
+
+    copy.write(0x0200, 0x33);
+    original.write(0x0300, 0x44);
+    EXPECT_EQ(original.read(0x0200), 0x11);
+    EXPECT_EQ(copy.read(0x0200), 0x33);
+    EXPECT_EQ(original.read(0x0300), 0x44);
+    EXPECT_EQ(copy.read(0x0300), 0x22);
+    EXPECT_EQ(copy.ownPages(), 2u);
+    EXPECT_EQ(original.ownPages(), 2u);
+    EXPECT_TRUE(copy != original);
+}
+
+TEST_F(_6502MemoryTests, LastReferenceWritesInPlace) {
+    m6502::Memory original;
+    original[0x0200] = 0x11;
+    {
+        m6502::Memory copy{original};
+    }
+    EXPECT_EQ(original.ownPages(), 1u);
+    original.write(0x0201, 0x22);
+    EXPECT_EQ(original.ownPages(), 1u);
+    EXPECT_EQ(original.read(0x0200), 0x11);
+}
+
+TEST_F(_6502MemoryTests, RomPagesAreSharedByEveryInstance) {
+    //LDA $10; STA $0200; JMP $8000 only writes page 2, the program pages stay shared
+    const m6502::byte program[] {
+            m6502::CPU::INS_LDA_ZP, 0x10,
+            m6502::CPU::INS_STA_ABS, 0x00, 0x02,
+            m6502::CPU::INS_JMP_ABS, 0x00, 0x80};
+    std::vector<m6502::byte> image(0x8000, 0xEA);
+    std::copy(program, program + sizeof program, image.begin());
+    image[0x7FFC] = 0x00;
+    image[0x7FFD] = 0x80;
+    m6502::Rom rom{0x8000, image.data(), image.size()};
+    EXPECT_EQ(rom.getPages(), 128u);
+
+    std::vector<std::unique_ptr<m6502::CPU>> cpus;
+    for (m6502::byte i{0}; i < 16; ++i) {
+        std::unique_ptr<m6502::CPU> cpu{new m6502::CPU{clock}};
+        cpu->mem.map(rom);
+        cpu->mem.write(0x10, i);
+        cpu->reset();
+        EXPECT_EQ(cpu->PC, 0x8000);
+        cpu->execute(30);
+        cpus.push_back(std::move(cpu));
+    }
+    for (m6502::byte i{0}; i < 16; ++i) {
+        EXPECT_EQ(cpus[i]->mem.read(0x0200), i);
+        //the zero page and page 2
+        EXPECT_EQ(cpus[i]->mem.ownPages(), 2u);
+    }
+}
+
+TEST_F(_6502MemoryTests, WritingIntoARomCopiesThePage) {
+    const m6502::byte bytes[] {1, 2, 3};
+    m6502::Rom rom{0xF000, bytes, sizeof bytes};
+    m6502::Memory first, second;
+    first.map(rom);
+    second.map(rom);
+    first.write(0xF001, 0x42);
+    EXPECT_EQ(first.read(0xF001), 0x42);
+    EXPECT_EQ(second.read(0xF001), 2);
+    EXPECT_EQ(first.ownPages(), 1u);
+    EXPECT_EQ(second.ownPages(), 0u);
+}
+
+TEST_F(_6502MemoryTests, RomOutlivedByTheMemoriesItWasMappedInto) {
+    m6502::Memory mem;
+    {
+        const m6502::byte bytes[] {0xAB};
+        m6502::Rom rom{0x9000, bytes, sizeof bytes};
+        mem.map(rom);
+    }
+    EXPECT_EQ(mem.read(0x9000), 0xAB);
+    EXPECT_EQ(mem.ownPages(), 1u);
+}
+
+TEST_F(_6502MemoryTests, WritesMarkPagesDirty) {
+    m6502::Memory mem;
+    mem.write(0x0010, 1);
+    mem.write(0x0011, 2);
+    mem.write(0x8000, 3);
+    EXPECT_EQ(mem.dirtyPages().count(), 2u);
+    EXPECT_TRUE(mem.dirtyPages().test(0x00));
+    EXPECT_TRUE(mem.dirtyPages().test(0x80));
+
+    mem.clearDirty();
+    EXPECT_EQ(mem.dirtyPages().count(), 0u);
+    mem.read(0x0010);
+    EXPECT_EQ(mem.dirtyPages().count(), 0u);
+    mem.write(0x8001, 4);
+    EXPECT_EQ(mem.dirtyPages().count(), 1u);
+    EXPECT_TRUE(mem.dirtyPages().test(0x80));
+    EXPECT_EQ(mem.read(0x8000), 3);
+    EXPECT_EQ(mem.ownPages(), 2u);
+}
+
+TEST_F(_6502MemoryTests, InitializeOnlyVisitsUsedPages) {
+    m6502::Memory mem;
+    for (int round{0}; round < 3; ++round) {
+        mem.write(0x0100, 0xFF);
+        mem.write(0x4242, 0xFF);
+        EXPECT_EQ(mem.usedPages().count(), 2u);
+        mem.initialize();
+        EXPECT_EQ(mem.usedPages().count(), 0u);
+        EXPECT_EQ(mem.ownPages(), 0u);
+        EXPECT_EQ(mem.read(0x0100), 0);
+        EXPECT_EQ(mem.read(0x4242), 0);
+    }
+    std::vector<m6502::dword> visited;
+    mem.write(0x0300, 1);
+    mem.write(0xFF00, 1);
+    mem.usedPages().forEach([&visited](m6502::dword page) { visited.push_back(page); });
+    EXPECT_EQ(visited, (std::vector<m6502::dword>{0x03, 0xFF}));
+}
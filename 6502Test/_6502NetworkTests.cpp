@@ -0,0 +1,152 @@
+#include "gtest/gtest.h"
+#include "6502Network.h"
+#include <memory>
+#include <vector>
+
+class _6502NetworkTests : public testing::Test {
+public:
+    using CPU = m6502::CPU;
+    m6502::VirtualClock clock;
+    virtual void SetUp() {}
+    virtual void TearDown() {}
+
+    //the IRQ handler at 0x9000
+    std::unique_ptr<CPU> MakeNode(std::initializer_list<m6502::byte> program, std::initializer_list<m6502::byte> handler) {
+        std::unique_ptr<CPU> cpu{new CPU{clock}};
+        m6502::word address{0x8000};
+        for (m6502::byte value : program)
+            cpu->mem[address++] = value;
+        address = 0x9000;
+        for (m6502::byte value : handler)
+            cpu->mem[address++] = value;
+        cpu->mem[CPU::IRQ_VECTOR] = 0x00;
+        cpu->mem[CPU::IRQ_VECTOR + 1] = 0x90;
+        cpu->PC = 0x8000;
+        return cpu;
+    }
+
+    /* nodes in a ring, each with its left port at $D000 and right one at $D010. Whatever a node
+     * receives it sends on plus one and logs at $0500, the first node starts with 0. Returns
+     * every node's log and log length */
+    std::vector<m6502::byte> Ring(size_t nodes, std::initializer_list<uint64_t> runs, unsigned threads) {
+        std::vector<std::unique_ptr<CPU>> cpus;
+        m6502::Network network;
+        for (size_t i{0}; i < nodes; ++i) {
+            //LDA #$01; STA $D001; then node 0 LDA #$00; STA $D010; and JMP to itself
+            if (i == 0) cpus.push_back(MakeNode({CPU::INS_LDA_IM, 0x01, CPU::INS_STA_ABS, 0x01, 0xD0,
+                                                 CPU::INS_LDA_IM, 0x00, CPU::INS_STA_ABS, 0x10, 0xD0,
+                                                 CPU::INS_JMP_ABS, 0x0A, 0x80}, RingHandler()));
+            else cpus.push_back(MakeNode({CPU::INS_LDA_IM, 0x01, CPU::INS_STA_ABS, 0x01, 0xD0,
+                                          CPU::INS_JMP_ABS, 0x05, 0x80}, RingHandler()));
+            for (m6502::dword x{0}; x < 0x100; ++x)
+                cpus.back()->mem[0x0400 + x] = static_cast<m6502::byte>(x + 1);
+            network.add(*cpus.back());
+        }
+        for (size_t i{0}; i < nodes; ++i)
+            network.connect(i, 0xD010, (i + 1) % nodes, 0xD000, 40 + 10 * i);
+        for (uint64_t cycles : runs)
+            network.run(cycles, threads);
+        EXPECT_EQ(network.getLookahead(), 40u);
+
+        std::vector<m6502::byte> logs;
+        for (auto& cpu : cpus) {
+            for (m6502::word address{0x0500}; address < 0x0600; ++address)
+                logs.push_back(cpu->mem[address]);
+            logs.push_back(cpu->mem[0x20]);
+        }
+        return logs;
+    }
+
+    //LDX $D000; LDA $0400,X; STA $D010; LDY $20; STA $0500,Y; LDA $0400,Y; STA $20; RTI
+    static std::initializer_list<m6502::byte> RingHandler() {
+        static const std::initializer_list<m6502::byte> handler {
+                CPU::INS_LDX_ABS, 0x00, 0xD0, CPU::INS_LDA_ABSX, 0x00, 0x04, CPU::INS_STA_ABS, 0x10, 0xD0,
+                CPU::INS_LDY_ZP, 0x20, CPU::INS_STA_ABSY, 0x00, 0x05, CPU::INS_LDA_ABSY, 0x00, 0x04,
+                CPU::INS_STA_ZP, 0x20, CPU::INS_RTI};
+        return handler;
+    }
+};
+
+TEST_F(_6502NetworkTests, BytesArriveAfterTheLinkLatency) {
+    //LDA #$42; STA $D000; JAM
+    auto sender = MakeNode({CPU::INS_LDA_IM, 0x42, CPU::INS_STA_ABS, 0x00, 0xD0, CPU::INS_JAM}, {});
+    //JMP to itself, the handler: LDA $D000; STA $10; JAM
+    auto receiver = MakeNode({CPU::INS_JMP_ABS, 0x00, 0x80},
+                             {CPU::INS_LDA_ABS, 0x00, 0xD0, CPU::INS_STA_ZP, 0x10, CPU::INS_JAM});
+    m6502::Network network;
+    network.add(*sender);
+    network.add(*receiver);
+    const size_t link = network.connect(0, 0xD000, 1, 0xD000, 100);
+    receiver->mem.write(0xD001, 1);
+
+    network.run(100);
+    EXPECT_TRUE(network.isStopped(0));
+    EXPECT_EQ(network.port(link, 0).getSent(), 1u);
+    EXPECT_EQ(network.port(link, 1).getReceived(), 0u);
+    EXPECT_EQ(receiver->mem[0x10], 0x00);
+
+    network.run(100);
+    EXPECT_TRUE(network.isStopped(1));
+    EXPECT_EQ(receiver->mem[0x10], 0x42);
+    EXPECT_EQ(network.port(link, 1).getReceived(), 1u);
+    EXPECT_EQ(network.port(link, 1).waiting(), 0u);
+    //it arrived 100 cycles after the write, then the IRQ, the handler and the JMP it interrupted
+    EXPECT_GE(network.queue(1).now(), 102u + 15u);
+    EXPECT_LE(network.queue(1).now(), 106u + 17u);
+}
+
+TEST_F(_6502NetworkTests, BytesWaitInOrderUntilRead) {
+    //LDA #$01; STA $D000; LDA #$02; STA $D000; LDA #$03; STA $D000; JAM
+    auto sender = MakeNode({CPU::INS_LDA_IM, 0x01, CPU::INS_STA_ABS, 0x00, 0xD0, CPU::INS_LDA_IM, 0x02,
+                            CPU::INS_STA_ABS, 0x00, 0xD0, CPU::INS_LDA_IM, 0x03, CPU::INS_STA_ABS, 0x00, 0xD0,
+                            CPU::INS_JAM}, {});
+    auto receiver = MakeNode({CPU::INS_JMP_ABS, 0x00, 0x80}, {});
+    m6502::Network network;
+    network.add(*sender);
+    network.add(*receiver);
+    network.connect(0, 0xD000, 1, 0xD000, 10);
+    network.run(200);
+
+    EXPECT_EQ(network.getStats().messages, 3u);
+    EXPECT_EQ(network.getStats().windows, 20u);
+    EXPECT_EQ(receiver->mem.read(0xD001), 3);
+    EXPECT_EQ(receiver->mem.read(0xD000), 1);
+    EXPECT_EQ(receiver->mem.read(0xD000), 2);
+    EXPECT_EQ(receiver->mem.read(0xD000), 3);
+    EXPECT_EQ(receiver->mem.read(0xD001), 0);
+    EXPECT_EQ(receiver->mem.read(0xD000), 0);
+    //nothing came back, and without asking for it there was no IRQ
+    EXPECT_EQ(sender->mem.read(0xD001), 0);
+    EXPECT_EQ(receiver->PC, 0x8000);
+}
+
+TEST_F(_6502NetworkTests, RingPassesItsCounterAround) {
+    const std::vector<m6502::byte> logs = Ring(4, {20000}, 1);
+    //the first node hears back 4, 8 and so on
+    EXPECT_EQ(logs[0], 4);
+    EXPECT_EQ(logs[1], 8);
+    EXPECT_GT(logs[0x100], 10);
+}
+
+TEST_F(_6502NetworkTests, ResultDoesNotDependOnThreadsOrRuns) {
+    const std::vector<m6502::byte> expected = Ring(6, {20000}, 1);
+    EXPECT_EQ(Ring(6, {20000}, 2), expected);
+    EXPECT_EQ(Ring(6, {20000}, 4), expected);
+    EXPECT_EQ(Ring(6, {20000}, 6), expected);
+    EXPECT_EQ(Ring(6, {7000, 13, 12987}, 3), expected);
+}
+
+TEST_F(_6502NetworkTests, NodesWithoutLinksRunInOneWindow) {
+    auto first = MakeNode({CPU::INS_JMP_ABS, 0x00, 0x80}, {});
+    auto second = MakeNode({CPU::INS_JMP_ABS, 0x00, 0x80}, {});
+    m6502::Network network;
+    network.add(*first);
+    network.add(*second);
+    network.run(3000, 2);
+
+    EXPECT_EQ(network.getLookahead(), 0u);
+    EXPECT_EQ(network.getStats().windows, 1u);
+    EXPECT_EQ(network.getStats().threads, 2u);
+    EXPECT_EQ(network.getStats().cycles, 6000u);
+    EXPECT_EQ(network.now(), 3000u);
+}
@@ -0,0 +1,62 @@
+#include "gtest/gtest.h"
+#include "6502Numa.h"
+#include <cstdlib>
+#include <fstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class _6502NumaTests : public testing::Test {
+public:
+    std::string directory;
+    std::vector<std::string> nodes;
+    virtual void SetUp() {
+        char name[] = "/tmp/6502NumaXXXXXX";
+        directory = mkdtemp(name);
+    }
+    virtual void TearDown() {
+        for (const std::string& node : nodes) {
+            unlink((node + "/cpulist").c_str());
+            rmdir(node.c_str());
+        }
+        rmdir(directory.c_str());
+    }
+
+    void AddNode(const std::string& name, const std::string& cpulist) {
+        nodes.push_back(directory + "/" + name);
+        mkdir(nodes.back().c_str(), 0700);
+        std::ofstream{directory + "/" + name + "/cpulist"} << cpulist << "\n";
+    }
+};
+
+TEST_F(_6502NumaTests, ParsesCPULists) {
+    EXPECT_EQ(m6502::NumaTopology::parseCPUList("0-3,8,10-11"), (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(m6502::NumaTopology::parseCPUList("5"), (std::vector<int>{5}));
+    EXPECT_TRUE(m6502::NumaTopology::parseCPUList("").empty());
+}
+
+TEST_F(_6502NumaTests, DetectsNodesFromSysfs) {
+    AddNode("node1", "4-7");
+    AddNode("node0", "0-3");
+    AddNode("node2", "");       //memory only
+    AddNode("nodes", "9");      //not a node
+    auto topology = m6502::NumaTopology::detect(directory);
+    ASSERT_EQ(topology.size(), 2u);
+    EXPECT_EQ(topology.getNodes()[0].id, 0);
+    EXPECT_EQ(topology.getNodes()[0].cpus, (std::vector<int>{0, 1, 2, 3}));
+    EXPECT_EQ(topology.getNodes()[1].id, 1);
+    EXPECT_EQ(topology.getNodes()[1].cpus, (std::vector<int>{4, 5, 6, 7}));
+}
+
+TEST_F(_6502NumaTests, WithoutSysfsEverythingIsOneNode) {
+    auto topology = m6502::NumaTopology::detect(directory + "/missing");
+    ASSERT_EQ(topology.size(), 1u);
+    EXPECT_EQ(topology.getNodes()[0].id, 0);
+    EXPECT_FALSE(topology.getNodes()[0].cpus.empty());
+}
+
+TEST_F(_6502NumaTests, UnknownAddressesHaveNoNode) {
+    int local{0};
+    auto nodes = m6502::NumaTopology::nodesOf({&local, nullptr});
+    ASSERT_EQ(nodes.size(), 2u);
+    EXPECT_EQ(nodes[1], -1);
+}
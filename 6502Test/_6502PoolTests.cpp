@@ -0,0 +1,89 @@
+#include "gtest/gtest.h"
+#include "6502Pool.h"
+#include <vector>
+
+class _6502PoolTests : public testing::Test {
+public:
+    m6502::VirtualClock clock;
+    virtual void SetUp() {}
+    virtual void TearDown() {}
+};
+
+TEST_F(_6502PoolTests, ReleasedCPUsComeBackReset) {
+    m6502::CPUPool pool{clock};
+    m6502::CPU* cpu = pool.acquire();
+    cpu->mem[0xFFFC] = 0x00;
+    cpu->mem[0xFFFD] = 0x80;
+    cpu->mem[0x8000] = m6502::CPU::INS_LDA_IM;
+    cpu->mem[0x8001] = 0x42;
+    cpu->reset();
+    cpu->execute(1);
+    EXPECT_EQ(cpu->A, 0x42);
+    pool.release(cpu);
+
+    m6502::CPU* again = pool.acquire();
+    EXPECT_EQ(again, cpu);
+    EXPECT_EQ(again->A, 0);
+    EXPECT_EQ(again->PC, 0x0000);
+    EXPECT_EQ(again->SP, 0xFF);
+    EXPECT_EQ(again->mem.read(0x8000), 0);
+    EXPECT_EQ(again->mem.usedPages().count(), 0u);
+    pool.release(again);
+}
+
+TEST_F(_6502PoolTests, ReleasedCPUsComeBackWithoutDevicesSharedRamOrInterrupts) {
+    struct Silent : m6502::Bus {
+        m6502::byte read(m6502::word) override { return 0xEE; }
+        void write(m6502::word, m6502::byte) override {}
+    };
+    m6502::CPUPool pool{clock};
+    m6502::CPU* cpu = pool.acquire();
+    {
+        Silent bus;
+        m6502::SharedRam ram{0x4000, 0x100};
+        cpu->mem.map(ram);
+        cpu->mem.map(bus, 0xD0, 1);
+        cpu->mem.write(0x4000, 0x42);
+        cpu->irq(true);
+        cpu->nmi();
+        pool.release(cpu);
+    }
+
+    m6502::CPU* again = pool.acquire();
+    EXPECT_EQ(again, cpu);
+    EXPECT_EQ(again->interrupts, 0);
+    EXPECT_EQ(again->mem.getBus(), nullptr);
+    EXPECT_FALSE(again->mem.isMapped(0xD0));
+    EXPECT_FALSE(again->mem.isPinned(0x40));
+    EXPECT_EQ(again->mem.read(0x4000), 0);
+    EXPECT_EQ(again->mem.usedPages().count(), 0u);
+    pool.release(again);
+}
+
+TEST_F(_6502PoolTests, ArenasGrowAndStatsFollow) {
+    m6502::CPUPool pool{clock};
+    std::vector<m6502::CPU*> cpus;
+    for (int i{0}; i < 1000; ++i) {
+        cpus.push_back(pool.acquire());
+        cpus.back()->mem.write(static_cast<m6502::word>(i), 1);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(cpus.back()) % 64, 0u);
+    }
+    const m6502::CPUPool::Stats& stats = pool.getStats();
+    EXPECT_EQ(stats.inUse, 1000u);
+    EXPECT_EQ(stats.peakInUse, 1000u);
+    EXPECT_EQ(stats.acquires, 1000u);
+    EXPECT_GE(stats.capacity, 1000u);
+    EXPECT_EQ(stats.capacity % stats.arenas, 0u);
+    EXPECT_LT(stats.capacity - 1000u, stats.capacity / stats.arenas);
+    EXPECT_LE(stats.hugeArenas + stats.advisedArenas, stats.arenas);
+    EXPECT_GE(stats.maxAcquireNanoseconds * stats.acquires, stats.acquireNanoseconds);
+
+    for (size_t i{0}; i < 500; ++i) pool.release(cpus[i]);
+    EXPECT_EQ(stats.inUse, 500u);
+    EXPECT_EQ(stats.peakInUse, 1000u);
+    EXPECT_DOUBLE_EQ(stats.occupancy(), 500.0 / stats.capacity);
+    const size_t arenas = stats.arenas;
+    for (size_t i{0}; i < 500; ++i) cpus[i] = pool.acquire();
+    EXPECT_EQ(stats.arenas, arenas);
+    for (m6502::CPU* cpu : cpus) pool.release(cpu);
+}
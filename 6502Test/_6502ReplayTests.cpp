@@ -0,0 +1,199 @@
+#include "gtest/gtest.h"
+#include "6502Devices.h"
+#include "6502Replay.h"
+#include <random>
+#include <sstream>
+
+class _6502ReplayTests : public testing::Test {
+public:
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+
+    virtual void SetUp() {
+        cpu.reset();
+        LoadProgram(cpu);
+    }
+    virtual void TearDown() {}
+
+    //loop: LDA $0200; EOR $10; STA $10; PHA; TSX; STA $4000,X; JMP loop, folding the input at $0200 into $10
+    static void LoadProgram(m6502::CPU& cpu) {
+        const m6502::byte program[] {
+                m6502::CPU::INS_LDA_ABS, 0x00, 0x02,
+                m6502::CPU::INS_EOR_ZP, 0x10,
+                m6502::CPU::INS_STA_ZP, 0x10,
+                m6502::CPU::INS_PHA_IMP, 0x00,
+                m6502::CPU::INS_TSX_IMP, 0x00,
+                m6502::CPU::INS_STA_ABSX, 0x00, 0x40,
+                m6502::CPU::INS_JMP_ABS, 0x00, 0x80};
+        for (size_t i{0}; i < sizeof program; ++i)
+            cpu.mem[0x8000 + i] = program[i];
+        cpu.PC = 0x8000;
+    }
+
+    //a session with inputs at random times
+    static void Record(m6502::InputRecorder& recorder, int inputs) {
+        std::mt19937 random{42};
+        for (int i{0}; i < inputs; ++i) {
+            recorder.run(random() % 500);
+            recorder.write(0x0200, static_cast<m6502::byte>(random()));
+        }
+        recorder.run(1000);
+        recorder.finish();
+    }
+
+    static void ExpectSameState(m6502::CPU& a, m6502::CPU& b) {
+        EXPECT_EQ(a.PC, b.PC);
+        EXPECT_EQ(a.SP, b.SP);
+        EXPECT_EQ(a.A, b.A);
+        EXPECT_EQ(a.X, b.X);
+        EXPECT_EQ(a.Y, b.Y);
+        EXPECT_EQ(a.PS, b.PS);
+        EXPECT_EQ(a.interrupts, b.interrupts);
+        EXPECT_TRUE(a.mem == b.mem);
+    }
+};
+
+TEST_F(_6502ReplayTests, ReplayEndsInTheRecordedState) {
+    std::stringstream log;
+    m6502::InputRecorder recorder{cpu, log};
+    Record(recorder, 1000);
+    EXPECT_EQ(recorder.getStats().events, 1001u);
+    EXPECT_EQ(recorder.getStats().bytes, log.str().size());
+
+    m6502::CPU replayed{clock};
+    m6502::InputReplayer replayer{replayed, log};
+    ASSERT_TRUE(replayer.run());
+    EXPECT_EQ(replayer.now(), recorder.now());
+    EXPECT_EQ(replayer.getStats().events, 1001u);
+    ExpectSameState(replayed, cpu);
+}
+
+TEST_F(_6502ReplayTests, ReplaysASessionDrivenByATimerInterruptWithoutTheTimer) {
+    //asserts IRQ at uneven intervals until its count is read, with an NMI every third time
+    struct Timer : m6502::Device, m6502::EventQueue::Handler {
+        m6502::CPU& cpu;
+        m6502::byte expiries{0};
+        explicit Timer(m6502::CPU& cpu) : cpu(cpu) {}
+        void advance(uint64_t, uint64_t) override {}
+        m6502::byte read(m6502::word) override {
+            cpu.irq(false);
+            return expiries;
+        }
+        void write(m6502::word, m6502::byte) override {}
+        void onEvent(m6502::EventQueue& queue, uint64_t cycle) override {
+            expiries++;
+            cpu.irq(true);
+            if (expiries % 3 == 0) cpu.nmi();
+            queue.schedule(*this, cycle + 97 + expiries % 13 * 11);
+        }
+    } timer{cpu};
+    m6502::EventQueue queue;
+    m6502::Devices devices{queue};
+    devices.add(timer, 0xD000, 1);
+    devices.attach(cpu.mem);
+    queue.schedule(timer, 150);
+    //IRQ: PHA; LDA $D000; STA $20; PLA; RTI   NMI: PHA; LDA $10; STA $21; PLA; RTI
+    const m6502::byte irq[] {
+            m6502::CPU::INS_PHA_IMP, 0x00, m6502::CPU::INS_LDA_ABS, 0x00, 0xD0, m6502::CPU::INS_STA_ZP, 0x20,
+            m6502::CPU::INS_PLA_IMP, 0x00, m6502::CPU::INS_RTI};
+    const m6502::byte nmi[] {
+            m6502::CPU::INS_PHA_IMP, 0x00, m6502::CPU::INS_LDA_ZP, 0x10, m6502::CPU::INS_STA_ZP, 0x21,
+            m6502::CPU::INS_PLA_IMP, 0x00, m6502::CPU::INS_RTI};
+    for (size_t i{0}; i < sizeof irq; ++i)
+        cpu.mem[0x9000 + i] = irq[i];
+    for (size_t i{0}; i < sizeof nmi; ++i)
+        cpu.mem[0x9100 + i] = nmi[i];
+    cpu.mem[0xFFFA] = 0x00;
+    cpu.mem[0xFFFB] = 0x91;
+    cpu.mem[0xFFFE] = 0x00;
+    cpu.mem[0xFFFF] = 0x90;
+
+    std::stringstream log;
+    m6502::InputRecorder recorder{cpu, log, &queue};
+    Record(recorder, 300);
+    EXPECT_GT(timer.expiries, 100);
+    EXPECT_EQ(cpu.mem[0x20], timer.expiries);
+    EXPECT_EQ(cpu.mem.getBus(), &devices);
+    //reads, IRQs up and down and NMIs on top of the host's writes
+    EXPECT_GT(recorder.getStats().events, 301u + 3u * timer.expiries);
+
+    m6502::CPU replayed{clock};
+    m6502::InputReplayer replayer{replayed, log};
+    ASSERT_TRUE(replayer.run());
+    EXPECT_EQ(replayer.now(), recorder.now());
+    EXPECT_EQ(replayer.getStats().events, recorder.getStats().events);
+    ExpectSameState(replayed, cpu);
+    EXPECT_EQ(replayed.mem.getBus(), nullptr);
+}
+
+TEST_F(_6502ReplayTests, LeavesDevicesAndSharedRamOutOfTheState) {
+    //counts what reaches it
+    struct Counter : m6502::Bus {
+        int writes{0};
+        m6502::byte read(m6502::word) override { return 0; }
+        void write(m6502::word, m6502::byte) override { writes++; }
+    } recorded, own;
+    m6502::SharedRam recordedRam{0x6000, 0x100}, ownRam{0x6000, 0x100};
+    cpu.mem.map(recordedRam);
+    cpu.mem[0x6000] = 0x55;
+    cpu.mem.map(recorded, 0xD0, 1);
+    std::stringstream log;
+    m6502::InputRecorder recorder{cpu, log};
+    //the magic, the registers, the device page bitmap, the page count and the program's page
+    EXPECT_EQ(recorder.getStats().bytes, 8u + 8u + 32u + 2u + 257u);
+    Record(recorder, 10);
+
+    m6502::CPU replayed{clock};
+    replayed.mem.map(ownRam);
+    replayed.mem[0x6000] = 0x77;
+    replayed.mem.map(own, 0xD0, 1);
+    m6502::InputReplayer replayer{replayed, log};
+    ASSERT_TRUE(replayer.run());
+    EXPECT_EQ(own.writes, 0);
+    EXPECT_EQ(replayed.mem[0x6000], 0x77);
+    EXPECT_EQ(replayed.mem.getBus(), &own);
+    EXPECT_EQ(replayed.A, cpu.A);
+    EXPECT_EQ(replayed.mem[0x10], cpu.mem[0x10]);
+}
+
+TEST_F(_6502ReplayTests, EventsTakeAFewBytes) {
+    std::stringstream log;
+    m6502::InputRecorder recorder{cpu, log};
+    const size_t header = recorder.getStats().bytes;
+    Record(recorder, 1000);
+    //under 500 cycles apart, two bytes of delta, a kind, an address and a value
+    EXPECT_LE(recorder.getStats().bytes - header, 1001u * 6);
+}
+
+TEST_F(_6502ReplayTests, ReplayDoesNotWaitForAPacedClock) {
+    m6502::CPU paced{0.5};
+    paced.reset();
+    LoadProgram(paced);
+    std::stringstream log;
+    m6502::InputRecorder recorder{paced, log};
+    Record(recorder, 20);   //about 6000 cycles, 12 ms at 0.5 MHz
+
+    m6502::CPU replayed{0.5};
+    m6502::InputReplayer replayer{replayed, log};
+    ASSERT_TRUE(replayer.run());
+    ExpectSameState(replayed, paced);
+    EXPECT_EQ(&replayed.cycles.getClock(), replayed.ownedClock.get());
+}
+
+TEST_F(_6502ReplayTests, DamagedLogsFail) {
+    std::stringstream log;
+    m6502::InputRecorder recorder{cpu, log};
+    Record(recorder, 100);
+    const std::string bytes = log.str();
+
+    m6502::CPU replayed{clock};
+    std::stringstream truncated{bytes.substr(0, bytes.size() - 3)};
+    EXPECT_FALSE(m6502::InputReplayer(replayed, truncated).run());
+    std::stringstream garbage{"not a log"};
+    EXPECT_FALSE(m6502::InputReplayer(replayed, garbage).run());
+    //an unknown event kind
+    std::string changed = bytes;
+    changed[changed.size() - 1] = 0x42;
+    std::stringstream unknown{changed};
+    EXPECT_FALSE(m6502::InputReplayer(replayed, unknown).run());
+}
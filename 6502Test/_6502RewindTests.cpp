@@ -0,0 +1,108 @@
+#include "gtest/gtest.h"
+#include "6502Rewind.h"
+
+class _6502RewindTests : public testing::Test {
+public:
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+
+    virtual void SetUp() {
+        cpu.reset();
+        LoadProgram(cpu);
+    }
+    virtual void TearDown() {}
+
+    //loop: EOR #$01; PHA; TSX; STA $4000,X; JMP loop
+    static void LoadProgram(m6502::CPU& cpu) {
+        const m6502::byte program[] {
+                m6502::CPU::INS_EOR_IM, 0x01,
+                m6502::CPU::INS_PHA_IMP, 0x00,
+                m6502::CPU::INS_TSX_IMP, 0x00,
+                m6502::CPU::INS_STA_ABSX, 0x00, 0x40,
+                m6502::CPU::INS_JMP_ABS, 0x00, 0x80};
+        for (size_t i{0}; i < sizeof program; ++i)
+            cpu.mem[0x8000 + i] = program[i];
+        cpu.PC = 0x8000;
+    }
+
+    //the same program run without a rewinder from now up to the end of the instruction running at cycle
+    static void RunTo(m6502::CPU& reference, uint64_t& now, uint64_t cycle) {
+        while (now < cycle)
+            now += reference.execute(UINT64_MAX, static_cast<m6502::sdword>(cycle - now));
+    }
+
+    static void ExpectSameState(m6502::CPU& a, m6502::CPU& b) {
+        EXPECT_EQ(a.PC, b.PC);
+        EXPECT_EQ(a.SP, b.SP);
+        EXPECT_EQ(a.A, b.A);
+        EXPECT_EQ(a.X, b.X);
+        EXPECT_EQ(a.Y, b.Y);
+        EXPECT_EQ(a.PS, b.PS);
+        EXPECT_TRUE(a.mem == b.mem);
+    }
+};
+
+TEST_F(_6502RewindTests, RewindReachesAnyEarlierCycle) {
+    const std::vector<m6502::CPU> start = cpu.fork(1);
+    m6502::Rewinder rewinder{cpu, 1 << 20, 1000};
+    const uint64_t ran = rewinder.run(50000);
+    EXPECT_EQ(ran, rewinder.now());
+    EXPECT_GE(rewinder.now(), 50000u);
+    EXPECT_EQ(rewinder.earliest(), 0u);
+
+    for (uint64_t target : {49000u, 12345u, 30001u, 0u, 999u, 1000u}) {
+        ASSERT_TRUE(rewinder.rewindTo(target));
+        EXPECT_LT(rewinder.getStats().replayedCycles, 1000u + 8);
+        m6502::CPU reference = start[0];
+        uint64_t now{0};
+        RunTo(reference, now, target);
+        EXPECT_EQ(rewinder.now(), now);
+        ExpectSameState(cpu, reference);
+        //and forward again from there
+        rewinder.run(20000);
+        RunTo(reference, now, rewinder.now());
+        EXPECT_EQ(rewinder.now(), now);
+        ExpectSameState(cpu, reference);
+    }
+}
+
+TEST_F(_6502RewindTests, RewindingDropsTheFuture) {
+    m6502::Rewinder rewinder{cpu, 1 << 20, 1000};
+    rewinder.run(10000);
+    const size_t before = rewinder.getStats().snapshots;
+    const uint64_t end = rewinder.now();
+    ASSERT_TRUE(rewinder.rewindTo(4500));
+    EXPECT_EQ(rewinder.getStats().snapshots, 5u);
+    EXPECT_LT(rewinder.getStats().snapshots, before);
+    EXPECT_FALSE(rewinder.rewindTo(end));
+    EXPECT_GE(rewinder.now(), 4500u);
+}
+
+TEST_F(_6502RewindTests, OldSnapshotsGoOnceOverBudget) {
+    //every interval writes the same two pages, so all snapshots but the last cost the same
+    m6502::CPU copy = cpu.fork(1)[0];
+    m6502::Rewinder unbounded{copy, SIZE_MAX, 1000};
+    unbounded.run(10000);
+    const size_t each = unbounded.getStats().bytes / unbounded.getStats().snapshots;
+
+    m6502::Rewinder rewinder{cpu, 10 * each, 1000};
+    rewinder.run(100000);
+    const m6502::Rewinder::Stats& stats = rewinder.getStats();
+    EXPECT_LE(stats.bytes, 10 * each);
+    EXPECT_GT(stats.dropped, 80u);
+    EXPECT_GE(stats.snapshots, 9u);
+    EXPECT_LE(stats.snapshots, 11u);
+    EXPECT_GT(rewinder.earliest(), 88000u);
+    EXPECT_FALSE(rewinder.rewindTo(1000));
+    EXPECT_TRUE(rewinder.rewindTo(rewinder.earliest()));
+}
+
+TEST_F(_6502RewindTests, RunStopsOnAnUnhandledOpcode) {
+    cpu.mem[0x8009] = 0x02;
+    m6502::Rewinder rewinder{cpu, 1 << 20, 1000};
+    EXPECT_LT(rewinder.run(50000), 50000u);
+    EXPECT_TRUE(rewinder.isStopped());
+    ASSERT_TRUE(rewinder.rewindTo(2));
+    EXPECT_FALSE(rewinder.isStopped());
+    EXPECT_EQ(cpu.PC, 0x8002);
+}
@@ -0,0 +1,39 @@
+#include "gtest/gtest.h"
+#include "6502.h"
+
+class _6502RunTests : public testing::Test {
+public:
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+    virtual void SetUp() {
+        cpu.reset();
+        cpu.PC = 0xFFFC;
+    }
+    virtual void TearDown() {}
+};
+
+TEST_F(_6502RunTests, RunFinishesTheInstructionThatReachesItsCyclesAndStopsOnAnInvalidOne) {
+    cpu.mem[0xFFFC] = m6502::CPU::INS_LDA_IM;
+    cpu.mem[0xFFFD] = 0x42;
+    cpu.mem[0xFFFE] = m6502::CPU::INS_LDX_IM;
+    cpu.mem[0xFFFF] = 0x24;
+    cpu.mem[0x0000] = m6502::CPU::INS_JAM;
+    bool stopped{false};
+    EXPECT_EQ(cpu.run(3, stopped), 4u);
+    EXPECT_FALSE(stopped);
+    EXPECT_EQ(cpu.instructionsExecuted, 2u);
+    EXPECT_EQ(cpu.run(100, stopped), 1u);
+    EXPECT_TRUE(stopped);
+    EXPECT_EQ(cpu.run(100, stopped), 0u);
+    EXPECT_EQ(cpu.A, 0x42);
+    EXPECT_EQ(cpu.X, 0x24);
+}
+
+TEST_F(_6502RunTests, RunStopsOnAnInvalidOpcodeWhoseFetchUsesUpItsCycles) {
+    cpu.mem[0xFFFC] = m6502::CPU::INS_JAM;
+    bool stopped{false};
+    EXPECT_EQ(cpu.run(1, stopped), 1u);
+    EXPECT_TRUE(stopped);
+    EXPECT_TRUE(cpu.halted);
+    EXPECT_EQ(cpu.instructionsExecuted, 0u);
+}
@@ -0,0 +1,113 @@
+#include "gtest/gtest.h"
+#include "6502Scheduler.h"
+#include <memory>
+#include <vector>
+
+class _6502SchedulerTests : public testing::Test {
+public:
+    m6502::VirtualClock clock;
+    virtual void SetUp() {}
+    virtual void TearDown() {}
+
+    //LDA $10; STA $0200,X; LDX $11; JMP $8000 over its own input, writing pages 2 to 2 + pages - 1
+    std::unique_ptr<m6502::CPU> MakeCPU(m6502::byte input, m6502::byte pages = 1) {
+        std::unique_ptr<m6502::CPU> cpu{new m6502::CPU{clock}};
+        const m6502::byte program[] {
+                m6502::CPU::INS_LDA_ZP, 0x10,
+                m6502::CPU::INS_STA_ABSX, 0x00, 0x02,
+                m6502::CPU::INS_LDX_ZP, 0x11,
+                m6502::CPU::INS_JMP_ABS, 0x00, 0x80};
+        for (size_t i{0}; i < sizeof program; ++i)
+            cpu->mem[0x8000 + i] = program[i];
+        cpu->mem[0x10] = input;
+        cpu->mem[0x11] = input;
+        for (m6502::byte page{0}; page < pages; ++page)
+            cpu->mem[0x0200 + page * 0x100] = 1;
+        cpu->PC = 0x8000;
+        return cpu;
+    }
+};
+
+TEST_F(_6502SchedulerTests, ExecuteStopsAtTheCycleBudget) {
+    auto cpu = MakeCPU(1);
+    //LDA zp is 3 cycles, STA abs,X 5, LDX zp 3, JMP 3
+    EXPECT_EQ(cpu->execute(UINT64_MAX, 7), 8u);
+    EXPECT_EQ(cpu->instructionsExecuted, 2u);
+    EXPECT_EQ(cpu->execute(UINT64_MAX, 1), 3u);
+    EXPECT_EQ(cpu->instructionsExecuted, 1u);
+    EXPECT_EQ(cpu->execute(2, 1000), 6u);
+    EXPECT_EQ(cpu->instructionsExecuted, 2u);
+}
+
+TEST_F(_6502SchedulerTests, QuantaAddUpToOneLongRun) {
+    std::vector<std::unique_ptr<m6502::CPU>> cpus, alone;
+    m6502::Scheduler scheduler;
+    for (m6502::byte i{0}; i < 10; ++i) {
+        cpus.push_back(MakeCPU(i));
+        alone.push_back(MakeCPU(i));
+        scheduler.add(*cpus.back());
+    }
+    //overshoots carry over from one run to the next
+    scheduler.run(12345);
+    scheduler.run(6789);
+    EXPECT_GE(scheduler.getStats().fairness, 0.999);
+    EXPECT_GE(scheduler.getStats().quanta, 10u * 6789 / m6502::Scheduler::MIN_QUANTUM);
+    EXPECT_LE(scheduler.getStats().maxWaitCycles, 10u * (m6502::Scheduler::MIN_QUANTUM + 5));
+    for (size_t i{0}; i < cpus.size(); ++i) {
+        EXPECT_EQ(scheduler.getCycles(i), alone[i]->execute(UINT64_MAX, 12345 + 6789));
+        EXPECT_FALSE(scheduler.isStopped(i));
+        EXPECT_EQ(cpus[i]->PC, alone[i]->PC);
+        EXPECT_EQ(cpus[i]->A, alone[i]->A);
+        EXPECT_EQ(cpus[i]->X, alone[i]->X);
+        EXPECT_TRUE(cpus[i]->mem == alone[i]->mem);
+    }
+}
+
+TEST_F(_6502SchedulerTests, QuantaGrowWithFootprintOnceTheCacheIsFull) {
+    std::vector<std::unique_ptr<m6502::CPU>> cpus;
+    m6502::Scheduler roomy{64 * 1024 * 1024}, tight{16 * 1024};
+    for (m6502::byte i{0}; i < 8; ++i) {
+        cpus.push_back(MakeCPU(i, static_cast<m6502::byte>(1 + i * 8)));
+        roomy.add(*cpus.back());
+        tight.add(*cpus.back());
+    }
+    roomy.run(1);
+    tight.run(1);
+    EXPECT_EQ(roomy.getStats().footprintBytes, tight.getStats().footprintBytes);
+    EXPECT_GT(tight.getStats().footprintBytes, 16u * 1024);
+    for (size_t i{0}; i < cpus.size(); ++i) {
+        EXPECT_EQ(roomy.getQuantum(i), m6502::Scheduler::MIN_QUANTUM);
+        if (i > 0) {
+            EXPECT_GT(tight.getQuantum(i), tight.getQuantum(i - 1));
+        }
+    }
+}
+
+TEST_F(_6502SchedulerTests, SharedRomPagesCountOnce) {
+    std::vector<m6502::byte> image(0x1000, 0xEA);
+    m6502::Rom rom{0xC000, image.data(), image.size()};
+    std::vector<std::unique_ptr<m6502::CPU>> cpus;
+    m6502::Scheduler scheduler;
+    for (m6502::byte i{0}; i < 4; ++i) {
+        cpus.push_back(MakeCPU(i));
+        cpus.back()->mem.map(rom);
+        scheduler.add(*cpus.back());
+    }
+    scheduler.run(1);
+    //own pages: zero page, page 2 and the program
+    EXPECT_EQ(scheduler.getStats().footprintBytes, 4 * (3 * m6502::Page::SIZE + sizeof(m6502::CPU)) + 16 * m6502::Page::SIZE);
+}
+
+TEST_F(_6502SchedulerTests, StoppedInstancesAreLeftOut) {
+    auto running = MakeCPU(1), stopping = MakeCPU(2);
+    stopping->mem[0x8005] = 0x02;
+    m6502::Scheduler scheduler;
+    scheduler.add(*running);
+    scheduler.add(*stopping);
+    scheduler.run(5000);
+    EXPECT_FALSE(scheduler.isStopped(0));
+    EXPECT_TRUE(scheduler.isStopped(1));
+    EXPECT_EQ(scheduler.getCycles(1), 3u + 5u + 1u);
+    EXPECT_GE(scheduler.getCycles(0), 5000u);
+    EXPECT_DOUBLE_EQ(scheduler.getStats().fairness, 1.0);
+}
@@ -0,0 +1,85 @@
+#include "gtest/gtest.h"
+#include "6502.h"
+
+class _6502SnapshotTests : public testing::Test {
+public:
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
+
+    virtual void SetUp() {
+        cpu.reset();
+        cpu.PC = 0xFFFC;
+    }
+    virtual void TearDown() {}
+
+    //LDA $10; STA $0200; PHA; STA ($20),Y
+    void LoadProgram() {
+        const m6502::byte program[] {
+                m6502::CPU::INS_LDA_ZP, 0x10,
+                m6502::CPU::INS_STA_ABS, 0x00, 0x02,
+                m6502::CPU::INS_PHA_IMP, 0x00,
+                m6502::CPU::INS_STA_INDY, 0x20};
+        for (size_t i{0}; i < sizeof program; ++i)
+            cpu.mem[0x8000 + i] = program[i];
+        cpu.mem[0x10] = 0x5A;
+        cpu.mem[0x20] = 0x00;
+        cpu.mem[0x21] = 0x40;
+        cpu.PC = 0x8000;
+    }
+};
+
+TEST_F(_6502SnapshotTests, RestoreUndoesRegistersAndMemory) {
+    LoadProgram();
+    cpu.X = 0x11;
+    cpu.PS.set(m6502::CPU::StatusFlags::C);
+    m6502::Memory before{cpu.mem};
+    m6502::CPU::Snapshot snapshot = cpu.snapshot();
+
+    cpu.execute(4);
+    EXPECT_EQ(cpu.mem.read(0x0200), 0x5A);
+    EXPECT_EQ(cpu.mem.read(0x4000), 0x5A);
+    EXPECT_EQ(cpu.mem.dirtyPages().count(), 3u);
+
+    cpu.restore(snapshot);
+    EXPECT_EQ(cpu.PC, 0x8000);
+    EXPECT_EQ(cpu.A, 0);
+    EXPECT_EQ(cpu.X, 0x11);
+    EXPECT_EQ(cpu.SP, 0xFF);
+    EXPECT_TRUE(cpu.PS.test(m6502::CPU::StatusFlags::C));
+    EXPECT_TRUE(cpu.mem == before);
+    EXPECT_EQ(cpu.mem.usedPages().count(), before.usedPages().count());
+    EXPECT_EQ(cpu.mem.dirtyPages().count(), 0u);
+
+    //and again, from the same snapshot
+    cpu.execute(4);
+    cpu.restore(snapshot);
+    EXPECT_TRUE(cpu.mem == before);
+    EXPECT_EQ(cpu.PC, 0x8000);
+}
+
+TEST_F(_6502SnapshotTests, OlderSnapshotsRestoreEveryPage) {
+    LoadProgram();
+    m6502::Memory atFirst{cpu.mem};
+    m6502::CPU::Snapshot first = cpu.snapshot();
+    cpu.execute(2);
+    m6502::Memory atSecond{cpu.mem};
+    m6502::CPU::Snapshot second = cpu.snapshot();
+    cpu.execute(2);
+
+    cpu.restore(first);
+    EXPECT_TRUE(cpu.mem == atFirst);
+    EXPECT_EQ(cpu.mem.read(0x0200), 0);
+    cpu.restore(second);
+    EXPECT_TRUE(cpu.mem == atSecond);
+    EXPECT_EQ(cpu.mem.read(0x0200), 0x5A);
+    EXPECT_EQ(cpu.PC, 0x8005);
+}
+
+TEST_F(_6502SnapshotTests, SnapshotsStayPutWhileTheCPURuns) {
+    LoadProgram();
+    m6502::CPU::Snapshot snapshot = cpu.snapshot();
+    cpu.execute(4);
+    EXPECT_EQ(snapshot.mem.read(0x0200), 0);
+    EXPECT_EQ(snapshot.mem.read(0x8000), m6502::byte{m6502::CPU::INS_LDA_ZP});
+    EXPECT_EQ(snapshot.PC, 0x8000);
+}
@@ -3,7 +3,8 @@
 
 class _6502StackOperationTests : public testing::Test {
 public:
-    m6502::CPU cpu{.01};
+    m6502::VirtualClock clock;
+    m6502::CPU cpu{clock};
     virtual void SetUp() {
         cpu.reset();
         cpu.PC = 0xFFFC;